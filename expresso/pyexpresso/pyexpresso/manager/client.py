@@ -6,6 +6,41 @@ import json
 import socket
 import struct
 
+# Maximum number of queries per BFND frame. A v1 frame carries at most 255
+# arguments, each query taking 4 of them
+BATCH_SIZE = 63
+
+# Number of queries per BFND frame with v2 framing, which has no limit on
+# the number of arguments
+BATCH_SIZE_V2 = 1024
+
+# Marker leading a v2 frame, in place of the mode of a v1 frame
+FRAME_V2 = 0x7F
+
+# Flag set on the mode of a v2 frame to request a binary response
+MODE_BINARY = 0x40
+
+# Kinds of binary responses, leading their body. A json response always
+# starts with '{' instead
+BINARY_ERROR = 0
+BINARY_PATH = 1
+BINARY_PATHS = 2
+BINARY_APPROXIMATE_PATH = 3
+
+# Types of argument values in a v2 frame
+FRAME_INT = 0
+FRAME_STR = 1
+FRAME_DBL = 2
+
+# Flag set on mode to tag a command with a request id, and on the length of
+# the response to a tagged command
+MODE_TAGGED = 0x80
+LENGTH_TAGGED = 0x80000000
+
+# Maximum number of tagged commands sent ahead of their responses. Matches
+# the number of commands fletcher executes at once per connection
+PIPELINE_WINDOW = 128
+
 
 def number_to_bytes(number):
     '''
@@ -64,24 +99,216 @@ def command_to_bytes(mode, command, **kwargs):
         number_to_bytes(len(kwargs)) + kwargs_to_bytes(kwargs))
 
 
+def tagged_command_to_bytes(mode, command, request_id, **kwargs):
+    '''
+    Converts a mode, command and named argument combination to re-bar
+    supported protocol, tagged with a request id
+    '''
+    return (
+        number_to_bytes(mode | MODE_TAGGED) + keyword_to_bytes(command) +
+        number_to_bytes(len(kwargs)) + struct.pack('<I', request_id) +
+        kwargs_to_bytes(kwargs))
+
+
+def varint_to_bytes(number):
+    '''
+    Convert a non negative number to bytes as an unsigned LEB128 varint
+    '''
+    data = b''
+
+    while number >= 0x80:
+        data += struct.pack('B', (number & 0x7F) | 0x80)
+        number >>= 7
+    return data + struct.pack('B', number)
+
+
+def token_to_bytes(token):
+    '''
+    Converts a string to bytes with a varint prefix specifying its length
+    '''
+    token = keyword_to_bytes(token)
+    return varint_to_bytes(len(token)) + token
+
+
+def kwargs_to_bytes_v2(kwargs):
+    '''
+    Convert a map of named arguments to v2 framing, with binary numbers
+    '''
+    data = b''
+
+    for key, value in kwargs.items():
+
+        if isinstance(value, int):
+            data += struct.pack('B', FRAME_INT) + token_to_bytes(key)
+            data += struct.pack('<q', value)
+        elif isinstance(value, str) or isinstance(value, unicode):
+            data += struct.pack('B', FRAME_STR) + token_to_bytes(key)
+            data += token_to_bytes(value)
+        else:
+            data += struct.pack('B', FRAME_DBL) + token_to_bytes(key)
+            data += struct.pack('<d', value)
+    return data
+
+
+def command_to_bytes_v2(mode, command, request_id=None, **kwargs):
+    '''
+    Converts a mode, command and named argument combination to a v2 frame,
+    tagged with a request id if provided
+    '''
+    if request_id is None:
+        body = number_to_bytes(mode) + keyword_to_bytes(command)
+    else:
+        body = (
+            number_to_bytes(mode | MODE_TAGGED) + keyword_to_bytes(command) +
+            struct.pack('<I', request_id))
+    body += varint_to_bytes(len(kwargs)) + kwargs_to_bytes_v2(kwargs)
+    return number_to_bytes(FRAME_V2) + struct.pack('<I', len(body)) + body
+
+
+def bytes_to_varint(data, offset):
+    '''
+    Reads an unsigned LEB128 varint from data at offset
+    Returns the number and the offset past it
+    '''
+    number = 0
+    shift = 0
+
+    while True:
+        byte = struct.unpack_from('B', data, offset)[0]
+        offset += 1
+        number |= (byte & 0x7F) << shift
+        shift += 7
+
+        if not byte & 0x80:
+            return number, offset
+
+
+def bytes_to_token(data, offset):
+    '''
+    Reads a string prefixed with a varint length from data at offset
+    Returns the string and the offset past it
+    '''
+    length, offset = bytes_to_varint(data, offset)
+    return data[offset:offset + length].decode('utf-8'), offset + length
+
+
+def bytes_to_binary_response(data, offset):
+    '''
+    Reads a binary response from data at offset into the same structure as
+    its json counterpart
+    Returns the response and the offset past it
+    '''
+    kind = struct.unpack_from('B', data, offset)[0]
+    offset += 1
+
+    if kind == BINARY_ERROR:
+        error, offset = bytes_to_token(data, offset)
+        return {'error': error}, offset
+
+    count, offset = bytes_to_varint(data, offset)
+
+    if kind == BINARY_PATHS:
+        paths = []
+
+        for _ in range(count):
+            path, offset = bytes_to_binary_response(data, offset)
+            paths.append(path)
+        return {'paths': paths, 'success': True}, offset
+
+    segments = []
+
+    for _ in range(count):
+        source, offset = bytes_to_token(data, offset)
+        connection, offset = bytes_to_token(data, offset)
+        destination, offset = bytes_to_token(data, offset)
+        arrival, arrival_max, departure, cost = struct.unpack_from(
+            '<qqqd', data, offset)
+        offset += 32
+        segments.append({
+            'source': source,
+            'connection': connection,
+            'destination': destination,
+            'arrival_at_source': arrival,
+            'arrival_max_by': arrival_max,
+            'departure_from_source': departure,
+            'cost_reaching_source': cost
+        })
+    return {
+        'path': segments, 'exact': kind != BINARY_APPROXIMATE_PATH,
+        'success': True}, offset
+
+
+def tolerance_to_kwargs(kwargs):
+    '''
+    Picks the optional tolerance of a multi criteria search out of kwargs
+        [in]ecost: cost within which a path is dominated by a cheaper one
+        [in]etime: time within which a path is dominated by an earlier one
+        [in]vcap: maximum labels settled per vertex
+        [in]lcap: maximum labels created per search
+    '''
+    tolerance = {}
+
+    if kwargs.get('ecost') is not None:
+        if not isinstance(kwargs['ecost'], (int, float)):
+            raise TypeError('ecost should be a numeric type. Got {}'.format(
+                type(kwargs['ecost'])))
+        tolerance['ecost'] = float(kwargs['ecost'])
+
+    for name in ('etime', 'vcap', 'lcap'):
+        if kwargs.get(name) is not None:
+            if not isinstance(kwargs[name], int):
+                raise TypeError('{} should be an integer. Got {}'.format(
+                    name, type(kwargs[name])))
+            tolerance[name] = kwargs[name]
+    return tolerance
+
+
+def bytes_to_response(data):
+    '''
+    Converts the body of a response, json or binary, to a dict
+    '''
+    if data[:1] == b'{':
+        return json.loads(data.decode('utf-8'))
+    return bytes_to_binary_response(data, 0)[0]
+
+
 class Client(object):
     '''
     Client to re-bar.
 
     Sample Usage:
     >> from pyexpresso import Client
-    >> client = Client([host], [port])
+    >> client = Client([host], [port], [version], [binary])
     >> print(client.execute(command, [mode], **kwargs))
     '''
 
     __handler = None
+    __version = 2
+    __binary = False
 
-    def __init__(self, host="127.0.0.1", port=9000):
+    def __init__(self, host="127.0.0.1", port=9000, version=2, binary=False):
         '''
-        Initializes a connection to re-bar
+        Initializes a connection to re-bar. Commands are sent with v2
+        framing unless version is 1. With v2 framing, paths may be requested
+        in the binary response format, which is decoded to the same dicts
         '''
         self.__handler = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
         self.__handler.connect((host, port))
+        self.__version = version
+        self.__binary = binary and version != 1
+
+    def __to_bytes(self, mode, command, request_id=None, **kwargs):
+        '''
+        Converts a command to a frame of the version in use
+        '''
+        if self.__version == 1:
+            if request_id is None:
+                return command_to_bytes(mode, command, **kwargs)
+            return tagged_command_to_bytes(mode, command, request_id, **kwargs)
+
+        if self.__binary:
+            mode |= MODE_BINARY
+        return command_to_bytes_v2(mode, command, request_id, **kwargs)
 
     def close(self):
         '''
@@ -93,10 +320,54 @@ class Client(object):
         '''
         Executes a command against server and returns the json response
         '''
-        self.__handler.sendall(command_to_bytes(mode, command, **kwargs))
-        headers = self.__handler.recv(4)
-        body_length = struct.unpack('I', headers)[0]
-        return json.loads(self.__handler.recv(body_length).decode('utf-8'))
+        self.__handler.sendall(self.__to_bytes(mode, command, **kwargs))
+        body_length = struct.unpack('<I', self.__receive(4))[0]
+        return bytes_to_response(self.__receive(body_length))
+
+    def __receive(self, length):
+        '''
+        Reads exactly length bytes from server
+        '''
+        data = b''
+
+        while len(data) < length:
+            chunk = self.__handler.recv(length - len(data))
+
+            if not chunk:
+                raise IOError('Connection closed by server')
+            data += chunk
+        return data
+
+    def pipeline(self, requests):
+        '''
+        Executes commands against server without waiting on the response to
+        each before sending the next. Server answers them as they finish.
+        Mutations are applied in order of requests, queries may not observe
+        mutations requested before them
+            [in]requests: list of (command, mode, kwargs) tuples
+        Returns the json responses in order of requests
+        '''
+        responses = [None] * len(requests)
+        sent = 0
+        received = 0
+
+        while received < len(requests):
+            while sent < len(requests) and sent - received < PIPELINE_WINDOW:
+                command, mode, kwargs = requests[sent]
+                self.__handler.sendall(
+                    self.__to_bytes(mode, command, sent, **kwargs))
+                sent += 1
+
+            body_length = struct.unpack('<I', self.__receive(4))[0]
+
+            if not body_length & LENGTH_TAGGED:
+                raise IOError('Received an untagged response while pipelining')
+
+            request_id = struct.unpack('<I', self.__receive(4))[0]
+            body = self.__receive(body_length & ~LENGTH_TAGGED)
+            responses[request_id] = bytes_to_response(body)
+            received += 1
+        return responses
 
     def add_vertex(self, vertex):
         '''
@@ -153,6 +424,64 @@ class Client(object):
 
         return self.execute("MODC", **kwargs)
 
+    def mod_edges(self, states):
+        '''
+        Enable/disable several edges as a single update
+            [in]states: list of (code, state) pairs, state being a boolean
+        '''
+        if not isinstance(states, list) or not states:
+            raise TypeError('Required a list of edge states. Got {}'.format(
+                type(states)))
+
+        kwargs = {}
+
+        for index, (code, state) in enumerate(states):
+            if not isinstance(code, str) and not isinstance(code, unicode):
+                raise TypeError('Connection should be a code. Got {}'.format(
+                    type(code)))
+
+            if not isinstance(state, bool):
+                raise TypeError('State should be a boolean. Got {}'.format(
+                    type(state)))
+
+            kwargs['code{}'.format(index)] = code
+            kwargs['state{}'.format(index)] = 1 if state else 0
+
+        return self.execute("BMOD", **kwargs)
+
+    def transaction(self, mutations):
+        '''
+        Apply several mutations as a single update, either all or none
+            [in]mutations: list of (command, kwargs) pairs, command being one
+            of ADDV, ADDE, ADDC or MODC and kwargs its arguments as sent to it
+        '''
+        if not isinstance(mutations, list) or not mutations:
+            raise TypeError('Required a list of mutations. Got {}'.format(
+                type(mutations)))
+
+        kwargs = {}
+
+        for index, (command, arguments) in enumerate(mutations):
+            if command not in ('ADDV', 'ADDE', 'ADDC', 'MODC'):
+                raise ValueError(
+                    'Unsupported command in transaction. Got {}'.format(
+                        command))
+
+            if not isinstance(arguments, dict):
+                raise TypeError('Arguments should be a dict. Got {}'.format(
+                    type(arguments)))
+
+            kwargs['op{}'.format(index)] = command
+
+            for key, value in arguments.items():
+                if key == 'state' and isinstance(value, bool):
+                    value = 1 if value else 0
+                elif key == 'cost':
+                    value = float(value)
+                kwargs['{}{}'.format(key, index)] = value
+
+        return self.execute("TXNS", **kwargs)
+
     def add_edge(self, **kwargs):
         '''
         Add an edge to solver. Parameters
@@ -291,6 +620,8 @@ class Client(object):
     def get_path(self, source, destination, t_start, t_max, **kwargs):
         '''
         Find a path using solver
+            [in]ecost, etime, vcap, lcap: optional tolerance of the search, see
+            tolerance_to_kwargs. The response tells if the path is exact
         '''
         mode = kwargs.get('mode', 0)
 
@@ -316,4 +647,143 @@ class Client(object):
                 type(t_max)))
         return self.execute(
             "FIND", mode=mode, src=source, dst=destination,
-            beg=t_start, tmax=t_max)
+            beg=t_start, tmax=t_max, **tolerance_to_kwargs(kwargs))
+
+    def get_profile(self, source, destination, t_start, t_max, **kwargs):
+        '''
+        Find the profile of journeys departing over a window using solver
+            [in]t_end: end of the window, a day after t_start by default
+            [in]at: time of arrival at source, to fetch a single journey
+        '''
+        mode = kwargs.get('mode', 2)
+
+        if not isinstance(source, str) and not isinstance(source, unicode):
+            raise TypeError('Source should be a code. Got {}'.format(
+                type(source)))
+
+        if (
+                not isinstance(destination, str) and
+                not isinstance(destination, unicode)):
+            raise TypeError('Destination should be a code. Got {}'.format(
+                type(destination)))
+
+        if not isinstance(t_start, int):
+            raise TypeError(
+                'Arrival time at source should be an integer. Got {}'.format(
+                    type(t_start)
+                )
+            )
+
+        if not isinstance(t_max, int):
+            raise TypeError('Promise date should be an integer. Got {}'.format(
+                type(t_max)))
+
+        optional = {}
+
+        for name, argument in (('end', 't_end'), ('at', 'at')):
+            if kwargs.get(argument) is not None:
+                if not isinstance(kwargs[argument], int):
+                    raise TypeError('{} should be an integer. Got {}'.format(
+                        argument, type(kwargs[argument])))
+                optional[name] = kwargs[argument]
+        return self.execute(
+            "PROF", mode=mode, src=source, dst=destination,
+            beg=t_start, tmax=t_max, **optional)
+
+    def get_paths_from(self, source, destinations, t_start, t_max, **kwargs):
+        '''
+        Find paths from a source to several destinations in a single search
+            [in]destinations: list of destination codes
+            [in]best: only find the path to the nearest destination
+        '''
+        mode = kwargs.get('mode', 0)
+
+        if not isinstance(source, str) and not isinstance(source, unicode):
+            raise TypeError('Source should be a code. Got {}'.format(
+                type(source)))
+
+        if not isinstance(destinations, list) or not destinations:
+            raise TypeError('Required a list of destinations. Got {}'.format(
+                type(destinations)))
+
+        optional = {}
+
+        for index, destination in enumerate(destinations):
+            optional['dst{}'.format(index)] = destination
+
+        if kwargs.get('best'):
+            optional['best'] = 1
+        return self.execute(
+            "MANY", mode=mode, src=source, beg=t_start, tmax=t_max,
+            **optional)
+
+    def get_pareto_paths(self, source, destination, t_start, t_max, **kwargs):
+        '''
+        Find the paths not dominated on both cost and time of arrival
+            [in]k: maximum number of paths, 16 by default
+            [in]ecost, etime, vcap, lcap: optional tolerance of the search, see
+            tolerance_to_kwargs
+        Paths are returned in increasing order of cost
+        '''
+        mode = kwargs.get('mode', 0)
+
+        if not isinstance(source, str) and not isinstance(source, unicode):
+            raise TypeError('Source should be a code. Got {}'.format(
+                type(source)))
+
+        if (
+                not isinstance(destination, str) and
+                not isinstance(destination, unicode)):
+            raise TypeError('Destination should be a code. Got {}'.format(
+                type(destination)))
+
+        optional = tolerance_to_kwargs(kwargs)
+
+        if kwargs.get('k') is not None:
+            if not isinstance(kwargs['k'], int):
+                raise TypeError('k should be an integer. Got {}'.format(
+                    type(kwargs['k'])))
+            optional['k'] = kwargs['k']
+        return self.execute(
+            "PSET", mode=mode, src=source, dst=destination,
+            beg=t_start, tmax=t_max, **optional)
+
+    def get_stats(self, mode=0):
+        '''
+        Fetch the hits and misses of the cache of paths of solver
+        '''
+        return self.execute("STAT", mode=mode)
+
+    def get_paths(self, queries, mode=0):
+        '''
+        Find paths for a batch of queries using solver
+            [in]queries: list of (source, destination, t_start, t_max) tuples
+        Queries are pipelined in frames of at most BATCH_SIZE queries, or
+        BATCH_SIZE_V2 with v2 framing. Returns a response per query, in order
+        '''
+        if not isinstance(queries, list):
+            raise TypeError('Required a list of queries. Got {}'.format(
+                type(queries)))
+
+        requests = []
+        batch_size = BATCH_SIZE if self.__version == 1 else BATCH_SIZE_V2
+
+        for offset in range(0, len(queries), batch_size):
+            kwargs = {}
+
+            for index, query in enumerate(
+                    queries[offset:offset + batch_size]):
+                source, destination, t_start, t_max = query
+                kwargs['src{}'.format(index)] = source
+                kwargs['dst{}'.format(index)] = destination
+                kwargs['beg{}'.format(index)] = t_start
+                kwargs['tmax{}'.format(index)] = t_max
+            requests.append(("BFND", mode, kwargs))
+
+        paths = []
+
+        for response in self.pipeline(requests):
+            if 'error' in response:
+                raise ValueError(response['error'])
+            paths.extend(response['paths'])
+        return paths
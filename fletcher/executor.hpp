@@ -0,0 +1,240 @@
+/** @file executor.hpp
+ * @brief Defines a fixed size pool of worker threads to execute solver tasks
+ */
+#ifndef EXECUTOR_HPP_INCLUDED
+#define EXECUTOR_HPP_INCLUDED
+
+#include <condition_variable>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief Number of tasks queued per worker past which no further commands are admitted
+ */
+const size_t QUEUED_PER_WORKER = 64;
+
+/**
+ * @brief A persistent pool of worker threads consuming tasks from a shared queue
+ * @details Workers are spawned once on construction and joined on destruction. Tasks are executed in the order they were submitted.
+ *
+ * The queue is bounded by admission rather than by refusing tasks. A producer asks to be admitted before queueing the tasks of a command,
+ * and is called back once workers drain the queue to half its capacity if it is full. Tasks queued by running tasks are never refused,
+ * hence workers never wait on each other.
+ */
+class Executor {
+    private:
+        /**
+         * @brief Threads consuming tasks from the queue
+         */
+        vector<thread> workers;
+
+        /**
+         * @brief Tasks pending execution
+         */
+        queue<function<void()> > tasks;
+
+        /**
+         * @brief Tasks to execute one at a time, in the order they were queued, waiting on the one executing
+         */
+        queue<function<void()> > serial;
+
+        /**
+         * @brief Flag to indicate a task of the serial queue is executing or queued
+         */
+        bool serial_running = false;
+
+        /**
+         * @brief Number of tasks queued, along with those of the serial queue, past which producers are not admitted
+         */
+        size_t capacity;
+
+        /**
+         * @brief Callbacks of producers not admitted, invoked once the queue is drained to half its capacity
+         */
+        vector<function<void()> > waiting;
+
+        /**
+         * @brief Mutex guarding the task queues and producers waiting on them
+         */
+        mutex tasks_mutex;
+
+        /**
+         * @brief Condition signalled when a task is queued or the executor is stopped
+         */
+        condition_variable tasks_available;
+
+        /**
+         * @brief Flag to indicate workers should exit once the queue drains
+         */
+        bool stopped = false;
+
+        /**
+         * @brief Loop executed by each worker thread
+         */
+        void work() {
+            while (true) {
+                function<void()> task;
+                vector<function<void()> > admitted;
+                {
+                    unique_lock<mutex> tasks_lock(tasks_mutex);
+                    tasks_available.wait(tasks_lock, [this]() { return stopped || !tasks.empty(); });
+
+                    if (stopped && tasks.empty()) {
+                        return;
+                    }
+
+                    task = move(tasks.front());
+                    tasks.pop();
+
+                    if (!waiting.empty() && tasks.size() + serial.size() <= capacity / 2) {
+                        admitted.swap(waiting);
+                    }
+                }
+
+                for (auto& resume: admitted) {
+                    resume();
+                }
+                task();
+            }
+        }
+
+        /**
+         * @brief Executes the earliest task of the serial queue, then queues the next one if any
+         * @details Tasks of the serial queue are queued one at a time rather than drained, hence tasks queued in between are not held up.
+         */
+        void next_serial() {
+            function<void()> task;
+            {
+                lock_guard<mutex> tasks_lock(tasks_mutex);
+                task = move(serial.front());
+                serial.pop();
+            }
+            task();
+            {
+                lock_guard<mutex> tasks_lock(tasks_mutex);
+
+                if (serial.empty()) {
+                    serial_running = false;
+                    return;
+                }
+                tasks.emplace([this]() { next_serial(); });
+            }
+            tasks_available.notify_one();
+        }
+
+    public:
+        /**
+         * @brief Constructs an executor and spawns its workers
+         * @details The queue admits QUEUED_PER_WORKER tasks per worker.
+         * @param[in] : Number of worker threads. Defaults to the number of hardware threads
+         */
+        Executor(size_t nthreads = thread::hardware_concurrency()) {
+            if (nthreads == 0) {
+                nthreads = 1;
+            }
+            capacity = nthreads * QUEUED_PER_WORKER;
+
+            for (size_t i = 0; i < nthreads; i++) {
+                workers.emplace_back(&Executor::work, this);
+            }
+        }
+
+        Executor(const Executor&) = delete;
+        Executor& operator = (const Executor&) = delete;
+
+        /**
+         * @brief Drains pending tasks and joins all workers
+         */
+        ~Executor() {
+            {
+                lock_guard<mutex> tasks_lock(tasks_mutex);
+                stopped = true;
+            }
+            tasks_available.notify_all();
+
+            for (auto& worker: workers) {
+                worker.join();
+            }
+        }
+
+        /**
+         * @brief Number of worker threads in the pool
+         */
+        size_t size() const {
+            return workers.size();
+        }
+
+        /**
+         * @brief Checks if a producer may queue the tasks of a command, the queue holding fewer tasks than its capacity
+         * @param[in] : Callback invoked on a worker thread once the queue is drained to half its capacity, if not admitted now. Must not
+         * throw or block
+         * @return True if admitted. Otherwise the callback is kept until invoked
+         */
+        bool admit(function<void()> resume) {
+            lock_guard<mutex> tasks_lock(tasks_mutex);
+
+            if (tasks.size() + serial.size() < capacity) {
+                return true;
+            }
+            waiting.push_back(move(resume));
+            return false;
+        }
+
+        /**
+         * @brief Queues a task for execution on a worker thread without tracking its result
+         * @details The task must not throw, there being nobody to propagate the exception to.
+         * @param[in] : Task to execute
+         */
+        void post(function<void()> task) {
+            {
+                lock_guard<mutex> tasks_lock(tasks_mutex);
+                tasks.push(move(task));
+            }
+            tasks_available.notify_one();
+        }
+
+        /**
+         * @brief Queues a task for execution on a worker thread once every task queued serially before it has been executed
+         * @details Tasks queued serially are executed one at a time, in the order they were queued. The task must not throw.
+         * @param[in] : Task to execute
+         */
+        void post_serial(function<void()> task) {
+            {
+                lock_guard<mutex> tasks_lock(tasks_mutex);
+                serial.push(move(task));
+
+                if (serial_running) {
+                    return;
+                }
+                serial_running = true;
+                tasks.emplace([this]() { next_serial(); });
+            }
+            tasks_available.notify_one();
+        }
+
+        /**
+         * @brief Queues a callable for execution on a worker thread
+         * @param[in] : Callable taking no arguments
+         * @return A future holding the result(or exception) of the callable
+         */
+        template <typename F> auto submit(F&& callable) -> future<decltype(callable())> {
+            typedef decltype(callable()) R;
+            auto task = make_shared<packaged_task<R()> >(forward<F>(callable));
+            future<R> result = task->get_future();
+            {
+                lock_guard<mutex> tasks_lock(tasks_mutex);
+                tasks.emplace([task]() { (*task)(); });
+            }
+            tasks_available.notify_one();
+            return result;
+        }
+};
+
+#endif
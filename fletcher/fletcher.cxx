@@ -1,37 +1,104 @@
 #include <cassert>
 #include <climits>
+#include <iostream>
+#include <thread>
 
 #include "optimal.hpp"
 #include "pareto.hpp"
+#include "scan.hpp"
+#include "contraction.hpp"
 #include "jezik.hpp"
 #include "weld.hpp"
 
 const string_view DEFAULT_HOST{"127.0.0.1"};
 const short int DEFAULT_PORT = 9000;
+const size_t DEFAULT_IO_THREADS = 1;
 
 int main(int argc, char* argv[]) {
     string host{DEFAULT_HOST};
     short int port = DEFAULT_PORT;
+    string snapshot, edges;
+    size_t io_threads = DEFAULT_IO_THREADS, workers = thread::hardware_concurrency();
+    vector<string> positional;
 
-    if (argc == 2) {
-        port = atoi(argv[1]);
+    for (int i = 1; i < argc; i++) {
+        string_view arg{argv[i]};
+
+        if (arg == "--snapshot" && i + 1 < argc) {
+            snapshot = argv[++i];
+        } else
+
+        if (arg == "--load" && i + 1 < argc) {
+            edges = argv[++i];
+        } else
+
+        if (arg == "--io-threads" && i + 1 < argc) {
+            io_threads = max(atoi(argv[++i]), 1);
+        } else
+
+        if (arg == "--workers" && i + 1 < argc) {
+            workers = max(atoi(argv[++i]), 1);
+        }
+        else {
+            positional.push_back(argv[i]);
+        }
+    }
+
+    if (positional.size() == 1) {
+        port = atoi(positional[0].c_str());
     } else
 
-    if (argc == 3) {
-        host = static_cast<string>(argv[1]);
-        port = atoi(argv[2]);
+    if (positional.size() == 2) {
+        host = positional[0];
+        port = atoi(positional[1].c_str());
     }
 
     assert(sizeof(char) * CHAR_BIT == 8);
     asio::io_service io_service;
     asio::ip::tcp::endpoint endpoint(asio::ip::tcp::v4(), port);
 
-    Weld<BaseGraph> welder;
+    auto graph = make_shared<BaseGraph>();
+
+    if (!snapshot.empty()) {
+        try {
+            Snapshot image{snapshot};
+            graph->load_snapshot(image);
+            cerr << "Loaded " << image.header().nvertices << " vertices and " << image.header().nedges << " edges from snapshot <" << snapshot << ">" << endl;
+        }
+        catch (const exception& exc) {
+            cerr << "Starting with an empty graph. Unable to load snapshot: " << exc.what() << endl;
+        }
+    }
+
+    if (!edges.empty()) {
+        try {
+            EdgeReader reader{edges};
+            graph->load_edges(reader);
+            cerr << "Loaded " << reader.vertices().size() << " vertices and " << reader.edges().size() << " edges from <" << edges << ">" << endl;
+        }
+        catch (const exception& exc) {
+            cerr << "Unable to load edges: " << exc.what() << endl;
+        }
+    }
+
+    Weld<Solver, BaseGraph> welder{graph, workers};
     welder.add_solver(make_shared<Pareto>());
     welder.add_solver(make_shared<Optimal>(true));
+    welder.add_solver(make_shared<ConnectionScan>());
+    welder.add_solver(make_shared<ContractionHierarchy>());
+
+    Server server{io_service, endpoint, ref(welder), [&welder](function<void()> resume) { return welder.admit(move(resume)); }};
 
-    Server server{io_service, endpoint, welder};
+    // Threads running the io_service only parse and write, solving is left to the workers of welder
+    vector<thread> io_pool;
 
+    for (size_t i = 1; i < io_threads; i++) {
+        io_pool.emplace_back([&io_service]() { io_service.run(); });
+    }
     io_service.run();
+
+    for (auto& io_thread: io_pool) {
+        io_thread.join();
+    }
     return 0;
 }
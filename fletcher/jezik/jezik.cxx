@@ -1,150 +1,498 @@
 #include <jezik.hpp>
 
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
 #include <cstring>
 #include <iostream>
-#include <thread>
+#include <limits>
+#include <stdexcept>
 #include <utility>
 
-class SocketClosedException : public exception {};
+Jezik::Jezik (shared_ptr<tcp::socket> _socket_ptr, shared_ptr<asio::io_service::strand> _strand_ptr) : socket_ptr(_socket_ptr), strand_ptr(_strand_ptr) {}
 
-Jezik::Jezik (shared_ptr<tcp::socket> _socket_ptr) : socket_ptr(_socket_ptr) {}
+void Jezik::resume(const asio::error_code& error, const function<void()>& next) {
+    if (error == asio::error::eof) {
+        // The peer is done sending, yet may still be waiting on responses to commands executing
+        return;
+    }
 
-void Jezik::read(unsigned char* buffer) {
-    asio::error_code error;
+    if (error) {
+        if (error != asio::error::operation_aborted) {
+            cerr << "Error occurred while attempting to read from/write to socket. " << error.message() << endl;
+        }
+        asio::error_code ignored;
+        socket_ptr->close(ignored);
+        return;
+    }
 
-    socket_ptr->read_some(asio::buffer(buffer, sizeof(unsigned char)), error);
+    try {
+        next();
+    }
+    catch (const exception& exc) {
+        cerr << "Exception occurred while parsing/executing command: " << exc.what() << endl;
+        asio::error_code ignored;
+        socket_ptr->close(ignored);
+    }
+}
 
-    if (error == asio::error::eof) {
-        throw SocketClosedException();
+void Jezik::read_some(char* buffer, size_t length, function<void(size_t)> next) {
+    socket_ptr->async_read_some(asio::buffer(buffer, length), strand_ptr->wrap(
+        [this, next](const asio::error_code& error, size_t nread) {
+            resume(error, [next, nread]() {
+                next(nread);
+            });
+        }
+    ));
+}
+
+void Jezik::do_write(string response, function<void()> next) {
+    Response queued{{}, 4, move(response), next};
+    auto length = to_buffer<unsigned char, 4>(queued.body.length());
+    copy(length.begin(), length.end(), queued.header.begin());
+
+    responses.push_back(move(queued));
+
+    if (responses.size() == 1) {
+        flush();
     }
-    else if (error) {
-        throw asio::system_error(error);
+}
+
+void Jezik::do_write(string response, uint32_t request_id, function<void()> next) {
+    Response queued{{}, 8, move(response), next};
+    auto length = to_buffer<unsigned char, 4>(queued.body.length() | LENGTH_TAGGED);
+    auto id = to_buffer<unsigned char, 4>(request_id);
+    copy(length.begin(), length.end(), queued.header.begin());
+    copy(id.begin(), id.end(), queued.header.begin() + 4);
+
+    responses.push_back(move(queued));
+
+    if (responses.size() == 1) {
+        flush();
     }
 }
 
-void Jezik::read(char* buffer, size_t length) {
-    if (length == 0) {
-        length = sizeof(buffer);
+void Jezik::flush() {
+    Response& front = responses.front();
+
+    array<asio::const_buffer, 2> buffers{{asio::buffer(front.header, front.header_length), asio::buffer(front.body)}};
+    asio::async_write(*socket_ptr, buffers, strand_ptr->wrap(
+        [this](const asio::error_code& error, size_t) {
+            function<void()> next = move(responses.front().next);
+            responses.pop_front();
+
+            if (!error && !responses.empty()) {
+                flush();
+            }
+            resume(error, next);
+        }
+    ));
+}
+
+Jezik::~Jezik() {}
+
+/**
+ * @brief Parses a decimal integer in place
+ * @param[in] : Characters to parse
+ * @param[out] : Value parsed
+ * @return true if all characters form an integer in range
+ */
+static bool parse_integer(string_view text, long& value) {
+    size_t index = 0;
+    bool negative = false;
+
+    if (index < text.size() && (text[index] == '-' || text[index] == '+')) {
+        negative = text[index] == '-';
+        index++;
+    }
+
+    if (index == text.size()) {
+        return false;
     }
-    try {
-        asio::error_code error;
-        socket_ptr->read_some(asio::buffer(buffer, length), error);
 
-        if (error == asio::error::eof) {
-            throw SocketClosedException();
+    unsigned long magnitude = 0;
+    unsigned long limit = negative ? 0UL - (unsigned long)(numeric_limits<long>::min()) : (unsigned long)(numeric_limits<long>::max());
+
+    for (; index < text.size(); index++) {
+        if (text[index] < '0' || text[index] > '9') {
+            return false;
         }
-        else if (error) {
-            throw asio::system_error(error);
+        unsigned long digit = text[index] - '0';
+
+        if (magnitude > (limit - digit) / 10) {
+            return false;
         }
+        magnitude = magnitude * 10 + digit;
     }
-    catch (const exception& exc) {
-        cerr << "Error occurred while attempting to read from socket. " << exc.what() << endl;
-        throw;
-    }
+    value = negative ? (long)(0UL - magnitude) : (long)(magnitude);
+    return true;
 }
 
-void Jezik::do_write(string_view response) {
-    socket_ptr->write_some(asio::buffer(to_buffer<unsigned char, 4>(response.length()), 4));
-    socket_ptr->write_some(asio::buffer(response.to_string()));
+/**
+ * @brief Parses a decimal floating point number
+ * @param[in] : Characters to parse, at most 255 of them
+ * @param[out] : Value parsed
+ * @return true if all characters form a number
+ */
+static bool parse_real(string_view text, double& value) {
+    // Values are not null terminated in the receive buffer, hence are copied to the stack for strtod
+    char copy[256];
+    char* end = nullptr;
+
+    if (text.empty() || text.size() >= sizeof(copy)) {
+        return false;
+    }
+    memcpy(copy, text.data(), text.size());
+    copy[text.size()] = '\0';
+
+    value = strtod(copy, &end);
+    return end == copy + text.size();
 }
 
-Jezik::~Jezik() {}
+/**
+ * @brief Reads a varint
+ * @param[in] : Start of frame
+ * @param[in] : Length of frame
+ * @param[in,out] : Offset of varint, advanced past it
+ * @param[out] : Value read
+ * @return false if the varint overruns the frame or 64 bits
+ */
+static bool read_varint(const unsigned char* bytes, size_t length, size_t& offset, uint64_t& value) {
+    value = 0;
 
-ArgumentToken::ArgumentToken(shared_ptr<tcp::socket> socket_ptr) : Jezik(socket_ptr) {}
+    for (unsigned shift = 0; shift < 64 && offset < length; shift += 7) {
+        unsigned char byte = bytes[offset++];
+        value |= uint64_t(byte & 0x7F) << shift;
 
-void ArgumentToken::do_read_body_length() {
-    read(body_length);
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return false;
 }
 
-void ArgumentToken::do_read_body() {
-    read(data, body_length[0]);
-}
+/**
+ * @brief Reads an 8 byte little endian value
+ * @param[in] : Start of value
+ */
+static uint64_t read_fixed64(const unsigned char* bytes) {
+    uint64_t value = 0;
 
-void ArgumentToken::do_read() {
-    do_read_body_length();
-    assert(body_length[0] > 0);
-    do_read_body();
+    for (size_t i = 0; i < 8; i++) {
+        value |= uint64_t(bytes[i]) << (CHAR_BIT * i);
+    }
+    return value;
 }
 
-string_view ArgumentToken::value() const {
-    return string_view(data, int(body_length[0]));
+size_t Frame::parse(const char* data, size_t length) {
+    arguments.clear();
+    error.clear();
+    expected = 0;
+
+    if (length == 0) {
+        return 0;
+    }
+
+    if ((unsigned char)(data[0]) == FRAME_V2) {
+        version = 2;
+        return parse_v2(data, length);
+    }
+    version = 1;
+    return parse_v1(data, length);
 }
 
-Argument::Argument(shared_ptr<tcp::socket> socket_ptr) : Jezik(socket_ptr) {}
+size_t Frame::parse_v1(const char* data, size_t length) {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    size_t offset = 6;
 
-void Argument::do_read() {
-    do_read_argument_type();
-    argn.do_read();
-    argv.do_read();
+    if (length < offset) {
+        return 0;
+    }
+    mode = bytes[0] & ~MODE_TAGGED;
+    tagged = (bytes[0] & MODE_TAGGED) != 0;
+    format = FORMAT_JSON;
+    command = string_view(data + 1, 4);
+    size_t nargs = bytes[5];
 
-    string argt{argument_type, 3};
+    if (tagged) {
+        if (length < offset + 4) {
+            return 0;
+        }
+        request_id = bytes[6] | bytes[7] << 8 | bytes[8] << 16 | uint32_t(bytes[9]) << 24;
+        offset += 4;
+    }
 
-    string t_value = argv.value().to_string();
+    for (size_t index = 0; index < nargs; index++) {
+        if (length < offset + 4) {
+            return 0;
+        }
+        string_view type(data + offset, 3);
+        size_t name_length = bytes[offset + 3];
+        offset += 4;
 
-    if(argt.compare("INT") == 0) {
-        data.first = argn.value();
-        data.second = stol(t_value);
-    } else
+        if (length < offset + name_length + 1) {
+            return 0;
+        }
+        string_view name(data + offset, name_length);
+        size_t value_length = bytes[offset + name_length];
+        offset += name_length + 1;
 
-    if(argt.compare("STR") == 0) {
-        data.first = argn.value();
-        data.second = t_value;
-    } else
+        if (length < offset + value_length) {
+            return 0;
+        }
+        string_view value(data + offset, value_length);
+        offset += value_length;
+
+        // The rest of the frame is still consumed once an argument is invalid, leaving the next frame at the start of the remainder
+        if (!error.empty()) {
+            continue;
+        }
+        ArgumentValue argument{name, ARGUMENT_STR, 0, 0.0, value};
 
-    if(argt.compare("DBL") == 0) {
-        data.first = argn.value();
-        data.second = stod(t_value);
-    } else {
-        throw invalid_argument("Unsupported type for argument " + argt);
+        if (type == "INT") {
+            argument.type = ARGUMENT_INT;
+
+            if (!parse_integer(value, argument.integer)) {
+                error = "Invalid INT value for argument \"" + name.to_string() + "\"";
+            }
+        } else
+
+        if (type == "STR") {
+            argument.type = ARGUMENT_STR;
+        } else
+
+        if (type == "DBL") {
+            argument.type = ARGUMENT_DBL;
+
+            if (!parse_real(value, argument.real)) {
+                error = "Invalid DBL value for argument \"" + name.to_string() + "\"";
+            }
+        } else {
+            error = "Unsupported type for argument " + type.to_string();
+        }
+        arguments.push_back(argument);
     }
+    return offset;
 }
 
-void Argument::do_read_argument_type() {
-    read(argument_type, sizeof(argument_type));
-}
+size_t Frame::parse_v2(const char* data, size_t length) {
+    const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+    size_t offset = 5;
+
+    mode = 0;
+    tagged = false;
+    format = FORMAT_JSON;
+
+    if (length < offset) {
+        return 0;
+    }
+    uint32_t frame_length = bytes[1] | bytes[2] << 8 | bytes[3] << 16 | uint32_t(bytes[4]) << 24;
+
+    // The stream can not be resynchronized past a frame which is not going to be buffered, hence the connection is given up on
+    if (frame_length > MAX_FRAME_LENGTH) {
+        throw length_error("Frame of " + to_string(frame_length) + " bytes exceeds limit of " + to_string(MAX_FRAME_LENGTH) + " bytes");
+    }
+    expected = offset + frame_length;
+
+    if (length < expected) {
+        return 0;
+    }
+
+    // Lengths are known upfront, hence any overrun is a malformed frame rather than one which is not whole yet
+    size_t end = expected;
+    auto malformed = [this, end]() {
+        arguments.clear();
+        error = "Malformed frame";
+        return end;
+    };
+
+    if (end < offset + 5) {
+        return malformed();
+    }
+    mode = bytes[offset] & ~(MODE_TAGGED | MODE_BINARY);
+    tagged = (bytes[offset] & MODE_TAGGED) != 0;
+    format = (bytes[offset] & MODE_BINARY) ? FORMAT_BINARY : FORMAT_JSON;
+    command = string_view(data + offset + 1, 4);
+    offset += 5;
+
+    if (tagged) {
+        if (end < offset + 4) {
+            return malformed();
+        }
+        request_id = bytes[offset] | bytes[offset + 1] << 8 | bytes[offset + 2] << 16 | uint32_t(bytes[offset + 3]) << 24;
+        offset += 4;
+    }
+    uint64_t nargs = 0;
 
-pair<string_view, any> Argument::value() const {
-    return data;
+    if (!read_varint(bytes, end, offset, nargs)) {
+        return malformed();
+    }
+
+    for (uint64_t index = 0; index < nargs; index++) {
+        uint64_t name_length = 0;
+        uint64_t value_length = 0;
+
+        if (offset == end) {
+            return malformed();
+        }
+        unsigned char type = bytes[offset++];
+
+        if (!read_varint(bytes, end, offset, name_length) || end - offset < name_length) {
+            return malformed();
+        }
+        ArgumentValue argument{string_view(data + offset, name_length), ARGUMENT_STR, 0, 0.0, string_view()};
+        offset += name_length;
+
+        switch (type) {
+            case FRAME_INT:
+                if (end - offset < 8) {
+                    return malformed();
+                }
+                argument.type = ARGUMENT_INT;
+                argument.integer = long(int64_t(read_fixed64(bytes + offset)));
+                offset += 8;
+                break;
+
+            case FRAME_DBL: {
+                if (end - offset < 8) {
+                    return malformed();
+                }
+                uint64_t bits = read_fixed64(bytes + offset);
+                argument.type = ARGUMENT_DBL;
+                memcpy(&argument.real, &bits, sizeof(bits));
+                offset += 8;
+                break;
+            }
+
+            case FRAME_STR:
+                if (!read_varint(bytes, end, offset, value_length) || end - offset < value_length) {
+                    return malformed();
+                }
+                argument.type = ARGUMENT_STR;
+                argument.text = string_view(data + offset, value_length);
+                offset += value_length;
+                break;
+
+            default:
+                arguments.clear();
+                error = "Unsupported type for argument " + to_string(type);
+                return end;
+        }
+        arguments.push_back(argument);
+    }
+
+    if (offset != end) {
+        return malformed();
+    }
+    return end;
 }
 
-Command::Command(tcp::socket socket) : Jezik(make_shared<tcp::socket>(move(socket))) {}
+Command::Command(tcp::socket socket, asio::io_service& io_service, Handler _handler, Admission _admission) : Jezik(make_shared<tcp::socket>(move(socket)), make_shared<asio::io_service::strand>(io_service)), buffer(RECEIVE_BUFFER_LENGTH), handler(_handler), admission(_admission) {}
+
+void Command::do_read(function<void()> next) {
+    if (head > 0) {
+        copy(buffer.begin() + head, buffer.begin() + tail, buffer.begin());
+        tail -= head;
+        head = 0;
+    }
 
-void Command::do_read() {
-    read(mode);
-    read(command, sizeof(command));
-    read(nargs);
+    if (tail == 0 && frame.expected <= RECEIVE_BUFFER_LENGTH && buffer.size() > RECEIVE_BUFFER_LENGTH) {
+        buffer.resize(RECEIVE_BUFFER_LENGTH);
+        buffer.shrink_to_fit();
+    }
 
-    for (size_t i = 0; i < nargs[0]; i++) {
-        Argument arg{socket_ptr};
-        arg.do_read();
-        kwargs[arg.value().first.to_string()] = arg.value().second;
+    if (tail == buffer.size() || frame.expected > buffer.size()) {
+        buffer.resize(max(buffer.size() * 2, frame.expected));
     }
+
+    read_some(buffer.data() + tail, buffer.size() - tail, [this, next](size_t length) {
+        tail += length;
+        next();
+    });
 }
 
-void Command::start(function<json_map(int, string_view, const map<string, any>&) > handler) {
-    try {
-        while(true) {
-            do_read();
-            string response = handler(mode[0], string_view(command, 4), kwargs).to_string();
-            do_write(response);
+void Command::process() {
+    shared_ptr<Command> self = shared_from_this();
+
+    while (true) {
+        // Admission calls back on any thread, hence processing is posted back to the strand of the connection
+        bool admitted = admission([self]() {
+            self->strand_ptr->post([self]() {
+                self->process();
+            });
+        });
+
+        if (!admitted) {
+            return;
+        }
+
+        size_t length = frame.parse(buffer.data() + head, tail - head);
+
+        if (length == 0) {
+            // Continuations hold on to the command, keeping it alive for as long as an operation against its socket is pending
+            do_read([self]() {
+                self->process();
+            });
+            return;
+        }
+        head += length;
+        run_command();
+
+        if (!frame.tagged) {
+            return;
+        }
+
+        if (in_flight == MAX_IN_FLIGHT) {
+            paused = true;
+            return;
         }
     }
-    catch (const SocketClosedException& exc) {
-        socket_ptr->close();
-        return;
+}
+
+void Command::run_command() {
+    shared_ptr<Command> self = shared_from_this();
+    Responder respond;
+
+    // Responders may be invoked on any thread, hence the write is posted back to the strand of the connection
+    if (frame.tagged) {
+        uint32_t id = frame.request_id;
+        in_flight++;
+
+        respond = [self, id](string response) {
+            self->strand_ptr->post([self, id, body = move(response)]() mutable {
+                self->do_write(move(body), id, [self]() {
+                    self->in_flight--;
+
+                    if (self->paused) {
+                        self->paused = false;
+                        self->process();
+                    }
+                });
+            });
+        };
     }
-    catch (const exception& exc) {
-        cerr << "Exception occurred while parsing/executing command: " << exc.what() << endl;
-        socket_ptr->close();
+    else {
+        respond = [self](string response) {
+            self->strand_ptr->post([self, body = move(response)]() mutable {
+                self->do_write(move(body), [self]() {
+                    self->process();
+                });
+            });
+        };
+    }
+
+    if (!frame.error.empty()) {
+        respond(error_response(frame.format, frame.error));
         return;
     }
+    handler(frame.mode, frame.format, frame.command, frame.arguments, respond);
 }
 
-void do_read(shared_ptr<Command> command_ptr, function<json_map(int, string_view, const map<string, any>&) > handler) {
-    command_ptr->start(handler);
+void Command::start() {
+    process();
 }
 
-Server::Server(asio::io_service& io_service, tcp::endpoint& endpoint, function<json_map(int, string_view, const map<string, any>&)> _handler) : acceptor(io_service, endpoint) ,  socket(io_service) , handler(_handler){
+Server::Server(asio::io_service& _io_service, tcp::endpoint& endpoint, Handler _handler, Admission _admission) : io_service(_io_service), acceptor(_io_service, endpoint) ,  socket(_io_service) , handler(_handler), admission(_admission){
     try {
         do_accept();
     }
@@ -157,9 +505,11 @@ Server::Server(asio::io_service& io_service, tcp::endpoint& endpoint, function<j
 void Server::do_accept() {
     acceptor.async_accept(socket, [this](const asio::error_code ec) {
         if (!ec) {
-            shared_ptr<Command> command = make_shared<Command>(std::move(socket));
-            std::thread thread(do_read, command, handler);
-            thread.detach();
+            asio::error_code ignored;
+            socket.set_option(tcp::no_delay(true), ignored);
+
+            shared_ptr<Command> command = make_shared<Command>(std::move(socket), io_service, handler, admission);
+            command->start();
         }
         do_accept();
     });
@@ -1,262 +1,409 @@
 /** @file jezik.hpp
  * @brief Defines the protocol and utility functions for the TCP server
+ * @details All socket operations are asynchronous and are executed by the threads running the io_service. Operations against a single
+ * connection are serialized through a strand, hence the number of threads is independent of the number of connections.
  */
+#include <cstdint>
+#include <deque>
 #include <memory>
-#include <experimental/any>
+#include <vector>
 #include <experimental/string_view>
 
 #include <asio.hpp>
 
 #include <jeayeson/jeayeson.hpp>
 
+#include "arguments.hpp"
+#include "encoding.hpp"
+
 using namespace std;
 using experimental::string_view;
-using experimental::any;
 using asio::ip::tcp;
 
 /**
- * @brief Utility function to convert an unsigned integer to a buffer
+ * @brief Callback invoked with the serialized response to a command once it has been executed
+ */
+typedef function<void(string)> Responder;
+
+/**
+ * @brief Functor which takes a command and its named arguments as input, executes it and passes its response, serialized in the
+ * requested format where supported, on to a Responder
+ * @details Named arguments are views into the receive buffer of the connection and are only valid for the duration of the call
+ */
+typedef function<void(int, ResponseFormat, string_view, const Arguments&, Responder)> Handler;
+
+/**
+ * @brief Functor which checks if a command may be passed on to a Handler now. Otherwise it keeps the continuation passed in, invoking it
+ * on any thread once commands may be passed on again, and returns false
+ */
+typedef function<bool(function<void()>)> Admission;
+
+/**
+ * @brief Flag set on the mode of a command to mark it as tagged with a request id
+ */
+const unsigned char MODE_TAGGED = 0x80;
+
+/**
+ * @brief Flag set on the mode of a v2 command to request a binary response, as defined by encoding.hpp. v2 modes are hence limited to
+ * 0-63
+ */
+const unsigned char MODE_BINARY = 0x40;
+
+/**
+ * @brief Flag set on the length of a response to mark it as tagged with the request id of its command
+ */
+const uint32_t LENGTH_TAGGED = 0x80000000;
+
+/**
+ * @brief Maximum number of tagged commands per connection executing at once. Further commands are not read until one responds
+ */
+const size_t MAX_IN_FLIGHT = 128;
+
+/**
+ * @brief Marker leading a v2 frame, in place of the mode of a v1 frame. v1 modes are hence limited to 0-126
+ */
+const unsigned char FRAME_V2 = 0x7F;
+
+/**
+ * @brief Maximum length of a v2 frame. Connections sending longer frames are closed
+ */
+const uint32_t MAX_FRAME_LENGTH = 64 * 1024 * 1024;
+
+/**
+ * @brief Types of argument values in a v2 frame
+ */
+enum FrameValueType : unsigned char {
+    FRAME_INT = 0,
+    FRAME_STR = 1,
+    FRAME_DBL = 2
+};
+
+/**
+ * @brief Initial size of the receive buffer of a connection. The buffer grows to hold a longer frame and shrinks back once it is decoded
+ */
+const size_t RECEIVE_BUFFER_LENGTH = 16 * 1024;
+
+/**
+ * @brief Utility function to convert an unsigned integer to a little endian buffer
  */
 template <typename T, size_t N> array<T, N> to_buffer(unsigned int value) {
     array<T, N> buffer;
     size_t t_size = sizeof(T) * CHAR_BIT;
 
-    for (int i = N; i > 0; i--) {
-        buffer[i] = (value >> (t_size * (i - 1))) & 0xFF;
+    for (size_t i = 0; i < N; i++) {
+        buffer[i] = (value >> (t_size * i)) & 0xFF;
     }
     return buffer;
 }
 
 /**
- * @brief A class to implement basic read write and structure for TCP Messaging.
+ * @brief Structure representing a command decoded from a frame
+ * @details Two framings are supported on the same connection, told apart by their first byte.
+ *
+ * A v1 frame consists of the following components
+ * - Mode (Integer[0-126]), with MODE_TAGGED set if the command is tagged
+ * - Command (string{0-4})
+ * - Nargs (Integer[0-255])
+ * - Request id (4 byte little endian integer), only if the command is tagged
+ * - Arguments, each consisting of a
+ *   - 3 byte keyword specifying the argument value type (INT, STR, DBL)
+ *   - A 1 byte length followed by as many characters specifying the argument name
+ *   - A 1 byte length followed by as many characters specifying the argument value, in decimal for INT and DBL
+ *
+ * A v2 frame consists of the following components
+ * - FRAME_V2 (1 byte)
+ * - Length of the rest of the frame (4 byte little endian integer, at most MAX_FRAME_LENGTH)
+ * - Mode (Integer[0-63]), with MODE_TAGGED set if the command is tagged and MODE_BINARY set if a binary response is requested
+ * - Command (string{0-4})
+ * - Request id (4 byte little endian integer), only if the command is tagged
+ * - Nargs (varint)
+ * - Arguments, each consisting of a
+ *   - 1 byte FrameValueType specifying the argument value type
+ *   - A varint length followed by as many characters specifying the argument name
+ *   - The argument value, as an 8 byte little endian two's complement integer for FRAME_INT, an 8 byte little endian IEEE 754 double
+ *   for FRAME_DBL or a varint length followed by as many characters for FRAME_STR
+ *
+ * Varints are unsigned LEB128, i.e. 7 bits per byte, least significant first, with the high bit set on all but the last byte.
+ *
+ * The command and arguments are views into the buffer the frame was decoded from.
  */
-class Jezik {
-    protected:
-        /**
-         * @brief Pointer to a socket against which a connection has been made
-         */
-        shared_ptr<tcp::socket> socket_ptr;
+struct Frame {
+    /**
+     * @brief Version of the framing the command was decoded from
+     */
+    int version;
+
+    /**
+     * @brief Solver mode, without MODE_TAGGED or MODE_BINARY
+     */
+    int mode;
+
+    /**
+     * @brief Format requested for the response
+     */
+    ResponseFormat format;
+
+    /**
+     * @brief Flag to indicate the command was tagged with a request id
+     */
+    bool tagged;
+
+    /**
+     * @brief Request id of a tagged command
+     */
+    uint32_t request_id;
+
+    /**
+     * @brief Command to execute
+     */
+    string_view command;
+
+    /**
+     * @brief Named arguments for command
+     */
+    Arguments arguments;
+
+    /**
+     * @brief Reason the command could not be decoded, if the frame was whole but its contents were not valid
+     */
+    string error;
+
+    /**
+     * @brief Length of the frame being decoded, if known from its header even though the frame is not whole yet. 0 otherwise
+     */
+    size_t expected;
+
+    /**
+     * @brief Decodes a frame from a buffer
+     * @details Numeric values are parsed in place without allocating. A frame with invalid contents is consumed as a whole with error
+     * set, hence the stream of frames stays in sync.
+     * @param[in] : Start of buffer
+     * @param[in] : Length of buffer
+     * @return Length of the frame decoded, or 0 if the buffer does not hold a whole frame yet
+     */
+    size_t parse(const char*, size_t);
 
+    private:
         /**
-         * @brief Read data from socket to a buffer.
-         * @details Specifically used to read a single byte of data representing integral values in the range of 0-255.
-         * @param[in,out] : A buffer to which data has to be read
+         * @brief Decodes a v1 frame from a buffer
+         * @param[in] : Start of buffer
+         * @param[in] : Length of buffer
+         * @return Length of the frame decoded, or 0 if the buffer does not hold a whole frame yet
          */
-        void read(unsigned char*);
+        size_t parse_v1(const char*, size_t);
 
         /**
-         * Read data from socket to a buffer with optional size
-         * @param[in,out] : A buffer to which data has to be read
-         * @param[in] : An optional length indicating the size of data to be read(defaults to length of entire buffer).
-         */
-        void read(char*, size_t = 0);
-
-    public:
-        /*
-         * Default constructs the protocol handler
-         * @param[in] : Pointer to socket against which connection has been established
+         * @brief Decodes a v2 frame from a buffer
+         * @param[in] : Start of buffer
+         * @param[in] : Length of buffer
+         * @return Length of the frame decoded, or 0 if the buffer does not hold a whole frame yet
          */
-        Jezik (shared_ptr<tcp::socket>);
+        size_t parse_v2(const char*, size_t);
+};
 
+/**
+ * @brief A class to implement basic read write and structure for TCP Messaging.
+ */
+class Jezik {
+    protected:
         /**
-         * Pure virtual virtual responsible for appropriate calls to read() depending on buffers it needs to populate
+         * @brief Pointer to a socket against which a connection has been made
          */
-        virtual void do_read() = 0;
+        shared_ptr<tcp::socket> socket_ptr;
 
         /**
-         * Writes to the tcp socket
-         * @param[in] : Data to be written to socket
+         * @brief Pointer to a strand serializing all operations against the socket
          */
-        void do_write(string_view);
-
+        shared_ptr<asio::io_service::strand> strand_ptr;
 
         /**
+         * @brief Structure representing a response queued to be written to socket
          */
-        virtual ~Jezik() = 0;
-};
+        struct Response {
+            /**
+             * @brief Length of response, followed by the request id if tagged
+             */
+            array<unsigned char, 8> header;
 
-/**
- * @brief Class representing an argument token.
- * @details Each argument token consists of 2 parts
- * - A 1 byte header (unsigned char) specifying the size of the body
- * - A 1-256 length of body characters specifying the value of this token
- */
-class ArgumentToken : public Jezik {
-    private:
-        /**
-         * @brief Buffer to hold the body of token
-         */
-        char data[256];
+            /**
+             * @brief Number of bytes used in header
+             */
+            size_t header_length;
 
-        /**
-         * @brief Buffer to hold the length of the body of token
-         */
-        unsigned char body_length[1];
+            /**
+             * @brief Body of response
+             */
+            string body;
+
+            /**
+             * @brief Continuation invoked once the response has been written
+             */
+            function<void()> next;
+        };
 
         /**
-         * @brief Reads the body length of the token
+         * @brief Responses queued to be written, the first of which is being written
          */
-        void do_read_body_length(); 
+        deque<Response> responses;
 
         /**
-         * @brief Reads the body of the token 
+         * @brief Writes the first queued response to socket
          */
-        void do_read_body();
+        void flush();
 
-    public:
         /**
-         * @brief Default constructs a message handler
-         * @param[in] : Pointer to socket against which connection has been established
+         * Read whatever data is available from socket to a buffer
+         * @param[in,out] : A buffer to which data has to be read
+         * @param[in] : Length of buffer
+         * @param[in] : Continuation invoked with the length of data read
          */
-        ArgumentToken(shared_ptr<tcp::socket>);
+        void read_some(char*, size_t, function<void(size_t)>);
 
         /**
-         * @brief Reads argument token from socket
+         * @brief Invokes a continuation of a socket operation, closing the socket on failure
+         * @details The socket is left open once the peer stops sending, for responses still executing to be written
+         * @param[in] : Error reported by the socket operation
+         * @param[in] : Continuation to invoke if the operation succeeded
          */
-        void do_read();
+        void resume(const asio::error_code&, const function<void()>&);
 
+    public:
         /*
-         * @brief Fetches the value of ArgumentToken
-         * @return The body of the ArgumentToken
+         * Default constructs the protocol handler
+         * @param[in] : Pointer to socket against which connection has been established
+         * @param[in] : Pointer to strand serializing operations against the socket
          */
-        string_view value() const;
-};
+        Jezik (shared_ptr<tcp::socket>, shared_ptr<asio::io_service::strand>);
 
-/**
- * @brief Class to implement the Argument Messaging Protocol.
- * @details Implement an argument messaging protocol to represent a named argument(i.e. arg_name = arg_value). Each argument consists of a
- * - 3 byte keyword specifying the argument value type (INT, STR, DBL)
- * - An argument token as defined by ArgumentToken specifying the argument name
- * - An argument token as defined by ArgumentToken specifying the argument value
- */
-class Argument : public Jezik {
-    private:
         /**
-         * @brief A buffer to hold the argument type
+         * Pure virtual virtual responsible for appropriate calls to read() depending on buffers it needs to populate
+         * @param[in] : Continuation invoked once buffers have been populated
          */
-        char argument_type[3];
+        virtual void do_read(function<void()>) = 0;
 
         /**
-         * @brief ArgumentToken to hold the argument name
+         * Writes to the tcp socket
+         * @details Responses are queued and written one at a time, in order of calls to do_write
+         * @param[in] : Data to be written to socket
+         * @param[in] : Continuation invoked once data has been written
          */
-        ArgumentToken argn{socket_ptr};
+        void do_write(string, function<void()>);
 
         /**
-         * @brief ArgumentToken to hold the argument value
+         * Writes to the tcp socket a response tagged with a request id
+         * @param[in] : Data to be written to socket
+         * @param[in] : Request id of the command responded to
+         * @param[in] : Continuation invoked once data has been written
          */
-        ArgumentToken argv{socket_ptr};
+        void do_write(string, uint32_t, function<void()>);
 
-        /**
-         * @brief A map exposing the named argument as a key, value pair
-         */
-        pair<string_view, any> data;
 
         /**
-         * @brief Read the argument type from socket
          */
-        void do_read_argument_type();
+        virtual ~Jezik() = 0;
+};
 
+/**
+ * @brief Class to implement a command in the messaging protocol over TCP
+ * @details Commands are read as frames of either version, as defined by Frame, into a single receive buffer reused across commands. Each read takes
+ * whatever data is available, which often holds several frames, and frames are decoded straight from the buffer.
+ *
+ * Tagged commands are pipelined, i.e. the next command is decoded without waiting on the response, and are responded to as they finish,
+ * in any order. The length of a tagged response has LENGTH_TAGGED set and is followed by the request id of its command. Untagged
+ * commands are responded to before the next command is decoded.
+ *
+ * Each command is admitted before it is decoded. Until then, the connection is neither decoded nor read from, hence the peer is held
+ * back by the socket filling up.
+ */
+class Command : public Jezik, public enable_shared_from_this<Command>  {
+    private:
         /**
-         * @brief Read an ArgumentToken from the socket
+         * @brief Buffer holding data read from socket
          */
-        void do_read_argument_token();
+        vector<char> buffer;
 
         /**
-         * @brief Fetch the argument type
-         * @return A string representing the argument type
+         * @brief Offset in buffer of the first byte not decoded yet
          */
-        string_view argt();
+        size_t head = 0;
 
-    public:
         /**
-         * @brief Default constructs an Argument
-         * @param[in] : Pointer to socket against which connection has been established
+         * @brief Offset in buffer past the last byte read
          */
-        Argument(shared_ptr<tcp::socket>);
+        size_t tail = 0;
 
         /**
-         * @brief Read named argument from socket
+         * @brief Frame last decoded, reused across commands
          */
-        void do_read();
+        Frame frame;
 
         /**
-         * @brief Fetch the named argument
-         * @return Named argument as a pair of key, value
+         * @brief Number of tagged commands executing
          */
-        pair<string_view, any> value() const;
-};
+        size_t in_flight = 0;
 
-/**
- * @brief Class to implement a command in the messaging protocol over TCP
- * @details A command consists of the following components
- * - Mode (Integer[0-1])
- * - Nargs (Integer[0-255])
- * - Command (string{0-4})
- * - Arguments (Map of named arguments to be used against command)
- */
-class Command : public Jezik, public enable_shared_from_this<Command>  {
-    private:
         /**
-         * @brief Buffer to store mode
+         * @brief Flag to indicate decoding was paused with MAX_IN_FLIGHT commands executing
          */
-        unsigned char mode[1];
+        bool paused = false;
 
         /**
-         * @brief Buffer to store number of arguments
+         * @brief A functor which takes the command as an input and executes it
          */
-        unsigned char nargs[1];
+        Handler handler;
 
         /**
-         * @brief Buffer to store command
+         * @brief A functor which checks if the next command may be executed
          */
-        char command[4];
+        Admission admission;
 
         /**
-         * @brief A map holding named arguments as key: value
+         * @brief Decodes and executes commands held in buffer, reading from socket once it holds no whole frame
+         * @details Stops without reading if the next command is not admitted, resuming once admission calls it back.
          */
-        map<string, any> kwargs;
+        void process();
 
         /**
-         * @brief Executes a successfully read command
+         * @brief Executes the command last decoded
          */
         void run_command();
 
-        /**
-         * @brief Fetch the parsed command
-         * @return String representation of the command
-         */
-        string_view cmd();
-
     public:
 
         /**
          * @brief Default constructs an instance of command to read from an accepted tcp socket
-         * @param[in] : Pointer to socket against which connection has been established
+         * @param[in] : Socket against which connection has been established
+         * @param[in] : An io_service on which operations against the socket are executed
+         * @param[in] : A functor which takes the command as an input and executes it
+         * @param[in] : A functor which checks if the next command may be executed
          */
-        Command(tcp::socket);
+        Command(tcp::socket, asio::io_service&, Handler, Admission);
 
         /**
-         * @brief Implementaion of the virtual function to read the command from the socket
+         * @brief Implementaion of the virtual function to read available data from the socket into buffer
+         * @details Decoded data is discarded first, growing the buffer only if a single frame does not fit. The buffer is grown at once
+         * to the length of a v2 frame
+         * @param[in] : Continuation invoked once data has been read
          */
-        void do_read();
+        void do_read(function<void()>);
 
         /**
-         * @brief Wrapper function to make appropriate underlying calls to parse command from socket, execute it and write appropriate response to socket
-         * @param[in] : A functor which takes the command as an input and executes it.
+         * @brief Starts reading commands from the socket, executing them and writing their responses to the socket until the socket is
+         * closed
          */
-        void start(function<json_map(int, string_view, const map<string, any>&) >);
+        void start();
 };
 
-/**
- * @brief Allow reading command in a separate thread
- */
-void do_read(shared_ptr<Command>, function<json_map(int, string_view, const map<string, any>&) >);
-
 /**
  * @brief Class implementing the server responsible for accepting TCP connections.
  */
 class Server {
     private:
+        /**
+         * @brief An io_service on which accepted connections are served
+         */
+        asio::io_service& io_service;
+
         /**
          * @brief An acceptor to bind a socket to an endpoint
          */
@@ -267,7 +414,12 @@ class Server {
         /**
          * @brief A functor which takes a Command as input and passes it on to an appropriate solver
          */
-        function<json_map(int, string_view, const map<string, any>&) > handler;
+        Handler handler;
+
+        /**
+         * @brief A functor which checks if a command may be passed on, shared by all connections
+         */
+        Admission admission;
 
     public:
         /**
@@ -280,6 +432,7 @@ class Server {
          * @param[in] : An io_service responsible for underlying network socket
          * @param[in] : Endpoint where the underlying socket binds to
          * @param[in] : A functor which takes a Command as input and passes it on to an appropriate solver
+         * @param[in] : A functor which checks if a Command may be passed on, holding back connections until it may
          */
-        Server(asio::io_service&, tcp::endpoint&, function<json_map(int, string_view, const map<string, any>&) >);
+        Server(asio::io_service&, tcp::endpoint&, Handler, Admission);
 };
@@ -0,0 +1,467 @@
+#include <algorithm>
+#include <stdexcept>
+
+#include "arguments.hpp"
+
+/**
+ * @brief Names of argument types as used in errors
+ */
+static const char* ARGUMENT_TYPE_NAMES[] = {"INT", "STR", "DBL"};
+
+/**
+ * @brief Throws an error describing an argument of unexpected type
+ * @param[in] : Argument found
+ * @param[in] : Type expected
+ */
+[[noreturn]] static void mismatch(const ArgumentValue& value, ArgumentType expected) {
+    throw invalid_argument(
+        "Argument \"" + value.name.to_string() + "\" should be of type " + ARGUMENT_TYPE_NAMES[expected] + ". Got " + ARGUMENT_TYPE_NAMES[value.type]
+    );
+}
+
+/**
+ * @brief Splits the name of an indexed argument into its field and index, e.g. src12 into src and 12
+ * @param[in] : Name of argument
+ * @param[in] : Bound on the index, i.e. the number of arguments. Indices past it cannot follow one another from 0 and are clamped to it
+ * @param[out] : Field named
+ * @param[out] : Index
+ * @return True if the name is a field followed by an index
+ */
+static bool split_indexed(string_view name, size_t bound, string_view& field, size_t& index) {
+    size_t digits = name.find_first_of("0123456789");
+
+    if (digits == string_view::npos || digits == 0) {
+        return false;
+    }
+
+    field = name.substr(0, digits);
+    index = 0;
+
+    for (char digit: name.substr(digits)) {
+        if (digit < '0' || digit > '9') {
+            return false;
+        }
+        index = min(index * 10 + (digit - '0'), bound);
+    }
+    return true;
+}
+
+void Arguments::clear() {
+    values.clear();
+}
+
+void Arguments::push_back(const ArgumentValue& value) {
+    values.push_back(value);
+}
+
+size_t Arguments::size() const {
+    return values.size();
+}
+
+const vector<ArgumentValue>& Arguments::all() const {
+    return values;
+}
+
+const ArgumentValue* Arguments::find(string_view name) const {
+    for (auto value = values.rbegin(); value != values.rend(); value++) {
+        if (value->name == name) {
+            return &(*value);
+        }
+    }
+    return nullptr;
+}
+
+const ArgumentValue& Arguments::at(string_view name) const {
+    const ArgumentValue* value = find(name);
+
+    if (value == nullptr) {
+        throw invalid_argument("Missing required argument \"" + name.to_string() + "\"");
+    }
+    return *value;
+}
+
+string_view Arguments::text(string_view name) const {
+    const ArgumentValue& value = at(name);
+
+    if (value.type != ARGUMENT_STR) {
+        mismatch(value, ARGUMENT_STR);
+    }
+    return value.text;
+}
+
+long Arguments::integer(string_view name) const {
+    const ArgumentValue& value = at(name);
+
+    if (value.type != ARGUMENT_INT) {
+        mismatch(value, ARGUMENT_INT);
+    }
+    return value.integer;
+}
+
+double Arguments::real(string_view name) const {
+    const ArgumentValue& value = at(name);
+
+    if (value.type == ARGUMENT_INT) {
+        return value.integer;
+    }
+
+    if (value.type != ARGUMENT_DBL) {
+        mismatch(value, ARGUMENT_DBL);
+    }
+    return value.real;
+}
+
+VertexArgs VertexArgs::parse(const Arguments& arguments) {
+    return VertexArgs{arguments.text("code").to_string()};
+}
+
+EdgeArgs EdgeArgs::parse(const Arguments& arguments) {
+    return EdgeArgs{
+        arguments.text("src").to_string(),
+        arguments.text("dst").to_string(),
+        arguments.text("conn").to_string(),
+        arguments.integer("dep"),
+        arguments.integer("dur"),
+        arguments.integer("tip"),
+        arguments.integer("tap"),
+        arguments.integer("top"),
+        arguments.real("cost")
+    };
+}
+
+ContinuousEdgeArgs ContinuousEdgeArgs::parse(const Arguments& arguments) {
+    return ContinuousEdgeArgs{
+        arguments.text("src").to_string(),
+        arguments.text("dst").to_string(),
+        arguments.text("conn").to_string(),
+        arguments.integer("tip"),
+        arguments.integer("tap"),
+        arguments.integer("top")
+    };
+}
+
+ToggleArgs ToggleArgs::parse(const Arguments& arguments) {
+    return ToggleArgs{arguments.text("code").to_string(), arguments.integer("state")};
+}
+
+ToggleBatchArgs ToggleBatchArgs::parse(const Arguments& arguments) {
+    ToggleBatchArgs args;
+    vector<const ArgumentValue*> codes, states;
+
+    // Arguments are visited once as for a batch, as a burst of cancellations may toggle hundreds of edges
+    for (auto const& value: arguments.all()) {
+        string_view field;
+        size_t index;
+
+        if (!split_indexed(value.name, arguments.size(), field, index)) {
+            continue;
+        }
+
+        vector<const ArgumentValue*>* indexed = nullptr;
+
+        if (field == "code") {
+            if (value.type != ARGUMENT_STR) {
+                mismatch(value, ARGUMENT_STR);
+            }
+            indexed = &codes;
+        } else
+
+        if (field == "state") {
+            if (value.type != ARGUMENT_INT) {
+                mismatch(value, ARGUMENT_INT);
+            }
+            indexed = &states;
+        }
+
+        if (indexed == nullptr) {
+            continue;
+        }
+
+        if (index >= indexed->size()) {
+            indexed->resize(index + 1);
+        }
+        (*indexed)[index] = &value;
+    }
+
+    for (size_t index = 0; index < codes.size() && codes[index] != nullptr; index++) {
+        if (index >= states.size() || states[index] == nullptr) {
+            throw invalid_argument("Missing required argument \"state" + to_string(index) + "\"");
+        }
+        args.toggles.push_back(ToggleArgs{codes[index]->text.to_string(), states[index]->integer});
+    }
+
+    // Toggles past the last code found would otherwise be dropped while the others are applied
+    if (args.toggles.size() < codes.size() || args.toggles.size() < states.size()) {
+        throw invalid_argument("Missing required argument \"code" + to_string(args.toggles.size()) + "\"");
+    }
+
+    if (args.toggles.empty()) {
+        throw invalid_argument("Missing required argument \"code0\"");
+    }
+    return args;
+}
+
+TransactionArgs TransactionArgs::parse(const Arguments& arguments) {
+    TransactionArgs args;
+    vector<Arguments> indexed;
+
+    // Arguments of each mutation are gathered under their names less the index, hence parsed as those of a command alone
+    for (auto const& value: arguments.all()) {
+        string_view field;
+        size_t index;
+
+        if (!split_indexed(value.name, arguments.size(), field, index)) {
+            continue;
+        }
+
+        if (index >= indexed.size()) {
+            indexed.resize(index + 1);
+        }
+
+        ArgumentValue renamed = value;
+        renamed.name = field;
+        indexed[index].push_back(renamed);
+    }
+
+    for (size_t index = 0; index < indexed.size() && indexed[index].find("op") != nullptr; index++) {
+        const Arguments& fields = indexed[index];
+        GraphMutation mutation;
+
+        try {
+            string_view op = fields.text("op");
+
+            if (op == "ADDV") {
+                mutation.type = MUTATION_ADDV;
+                mutation.vertex = VertexArgs::parse(fields);
+            } else
+
+            if (op == "ADDE") {
+                mutation.type = MUTATION_ADDE;
+                mutation.edge = EdgeArgs::parse(fields);
+            } else
+
+            if (op == "ADDC") {
+                mutation.type = MUTATION_ADDC;
+                mutation.continuous = ContinuousEdgeArgs::parse(fields);
+            } else
+
+            if (op == "MODC") {
+                mutation.type = MUTATION_MODC;
+                mutation.toggle = ToggleArgs::parse(fields);
+            }
+            else {
+                throw invalid_argument("Unsupported command <" + op.to_string() + ">");
+            }
+        }
+        catch (const invalid_argument& exc) {
+            throw invalid_argument("Mutation " + to_string(index) + ": " + exc.what());
+        }
+        args.mutations.push_back(std::move(mutation));
+    }
+
+    // Fields of a mutation past the last one found would otherwise be dropped while the others are applied
+    if (args.mutations.size() < indexed.size()) {
+        throw invalid_argument("Missing required argument \"op" + to_string(args.mutations.size()) + "\"");
+    }
+
+    if (args.mutations.empty()) {
+        throw invalid_argument("Missing required argument \"op0\"");
+    }
+    return args;
+}
+
+LookupArgs LookupArgs::parse(const Arguments& arguments) {
+    return LookupArgs{arguments.text("src").to_string(), arguments.text("conn").to_string()};
+}
+
+FileArgs FileArgs::parse(const Arguments& arguments) {
+    return FileArgs{arguments.text("path").to_string()};
+}
+
+bool Tolerance::exact() const {
+    return cost == 0 && time == 0 && vertex_labels == 0 && labels == 0;
+}
+
+Tolerance Tolerance::parse(const Arguments& arguments) {
+    Tolerance tolerance;
+    tolerance.cost = (arguments.find("ecost") == nullptr) ? 0 : arguments.real("ecost");
+    tolerance.time = (arguments.find("etime") == nullptr) ? 0 : arguments.integer("etime");
+
+    long vertex_labels = (arguments.find("vcap") == nullptr) ? 0 : arguments.integer("vcap");
+    long labels = (arguments.find("lcap") == nullptr) ? 0 : arguments.integer("lcap");
+
+    if (!(tolerance.cost >= 0) || tolerance.time < 0 || vertex_labels < 0 || labels < 0) {
+        throw invalid_argument("Arguments \"ecost\", \"etime\", \"vcap\" and \"lcap\" should not be negative");
+    }
+    tolerance.vertex_labels = vertex_labels;
+    tolerance.labels = labels;
+    return tolerance;
+}
+
+FindArgs FindArgs::parse(const Arguments& arguments) {
+    return FindArgs{
+        arguments.text("src").to_string(),
+        arguments.text("dst").to_string(),
+        arguments.integer("beg"),
+        arguments.integer("tmax"),
+        Tolerance::parse(arguments)
+    };
+}
+
+ProfileArgs ProfileArgs::parse(const Arguments& arguments) {
+    ProfileArgs args;
+    args.src = arguments.text("src").to_string();
+    args.dst = arguments.text("dst").to_string();
+    args.beg = arguments.integer("beg");
+    args.end = (arguments.find("end") == nullptr) ? args.beg + PROFILE_WINDOW : arguments.integer("end");
+    args.tmax = arguments.integer("tmax");
+    args.point = (arguments.find("at") != nullptr);
+    args.at = args.point ? arguments.integer("at") : args.beg;
+    return args;
+}
+
+ManyArgs ManyArgs::parse(const Arguments& arguments) {
+    ManyArgs args;
+    args.src = arguments.text("src").to_string();
+    args.beg = arguments.integer("beg");
+    args.tmax = arguments.integer("tmax");
+    args.best = (arguments.find("best") != nullptr) && arguments.integer("best") != 0;
+
+    vector<const ArgumentValue*> indexed;
+
+    // Arguments are visited once as for a batch, as a set of candidates may hold hundreds of destinations
+    for (auto const& value: arguments.all()) {
+        string_view field;
+        size_t index;
+
+        if (!split_indexed(value.name, arguments.size(), field, index) || field != "dst") {
+            continue;
+        }
+
+        if (value.type != ARGUMENT_STR) {
+            mismatch(value, ARGUMENT_STR);
+        }
+
+        if (index >= indexed.size()) {
+            indexed.resize(index + 1);
+        }
+        indexed[index] = &value;
+    }
+
+    // A destination missing would otherwise shift or drop the candidates after it without the caller knowing
+    for (size_t index = 0; index < indexed.size(); index++) {
+        if (indexed[index] == nullptr) {
+            throw invalid_argument("Missing required argument \"dst" + to_string(index) + "\"");
+        }
+        args.dsts.push_back(indexed[index]->text.to_string());
+    }
+
+    if (args.dsts.empty()) {
+        throw invalid_argument("Missing required argument \"dst0\"");
+    }
+    return args;
+}
+
+ParetoArgs ParetoArgs::parse(const Arguments& arguments) {
+    ParetoArgs args;
+    args.src = arguments.text("src").to_string();
+    args.dst = arguments.text("dst").to_string();
+    args.beg = arguments.integer("beg");
+    args.tmax = arguments.integer("tmax");
+
+    long limit = (arguments.find("k") == nullptr) ? PARETO_LIMIT : arguments.integer("k");
+
+    if (limit < 1) {
+        throw invalid_argument("Argument \"k\" should be positive. Got <" + to_string(limit) + ">");
+    }
+    args.limit = limit;
+    args.tolerance = Tolerance::parse(arguments);
+    return args;
+}
+
+/**
+ * @brief Flags marking the fields of a query seen while parsing a batch
+ */
+enum BatchField : unsigned {
+    FIELD_SRC = 1 << 0,
+    FIELD_DST = 1 << 1,
+    FIELD_BEG = 1 << 2,
+    FIELD_TMAX = 1 << 3
+};
+
+BatchArgs BatchArgs::parse(const Arguments& arguments) {
+    BatchArgs batch;
+    vector<unsigned> seen;
+
+    // Arguments are visited once, splitting each name into a field and an index, instead of looking up every indexed name
+    for (auto const& value: arguments.all()) {
+        string_view field;
+        size_t index;
+
+        if (!split_indexed(value.name, arguments.size(), field, index)) {
+            continue;
+        }
+
+        unsigned flag = 0;
+
+        if (field == "src") {
+            flag = FIELD_SRC;
+        } else
+
+        if (field == "dst") {
+            flag = FIELD_DST;
+        } else
+
+        if (field == "beg") {
+            flag = FIELD_BEG;
+        } else
+
+        if (field == "tmax") {
+            flag = FIELD_TMAX;
+        }
+        else {
+            continue;
+        }
+
+        if (index >= batch.queries.size()) {
+            batch.queries.resize(index + 1);
+            seen.resize(index + 1);
+        }
+
+        FindArgs& query = batch.queries[index];
+        ArgumentType expected = (flag == FIELD_SRC || flag == FIELD_DST) ? ARGUMENT_STR : ARGUMENT_INT;
+
+        if (value.type != expected) {
+            mismatch(value, expected);
+        }
+
+        switch (flag) {
+            case FIELD_SRC: query.src = value.text.to_string(); break;
+            case FIELD_DST: query.dst = value.text.to_string(); break;
+            case FIELD_BEG: query.beg = value.integer; break;
+            case FIELD_TMAX: query.tmax = value.integer; break;
+        }
+        seen[index] |= flag;
+    }
+
+    size_t count = 0;
+
+    while (count < seen.size() && (seen[count] & FIELD_SRC)) {
+        count++;
+    }
+
+    // Answers are positional, hence queries past a gap are rejected rather than dropped
+    if (count < seen.size()) {
+        throw invalid_argument("Missing required argument \"src" + to_string(count) + "\"");
+    }
+
+    for (size_t index = 0; index < count; index++) {
+        for (auto const& field: {make_pair(FIELD_DST, "dst"), make_pair(FIELD_BEG, "beg"), make_pair(FIELD_TMAX, "tmax")}) {
+            if (!(seen[index] & field.first)) {
+                throw invalid_argument("Missing required argument \"" + string(field.second) + to_string(index) + "\"");
+            }
+        }
+    }
+    batch.queries.resize(count);
+    return batch;
+}
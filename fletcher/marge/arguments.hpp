@@ -0,0 +1,530 @@
+/** @file arguments.hpp
+ * @brief Defines the named arguments of a command and the typed arguments each command is executed with
+ * @details Named arguments are decoded by the protocol as views into its receive buffer. Each command parses them into a typed structure
+ * owning its values, which outlives the buffer while the command is executed.
+ */
+#ifndef ARGUMENTS_HPP_INCLUDED
+#define ARGUMENTS_HPP_INCLUDED
+
+#include <string>
+#include <vector>
+#include <experimental/string_view>
+
+using namespace std;
+using std::experimental::string_view;
+
+/**
+ * @brief Length of the window of departures of a profile unless specified, i.e. a day
+ */
+const long PROFILE_WINDOW = 24 * 3600;
+
+/**
+ * @brief Number of non dominated paths found unless specified
+ */
+const long PARETO_LIMIT = 16;
+
+/**
+ * @brief Types of values a named argument can hold
+ */
+enum ArgumentType {
+    ARGUMENT_INT,
+    ARGUMENT_STR,
+    ARGUMENT_DBL
+};
+
+/**
+ * @brief Structure representing a named argument
+ */
+struct ArgumentValue {
+    /**
+     * @brief Name of argument
+     */
+    string_view name;
+
+    /**
+     * @brief Type of value held
+     */
+    ArgumentType type;
+
+    /**
+     * @brief Value held by an argument of type ARGUMENT_INT
+     */
+    long integer;
+
+    /**
+     * @brief Value held by an argument of type ARGUMENT_DBL
+     */
+    double real;
+
+    /**
+     * @brief Value held by an argument of type ARGUMENT_STR
+     */
+    string_view text;
+};
+
+/**
+ * @brief Named arguments of a command
+ * @details Arguments are held in order of their appearance and looked up linearly, commands carrying only a handful of them.
+ * Clearing the arguments retains their storage, hence a single instance is reused across commands without allocating.
+ */
+class Arguments {
+    private:
+        /**
+         * @brief Arguments in order of their appearance
+         */
+        vector<ArgumentValue> values;
+
+    public:
+        /**
+         * @brief Removes all arguments
+         */
+        void clear();
+
+        /**
+         * @brief Appends an argument
+         * @param[in] : Argument to append. Any argument of the same name appended earlier is shadowed
+         */
+        void push_back(const ArgumentValue&);
+
+        /**
+         * @brief Fetch the number of arguments
+         */
+        size_t size() const;
+
+        /**
+         * @brief Fetch all arguments in order of their appearance
+         */
+        const vector<ArgumentValue>& all() const;
+
+        /**
+         * @brief Finds an argument by name
+         * @param[in] : Name of argument
+         * @return Pointer to the argument, or nullptr if absent
+         */
+        const ArgumentValue* find(string_view) const;
+
+        /**
+         * @brief Finds a required argument by name
+         * @param[in] : Name of argument
+         * @return Reference to the argument. Throws invalid_argument if absent
+         */
+        const ArgumentValue& at(string_view) const;
+
+        /**
+         * @brief Fetch a required string argument
+         * @param[in] : Name of argument
+         * @return Value of argument. Throws invalid_argument if absent or of a different type
+         */
+        string_view text(string_view) const;
+
+        /**
+         * @brief Fetch a required integral argument
+         * @param[in] : Name of argument
+         * @return Value of argument. Throws invalid_argument if absent or of a different type
+         */
+        long integer(string_view) const;
+
+        /**
+         * @brief Fetch a required numeric argument
+         * @param[in] : Name of argument
+         * @return Value of argument, integral values being promoted. Throws invalid_argument if absent or not numeric
+         */
+        double real(string_view) const;
+};
+
+/**
+ * @brief Arguments to add a vertex (ADDV)
+ */
+struct VertexArgs {
+    /**
+     * @brief Unique human readable name of vertex
+     */
+    string code;
+
+    /**
+     * @brief Parses named arguments
+     */
+    static VertexArgs parse(const Arguments&);
+};
+
+/**
+ * @brief Arguments to add a time-discrete edge (ADDE)
+ */
+struct EdgeArgs {
+    /**
+     * @brief Source vertex, destination vertex and unique human readable name of edge
+     */
+    string src, dst, conn;
+
+    /**
+     * @brief Departure, duration and processing times for inbound, aggregation and outbound
+     */
+    long dep, dur, tip, tap, top;
+
+    /**
+     * @brief Cost of traversing the edge
+     */
+    double cost;
+
+    /**
+     * @brief Parses named arguments
+     */
+    static EdgeArgs parse(const Arguments&);
+};
+
+/**
+ * @brief Arguments to add a continuous edge (ADDC)
+ */
+struct ContinuousEdgeArgs {
+    /**
+     * @brief Source vertex, destination vertex and unique human readable name of edge
+     */
+    string src, dst, conn;
+
+    /**
+     * @brief Processing times for inbound, aggregation and outbound
+     */
+    long tip, tap, top;
+
+    /**
+     * @brief Parses named arguments
+     */
+    static ContinuousEdgeArgs parse(const Arguments&);
+};
+
+/**
+ * @brief Arguments to enable or disable an edge (MODC)
+ */
+struct ToggleArgs {
+    /**
+     * @brief Unique human readable name of edge
+     */
+    string code;
+
+    /**
+     * @brief State of edge, enabled if 1
+     */
+    long state;
+
+    /**
+     * @brief Parses named arguments
+     */
+    static ToggleArgs parse(const Arguments&);
+};
+
+/**
+ * @brief Arguments to enable or disable a set of edges as a single update (BMOD)
+ * @details Edges are specified as indexed named arguments, i.e. code0, state0, code1 ... with indices following one another from 0. An
+ * edge past a missing code<i> is an error, as is a code<i> without its state<i>
+ */
+struct ToggleBatchArgs {
+    /**
+     * @brief Edges to toggle in order of their index
+     */
+    vector<ToggleArgs> toggles;
+
+    /**
+     * @brief Parses named arguments
+     */
+    static ToggleBatchArgs parse(const Arguments&);
+};
+
+/**
+ * @brief Commands a transaction can carry
+ */
+enum MutationType {
+    MUTATION_ADDV,
+    MUTATION_ADDE,
+    MUTATION_ADDC,
+    MUTATION_MODC
+};
+
+/**
+ * @brief A mutation of the graph carried by a transaction, holding the arguments of its command alone
+ */
+struct GraphMutation {
+    /**
+     * @brief Command of the mutation
+     */
+    MutationType type;
+
+    /**
+     * @brief Arguments if adding a vertex
+     */
+    VertexArgs vertex;
+
+    /**
+     * @brief Arguments if adding a time-discrete edge
+     */
+    EdgeArgs edge;
+
+    /**
+     * @brief Arguments if adding a continuous edge
+     */
+    ContinuousEdgeArgs continuous;
+
+    /**
+     * @brief Arguments if enabling or disabling an edge
+     */
+    ToggleArgs toggle;
+};
+
+/**
+ * @brief Arguments to apply a list of mutations as a single update (TXNS)
+ * @details Mutations are specified as indexed named arguments, op<i> naming the command of a mutation and the arguments of the command
+ * suffixed by the same index, i.e. op0="ADDV", code0, op1="ADDC", src1, dst1, conn1, tip1, tap1, top1 ... with indices following one
+ * another from 0. Any indexed argument past a missing op<i> is an error, hence no mutation of a frame is ever dropped
+ */
+struct TransactionArgs {
+    /**
+     * @brief Mutations in order of their index
+     */
+    vector<GraphMutation> mutations;
+
+    /**
+     * @brief Parses named arguments
+     */
+    static TransactionArgs parse(const Arguments&);
+};
+
+/**
+ * @brief Arguments to look up an edge (LOOK)
+ */
+struct LookupArgs {
+    /**
+     * @brief Source vertex and unique human readable name of edge
+     */
+    string src, conn;
+
+    /**
+     * @brief Parses named arguments
+     */
+    static LookupArgs parse(const Arguments&);
+};
+
+/**
+ * @brief Arguments naming a file to write to or read from (SAVE, LOAD)
+ */
+struct FileArgs {
+    /**
+     * @brief Path to file
+     */
+    string path;
+
+    /**
+     * @brief Parses named arguments
+     */
+    static FileArgs parse(const Arguments&);
+};
+
+/**
+ * @brief Optional bounds on the effort of a multi criteria search, trading exactness of its paths for latency
+ * @details Parsed from the optional arguments ecost, etime, vcap and lcap of a query. Each defaults to 0, i.e. exact and unbounded.
+ */
+struct Tolerance {
+    /**
+     * @brief Cost by which a path may exceed another and still be dominated by it
+     */
+    double cost = 0;
+
+    /**
+     * @brief Time by which a path may arrive after another and still be dominated by it
+     */
+    long time = 0;
+
+    /**
+     * @brief Maximum number of labels settled per vertex, unbounded if 0
+     */
+    size_t vertex_labels = 0;
+
+    /**
+     * @brief Maximum number of labels created per search, unbounded if 0
+     */
+    size_t labels = 0;
+
+    /**
+     * @brief Checks if the search is exact, i.e. has no tolerance nor budget
+     */
+    bool exact() const;
+
+    /**
+     * @brief Parses named arguments
+     */
+    static Tolerance parse(const Arguments&);
+};
+
+/**
+ * @brief Arguments to find a path (FIND)
+ */
+struct FindArgs {
+    /**
+     * @brief Source vertex
+     */
+    string src;
+
+    /**
+     * @brief Destination vertex
+     */
+    string dst;
+
+    /**
+     * @brief Time of arrival at source vertex
+     */
+    long beg;
+
+    /**
+     * @brief Maximum time to arrive at destination vertex
+     */
+    long tmax;
+
+    /**
+     * @brief Bounds on the effort of the search. Optional, defaults to exact
+     */
+    Tolerance tolerance;
+
+    /**
+     * @brief Parses named arguments
+     */
+    static FindArgs parse(const Arguments&);
+};
+
+/**
+ * @brief Arguments to find the profile of a pair of vertices (PROF)
+ */
+struct ProfileArgs {
+    /**
+     * @brief Source vertex
+     */
+    string src;
+
+    /**
+     * @brief Destination vertex
+     */
+    string dst;
+
+    /**
+     * @brief Earliest time of arrival at source vertex
+     */
+    long beg;
+
+    /**
+     * @brief Latest time of arrival at source vertex. Optional, defaults to a day after beg
+     */
+    long end;
+
+    /**
+     * @brief Maximum time to arrive at destination vertex
+     */
+    long tmax;
+
+    /**
+     * @brief Flag to indicate only the journey for a single time of arrival at source is requested
+     */
+    bool point;
+
+    /**
+     * @brief Time of arrival at source vertex the journey is requested for. Optional
+     */
+    long at;
+
+    /**
+     * @brief Parses named arguments
+     */
+    static ProfileArgs parse(const Arguments&);
+};
+
+/**
+ * @brief Arguments to find paths from a source vertex to a set of destination vertices (MANY)
+ * @details Destinations are specified as indexed named arguments, i.e. dst0, dst1 ... with indices following one another from 0. A
+ * missing dst<i> is an error
+ */
+struct ManyArgs {
+    /**
+     * @brief Source vertex
+     */
+    string src;
+
+    /**
+     * @brief Destination vertices in order of their index
+     */
+    vector<string> dsts;
+
+    /**
+     * @brief Time of arrival at source vertex
+     */
+    long beg;
+
+    /**
+     * @brief Maximum time to arrive at any destination vertex
+     */
+    long tmax;
+
+    /**
+     * @brief Flag to indicate only the path to the nearest destination is requested. Optional, set by a non zero best
+     */
+    bool best;
+
+    /**
+     * @brief Parses named arguments
+     */
+    static ManyArgs parse(const Arguments&);
+};
+
+/**
+ * @brief Arguments to find the non dominated paths between a pair of vertices (PSET)
+ */
+struct ParetoArgs {
+    /**
+     * @brief Source vertex
+     */
+    string src;
+
+    /**
+     * @brief Destination vertex
+     */
+    string dst;
+
+    /**
+     * @brief Time of arrival at source vertex
+     */
+    long beg;
+
+    /**
+     * @brief Maximum time to arrive at destination vertex
+     */
+    long tmax;
+
+    /**
+     * @brief Maximum number of paths. Optional, defaults to PARETO_LIMIT
+     */
+    size_t limit;
+
+    /**
+     * @brief Bounds on the effort of the search. Optional, defaults to exact
+     */
+    Tolerance tolerance;
+
+    /**
+     * @brief Parses named arguments
+     */
+    static ParetoArgs parse(const Arguments&);
+};
+
+/**
+ * @brief Arguments to find a batch of paths (BFND)
+ * @details Queries are specified as indexed named arguments, i.e. src0, dst0, beg0, tmax0, src1 ... with indices following one another
+ * from 0. A query past a missing src<i> is an error, as answers are matched to queries by position
+ */
+struct BatchArgs {
+    /**
+     * @brief Queries in order of their index
+     */
+    vector<FindArgs> queries;
+
+    /**
+     * @brief Parses named arguments
+     */
+    static BatchArgs parse(const Arguments&);
+};
+
+#endif
@@ -0,0 +1,112 @@
+#include <functional>
+
+#include "cache.hpp"
+
+bool operator == (const PathKey& first, const PathKey& second) {
+    return first.day == second.day && first.slot == second.slot && first.tmax == second.tmax && first.src == second.src && first.dst == second.dst;
+}
+
+size_t PathKeyHash::operator () (const PathKey& key) const {
+    size_t seed = hash<string>()(key.src);
+
+    for (size_t value: {hash<string>()(key.dst), hash<long>()(key.day), hash<long>()(key.slot), hash<long>()(key.tmax)}) {
+        seed ^= value + 0x9e3779b97f4a7c15 + (seed << 6) + (seed >> 2);
+    }
+    return seed;
+}
+
+CachedPath::CachedPath(uint64_t version, long t_start, const vector<Path>& path) : found_in(version), found_at(t_start) {
+    segments.reserve(path.size());
+
+    for (auto const& segment: path) {
+        segments.push_back(CachedSegment{segment.src.to_string(), segment.conn.to_string(), segment.dst.to_string(), segment.arr, segment.mdep, segment.dep, segment.cost});
+    }
+}
+
+uint64_t CachedPath::version() const {
+    return found_in;
+}
+
+vector<Path> CachedPath::at(long t_start) const {
+    vector<Path> path;
+    path.reserve(segments.size());
+
+    for (auto const& segment: segments) {
+        path.push_back(Path{segment.src, segment.conn, segment.dst, segment.arr, segment.mdep, segment.dep, segment.cost});
+    }
+
+    // A path returning to source arrives at it at a time of its own, left as found
+    if (!path.empty() && path.front().arr == found_at) {
+        path.front().arr = t_start;
+    }
+    return path;
+}
+
+PathCache::PathCache(size_t capacity, size_t nshards) : shards(nshards), shard_capacity(max<size_t>(1, capacity / nshards)), hits(0), misses(0) {}
+
+PathCache::Shard& PathCache::shard(const PathKey& key) {
+    return shards[PathKeyHash()(key) % shards.size()];
+}
+
+shared_ptr<const CachedPath> PathCache::find(const PathKey& key, uint64_t version) {
+    Shard& target = shard(key);
+    lock_guard<mutex> shard_lock(target.shard_mutex);
+
+    auto found = target.paths.find(key);
+
+    if (found == target.paths.end()) {
+        misses++;
+        return nullptr;
+    }
+
+    if (found->second.first->version() != version) {
+        target.recent.erase(found->second.second);
+        target.paths.erase(found);
+        misses++;
+        return nullptr;
+    }
+
+    target.recent.splice(target.recent.begin(), target.recent, found->second.second);
+    hits++;
+    return found->second.first;
+}
+
+void PathCache::insert(const PathKey& key, shared_ptr<const CachedPath> path) {
+    Shard& target = shard(key);
+    lock_guard<mutex> shard_lock(target.shard_mutex);
+
+    auto found = target.paths.find(key);
+
+    // Queries missing together each find the path, hence the path found last replaces the others
+    if (found != target.paths.end()) {
+        found->second.first = move(path);
+        target.recent.splice(target.recent.begin(), target.recent, found->second.second);
+        return;
+    }
+
+    if (target.paths.size() >= shard_capacity) {
+        target.paths.erase(target.recent.back());
+        target.recent.pop_back();
+    }
+
+    target.recent.push_front(key);
+    target.paths.emplace(key, make_pair(move(path), target.recent.begin()));
+}
+
+uint64_t PathCache::hit_count() const {
+    return hits;
+}
+
+uint64_t PathCache::miss_count() const {
+    return misses;
+}
+
+size_t PathCache::size() {
+    size_t total = 0;
+
+    for (auto& target: shards) {
+        lock_guard<mutex> shard_lock(target.shard_mutex);
+        total += target.paths.size();
+    }
+    return total;
+}
@@ -0,0 +1,240 @@
+/** @file cache.hpp
+ * @brief Defines a bounded, sharded cache of paths found by a solver
+ * @details Time-discrete edges depart at the same time every day, hence queries arriving at source between two departures out of it find
+ * the same path. Such queries share a departure slot and an entry of the cache, tagged with the version of the graph it was found against.
+ */
+#ifndef CACHE_HPP_INCLUDED
+#define CACHE_HPP_INCLUDED
+
+#include <atomic>
+#include <list>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+
+#include "graph.hpp"
+
+/**
+ * @brief Maximum number of paths held by a cache, spread evenly over its shards
+ */
+const size_t PATH_CACHE_CAPACITY = 1 << 16;
+
+/**
+ * @brief Number of independently locked shards of a cache
+ */
+const size_t PATH_CACHE_SHARDS = 16;
+
+/**
+ * @brief Key of a cached path
+ */
+struct PathKey {
+    /**
+     * @brief Source vertex
+     */
+    string src;
+
+    /**
+     * @brief Destination vertex
+     */
+    string dst;
+
+    /**
+     * @brief Day of arrival at source vertex
+     */
+    long day;
+
+    /**
+     * @brief Time of day closing the departure slot of arrival at source vertex
+     */
+    long slot;
+
+    /**
+     * @brief Maximum time to arrive at destination vertex
+     */
+    long tmax;
+};
+
+bool operator == (const PathKey&, const PathKey&);
+
+/**
+ * @brief Hashes a PathKey
+ */
+struct PathKeyHash {
+    size_t operator () (const PathKey&) const;
+};
+
+/**
+ * @brief A segment of a cached path, owning the codes it refers to
+ */
+struct CachedSegment {
+    /**
+     * @brief Source vertex in segment
+     */
+    string src;
+
+    /**
+     * @brief Edge used to traverse to destination vertex in segment
+     */
+    string conn;
+
+    /**
+     * @brief Destination vertex in segment
+     */
+    string dst;
+
+    /**
+     * @brief Time of arrival at source vertex
+     */
+    long arr;
+
+    /**
+     * @brief Minimum time by which item should arrive at source vertex
+     */
+    long mdep;
+
+    /**
+     * @brief Time of departure from source vertex
+     */
+    long dep;
+
+    /**
+     * @brief Cumulative cost of arriving at the source vertex
+     */
+    double cost;
+};
+
+/**
+ * @brief A path held by a cache
+ */
+class CachedPath {
+    private:
+        /**
+         * @brief Version of the graph the path was found against
+         */
+        uint64_t found_in;
+
+        /**
+         * @brief Time of arrival at source vertex the path was found for
+         */
+        long found_at;
+
+        /**
+         * @brief Segments of path
+         */
+        vector<CachedSegment> segments;
+
+    public:
+        /**
+         * @brief Copies a path found by a solver
+         * @param[in] : Version of the graph the path was found against
+         * @param[in] : Time of arrival at source vertex the path was found for
+         * @param[in] : Path as returned by find_path
+         */
+        CachedPath(uint64_t, long, const vector<Path>&);
+
+        /**
+         * @brief Fetch the version of the graph the path was found against
+         */
+        uint64_t version() const;
+
+        /**
+         * @brief Fetch the path for a time of arrival at source within the departure slot it was cached for
+         * @details Only the time of arrival at source differs between queries sharing a slot.
+         * @param[in] : Time of arrival at source vertex
+         * @return Path as returned by find_path. Codes are views into the cached path
+         */
+        vector<Path> at(long) const;
+};
+
+/**
+ * @brief Bounded cache of paths, split into shards each locked and evicted independently
+ * @details Each shard evicts the path used least recently once full. Paths found against an earlier version of the graph are never
+ * returned, and are dropped as they are found.
+ */
+class PathCache {
+    private:
+        /**
+         * @brief A shard of the cache
+         */
+        struct Shard {
+            /**
+             * @brief Mutex serializing access to the shard
+             */
+            mutex shard_mutex;
+
+            /**
+             * @brief Keys in order of use, most recent first
+             */
+            list<PathKey> recent;
+
+            /**
+             * @brief Paths by key, along with the position of their key in recent
+             */
+            unordered_map<PathKey, pair<shared_ptr<const CachedPath>, list<PathKey>::iterator>, PathKeyHash> paths;
+        };
+
+        /**
+         * @brief Shards of the cache
+         */
+        vector<Shard> shards;
+
+        /**
+         * @brief Maximum number of paths per shard
+         */
+        size_t shard_capacity;
+
+        /**
+         * @brief Number of lookups returning a path
+         */
+        atomic<uint64_t> hits;
+
+        /**
+         * @brief Number of lookups returning no path
+         */
+        atomic<uint64_t> misses;
+
+        /**
+         * @brief Finds the shard holding a key
+         */
+        Shard& shard(const PathKey&);
+
+    public:
+        /**
+         * @brief Constructs an empty cache
+         * @param[in] : Maximum number of paths held
+         * @param[in] : Number of shards
+         */
+        PathCache(size_t = PATH_CACHE_CAPACITY, size_t = PATH_CACHE_SHARDS);
+
+        /**
+         * @brief Finds a path
+         * @param[in] : Key of path
+         * @param[in] : Current version of the graph
+         * @return Path found against the current version of the graph, or nullptr if there is none
+         */
+        shared_ptr<const CachedPath> find(const PathKey&, uint64_t);
+
+        /**
+         * @brief Adds a path, evicting the path used least recently from its shard if full
+         * @param[in] : Key of path
+         * @param[in] : Path to add
+         */
+        void insert(const PathKey&, shared_ptr<const CachedPath>);
+
+        /**
+         * @brief Fetch the number of lookups returning a path
+         */
+        uint64_t hit_count() const;
+
+        /**
+         * @brief Fetch the number of lookups returning no path
+         */
+        uint64_t miss_count() const;
+
+        /**
+         * @brief Counts the paths held
+         */
+        size_t size();
+};
+
+#endif
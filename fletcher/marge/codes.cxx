@@ -0,0 +1,99 @@
+#include <functional>
+
+#include "codes.hpp"
+
+CodeIndex::CodeIndex(size_t _capacity) : capacity(_capacity), slots(new atomic<uint32_t>[_capacity]) {
+    for (size_t slot = 0; slot < capacity; slot++) {
+        slots[slot].store(0, memory_order_relaxed);
+    }
+}
+
+size_t CodeIndex::size() const {
+    return capacity;
+}
+
+size_t CodeIndex::first(string_view code) const {
+    return hash<string_view>()(code) & (capacity - 1);
+}
+
+uint32_t CodeIndex::at(size_t slot) const {
+    return slots[slot].load(memory_order_acquire);
+}
+
+void CodeIndex::insert(string_view code, uint32_t position) {
+    size_t slot = first(code);
+
+    while (slots[slot].load(memory_order_relaxed) != 0) {
+        slot = (slot + 1) & (capacity - 1);
+    }
+    slots[slot].store(position + 1, memory_order_release);
+}
+
+CodeList::CodeList() : count(0) {}
+
+CodeList::CodeList(const vector<shared_ptr<CodeChunk> >& _chunks, size_t _count, const shared_ptr<const CodeIndex>& _index) : chunks(_chunks.begin(), _chunks.end()), count(_count), index(_index) {}
+
+size_t CodeList::size() const {
+    return count;
+}
+
+bool CodeList::find(string_view code, size_t& position) const {
+    if (!index) {
+        return false;
+    }
+
+    size_t mask = index->size() - 1;
+
+    // Slots past the codes listed belong to later versions and are skipped, their codes possibly being written still
+    for (size_t slot = index->first(code); ; slot = (slot + 1) & mask) {
+        uint32_t entry = index->at(slot);
+
+        if (entry == 0) {
+            return false;
+        }
+
+        if (entry - 1 < count && at(entry - 1) == code) {
+            position = entry - 1;
+            return true;
+        }
+    }
+}
+
+CodeTable::CodeTable(bool _indexed) : count(0), indexed(_indexed) {}
+
+void CodeTable::clear() {
+    chunks.clear();
+    index.reset();
+    count = 0;
+}
+
+void CodeTable::push_back(string_view code) {
+    if (count % CODE_CHUNK == 0) {
+        chunks.push_back(make_shared<CodeChunk>());
+    }
+    chunks.back()->codes[count % CODE_CHUNK] = code.to_string();
+    count++;
+
+    if (!indexed) {
+        return;
+    }
+
+    // An index half full is replaced by one twice as large, lists holding the earlier index reading it as is
+    if (!index || 2 * count > index->size()) {
+        auto grown = make_shared<CodeIndex>(index ? 2 * index->size() : 2 * CODE_CHUNK);
+
+        for (size_t position = 0; position + 1 < count; position++) {
+            grown->insert(chunks[position / CODE_CHUNK]->codes[position % CODE_CHUNK], position);
+        }
+        index = grown;
+    }
+    index->insert(code, count - 1);
+}
+
+size_t CodeTable::size() const {
+    return count;
+}
+
+CodeList CodeTable::list() const {
+    return CodeList(chunks, count, index);
+}
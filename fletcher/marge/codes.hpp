@@ -0,0 +1,192 @@
+/** @file codes.hpp
+ * @brief Defines append only tables of the codes of vertices and edges, shared between the versions of the graph
+ * @details Codes of vertices and edges are never rewritten once added, an edge replacing a disabled edge keeping its code, and are only
+ * ever replaced all at once by a load. A table hence appends codes to chunks of fixed size, never moved once allocated, and a version of
+ * the graph holds a list of the chunks and of the number of codes it was published with. Versions share chunks instead of copying the
+ * codes, publishing a version copying a pointer per chunk, and read the codes listed with no lock as those are never written again.
+ *
+ * Codes of a table may be found through a hash index shared the same way. Slots of the index are written once each and hold the
+ * position of a code, hence a version probes the index of its list concurrently with updates and skips the codes added after it. The
+ * index is rebuilt anew once half full, versions listing an earlier index keeping it alive as is.
+ */
+#ifndef CODES_HPP_INCLUDED
+#define CODES_HPP_INCLUDED
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include <experimental/string_view>
+
+using namespace std;
+using std::experimental::string_view;
+
+/**
+ * @brief Number of codes held by a chunk
+ */
+const size_t CODE_CHUNK = 1024;
+
+/**
+ * @brief Codes of consecutive positions of a table
+ */
+struct CodeChunk {
+    string codes[CODE_CHUNK];
+};
+
+/**
+ * @brief Hash index of the codes of a table, by position
+ */
+class CodeIndex {
+    private:
+        /**
+         * @brief Number of slots, a power of 2
+         */
+        size_t capacity;
+
+        /**
+         * @brief Position of a code plus one per slot, 0 if empty
+         */
+        unique_ptr<atomic<uint32_t>[]> slots;
+
+    public:
+        /**
+         * @brief Constructs an empty index
+         * @param[in] : Number of slots, a power of 2
+         */
+        explicit CodeIndex(size_t);
+
+        /**
+         * @brief Fetch the number of slots
+         */
+        size_t size() const;
+
+        /**
+         * @brief Fetch the first slot probed for a code
+         */
+        size_t first(string_view) const;
+
+        /**
+         * @brief Fetch the position held by a slot plus one, 0 if empty
+         */
+        uint32_t at(size_t) const;
+
+        /**
+         * @brief Records the position of a code in the first empty slot probed
+         * @param[in] : Code
+         * @param[in] : Position of code in its table
+         */
+        void insert(string_view, uint32_t);
+};
+
+/**
+ * @brief Immutable list of the codes of a table as of a version of the graph
+ */
+class CodeList {
+    private:
+        /**
+         * @brief Chunks of the table holding the codes listed
+         */
+        vector<shared_ptr<const CodeChunk> > chunks;
+
+        /**
+         * @brief Number of codes listed
+         */
+        size_t count;
+
+        /**
+         * @brief Index of the table, if indexed
+         */
+        shared_ptr<const CodeIndex> index;
+
+    public:
+        /**
+         * @brief Constructs an empty list
+         */
+        CodeList();
+
+        /**
+         * @brief Constructs a list of the first codes of a table
+         * @param[in] : Chunks of the table
+         * @param[in] : Number of codes listed
+         * @param[in] : Index of the table, if indexed
+         */
+        CodeList(const vector<shared_ptr<CodeChunk> >&, size_t, const shared_ptr<const CodeIndex>&);
+
+        /**
+         * @brief Fetch the number of codes listed
+         */
+        size_t size() const;
+
+        /**
+         * @brief Fetch the code at a position
+         */
+        string_view at(size_t) const;
+
+        /**
+         * @brief Finds the position of a code. Requires the table to be indexed
+         * @param[in] : Code
+         * @param[out] : Position of code, if found
+         * @return True if the code is listed else False
+         */
+        bool find(string_view, size_t&) const;
+};
+
+/**
+ * @brief Append only table of codes by position, as held by the graph and updated under its mutex
+ */
+class CodeTable {
+    private:
+        /**
+         * @brief Chunks holding the codes, the last one possibly partly filled
+         */
+        vector<shared_ptr<CodeChunk> > chunks;
+
+        /**
+         * @brief Number of codes
+         */
+        size_t count;
+
+        /**
+         * @brief Flag to indicate codes are indexed
+         */
+        bool indexed;
+
+        /**
+         * @brief Index of the codes, if indexed
+         */
+        shared_ptr<CodeIndex> index;
+
+    public:
+        /**
+         * @brief Constructs an empty table
+         * @param[in] : Flag to index codes, so they may be found by lists of the table
+         */
+        explicit CodeTable(bool);
+
+        /**
+         * @brief Removes all codes, leaving the chunks and index held by lists as is
+         */
+        void clear();
+
+        /**
+         * @brief Appends a code at the next position
+         */
+        void push_back(string_view);
+
+        /**
+         * @brief Fetch the number of codes
+         */
+        size_t size() const;
+
+        /**
+         * @brief Lists the codes of the table as of now
+         */
+        CodeList list() const;
+};
+
+inline string_view CodeList::at(size_t position) const {
+    return chunks[position / CODE_CHUNK]->codes[position % CODE_CHUNK];
+}
+
+#endif
@@ -0,0 +1,98 @@
+#include <algorithm>
+#include <numeric>
+
+#include "compact.hpp"
+#include "landmarks.hpp"
+#include "timetable.hpp"
+
+CompactGraph::CompactGraph(size_t nvertices, const EdgeList& edges, uint64_t version) : built_from(version), nonnegative(true) {
+    size_t nedges = edges.size();
+    vector<uint32_t> order(nedges);
+    iota(order.begin(), order.end(), 0);
+
+    // Edges are added in order of their index but for those replacing a disabled edge, which follow the edges added before them
+    auto added_before = [&edges](uint32_t first, uint32_t second) {
+        return edges.at(first).sequence < edges.at(second).sequence;
+    };
+
+    if (!is_sorted(order.begin(), order.end(), added_before)) {
+        sort(order.begin(), order.end(), added_before);
+    }
+
+    // Edges are bucketed by source, keeping the order they were added in within a vertex
+    vector<uint32_t> offsets(nvertices + 1, 0);
+
+    for (uint32_t index: order) {
+        offsets[edges.at(index).src + 1]++;
+    }
+
+    for (size_t vertex = 0; vertex < nvertices; vertex++) {
+        offsets[vertex + 1] += offsets[vertex];
+    }
+
+    vector<pair<uint32_t, uint32_t> > endpoints(nedges);
+    vector<EdgeProperty> attributes(nedges);
+
+    for (uint32_t index: order) {
+        const EdgeEntry& edge = edges.at(index);
+        uint32_t position = offsets[edge.src]++;
+
+        endpoints[position] = make_pair(edge.src, edge.dst);
+        attributes[position] = edge.property;
+
+        Cost least = edge.property.least();
+        nonnegative = nonnegative && least.first >= 0 && least.second >= 0;
+    }
+
+    g = Compact(boost::edges_are_sorted, endpoints.begin(), endpoints.end(), attributes.begin(), nvertices);
+    build_mask(edges);
+}
+
+CompactGraph::CompactGraph(const shared_ptr<const CompactGraph>& earlier, const EdgeList& edges, uint64_t version) : shared(earlier->shared ? earlier->shared : earlier), built_from(version), nonnegative(earlier->nonnegative) {
+    build_mask(edges);
+}
+
+void CompactGraph::build_mask(const EdgeList& entries) {
+    const Compact& image = graph();
+    size_t nedges = boost::num_edges(image);
+
+    mask.assign((nedges + 63) / 64, 0);
+
+    for (auto edges = boost::edges(image); edges.first != edges.second; edges.first++) {
+        size_t edge = boost::get(boost::edge_index, image, *edges.first);
+
+        if (entries.at(image[*edges.first].index).enabled) {
+            mask[edge >> 6] |= uint64_t(1) << (edge & 63);
+        }
+    }
+}
+
+CompactGraph::~CompactGraph() {}
+
+const Compact& CompactGraph::graph() const {
+    return shared ? shared->g : g;
+}
+
+uint64_t CompactGraph::version() const {
+    return built_from;
+}
+
+bool CompactGraph::monotone() const {
+    return nonnegative;
+}
+
+const Timetable& CompactGraph::timetable() const {
+    if (shared) {
+        return shared->timetable();
+    }
+    call_once(table_built, [this]() { table.reset(new Timetable(g)); });
+    return *table;
+}
+
+const Landmarks& CompactGraph::landmarks() const {
+    if (shared) {
+        return shared->landmarks();
+    }
+    call_once(bounds_built, [this]() { bounds.reset(new Landmarks(g)); });
+    return *bounds;
+}
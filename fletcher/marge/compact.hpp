@@ -0,0 +1,165 @@
+/** @file compact.hpp
+ * @brief Defines an immutable, compressed sparse row image of the graph traversed by solvers
+ * @details The mutable adjacency_list holds each out edge as a separate allocation. Solvers instead traverse a compressed sparse row image
+ * holding an offset per vertex and a target and EdgeProperty per edge in contiguous arrays, with out edges of a vertex adjacent in memory.
+ * The image is built from the edges listed by a version of the graph once, as the version is first traversed, and shared by all views of
+ * that version.
+ *
+ * Disabled edges are held in the image along with enabled ones and masked out by a bit per edge, hence a version differing from an
+ * earlier one by the state of its edges alone shares the structure and indices of the earlier image and only copies its mask.
+ */
+#ifndef COMPACT_HPP_INCLUDED
+#define COMPACT_HPP_INCLUDED
+
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <boost/graph/compressed_sparse_row_graph.hpp>
+
+#include "graph.hpp"
+
+typedef boost::compressed_sparse_row_graph<boost::directedS, boost::no_property, EdgeProperty, boost::no_property, uint32_t, uint32_t> Compact;
+typedef boost::graph_traits<Compact>::vertex_descriptor CompactVertex;
+typedef boost::graph_traits<Compact>::edge_descriptor CompactEdgeDescriptor;
+
+class Landmarks;
+class Timetable;
+
+/**
+ * @brief Immutable compressed sparse row image of a version of the graph
+ * @details Vertices keep their index in the adjacency_list and out edges of each vertex keep the order they were added to it in, hence
+ * traversals visit edges in the same order as they would in the adjacency_list. The image holds no codes, which are resolved through a GraphView once a path is
+ * materialized.
+ *
+ * Indices over the image required by a single solver are built on first use only and live as long as the image.
+ */
+class CompactGraph {
+    private:
+        /**
+         * @brief Offsets, targets and attributes of edges, empty if shared
+         */
+        Compact g;
+
+        /**
+         * @brief Image whose structure and indices are shared, or nullptr if held by this image
+         */
+        shared_ptr<const CompactGraph> shared;
+
+        /**
+         * @brief Version of the graph the image was built from
+         */
+        uint64_t built_from;
+
+        /**
+         * @brief Bit per edge, by its index in the image, set if the edge is enabled
+         */
+        vector<uint64_t> mask;
+
+        /**
+         * @brief Flag to indicate every edge, enabled or not, traverses in non negative time and cost
+         */
+        bool nonnegative;
+
+        /**
+         * @brief Connections of the image sorted by departure, built on first use
+         */
+        mutable unique_ptr<const Timetable> table;
+
+        /**
+         * @brief Flag serializing the build of the timetable between readers
+         */
+        mutable once_flag table_built;
+
+        /**
+         * @brief Lower bounds between vertices of the image, built on first use
+         */
+        mutable unique_ptr<const Landmarks> bounds;
+
+        /**
+         * @brief Flag serializing the build of the lower bounds between readers
+         */
+        mutable once_flag bounds_built;
+
+        /**
+         * @brief Sets the bit of each edge of the image to the state of its edge in the version
+         * @param[in] : Edges of the version, indexed by EdgeProperty::index
+         */
+        void build_mask(const EdgeList&);
+
+    public:
+        /**
+         * @brief Builds the image of a version of the graph
+         * @param[in] : Number of vertices
+         * @param[in] : Edges of the version, disabled edges included, indexed by EdgeProperty::index
+         * @param[in] : Version of the graph
+         */
+        CompactGraph(size_t, const EdgeList&, uint64_t);
+
+        /**
+         * @brief Builds the image of a version of the graph differing from an earlier version by the state of its edges alone
+         * @param[in] : Image of the earlier version, whose structure and indices are shared
+         * @param[in] : Edges of the version, indexed by EdgeProperty::index
+         * @param[in] : Version of the graph
+         */
+        CompactGraph(const shared_ptr<const CompactGraph>&, const EdgeList&, uint64_t);
+
+        /**
+         * @brief Destroys the image along with its indices
+         */
+        ~CompactGraph();
+
+        /**
+         * @brief Fetch the compressed sparse row graph, holding disabled edges as well
+         */
+        const Compact& graph() const;
+
+        /**
+         * @brief Checks if an edge is enabled
+         * @param[in] : Index of edge in the image
+         */
+        bool enabled(uint32_t) const;
+
+        /**
+         * @brief Checks if an edge is enabled
+         * @param[in] : Edge of the image
+         */
+        bool enabled(const CompactEdgeDescriptor&) const;
+
+        /**
+         * @brief Fetch the version of the graph the image was built from
+         */
+        uint64_t version() const;
+
+        /**
+         * @brief Checks if every edge of the image traverses in non negative time and cost at any time of day
+         * @details Searches over such an image settle vertices in non decreasing order of their keys, hence may use monotone queues.
+         */
+        bool monotone() const;
+
+        /**
+         * @brief Fetch the timetable of the image, building it if not built yet
+         * @details The timetable holds disabled edges as well, which are to be checked against the mask
+         * @return Constant reference to the timetable, valid for the lifetime of the image
+         */
+        const Timetable& timetable() const;
+
+        /**
+         * @brief Fetch the lower bounds between vertices of the image, building them if not built yet
+         * @details Bounds are found over disabled edges as well, hence remain lower bounds whichever edges are enabled
+         * @return Constant reference to the lower bounds, valid for the lifetime of the image
+         */
+        const Landmarks& landmarks() const;
+};
+
+// Masks are checked inline, once per edge relaxed
+inline bool CompactGraph::enabled(uint32_t edge) const {
+    return (mask[edge >> 6] >> (edge & 63)) & 1;
+}
+
+inline bool CompactGraph::enabled(const CompactEdgeDescriptor& edge) const {
+    return enabled(uint32_t(edge.idx));
+}
+
+#endif
@@ -0,0 +1,482 @@
+#include <algorithm>
+#include <functional>
+
+#include "contraction.hpp"
+#include "timetable.hpp"
+
+/**
+ * @brief Queue and workspaces of the searches of a thread, reused across searches
+ */
+static thread_local ArrivalQueue arrival_queue;
+static thread_local HierarchyWorkspace hierarchy_workspace;
+static thread_local Workspace workspace;
+
+void ArrivalQueue::clear() {
+    heap.clear();
+}
+
+bool ArrivalQueue::empty() const {
+    return heap.empty();
+}
+
+void ArrivalQueue::push(long arrival, uint32_t vertex) {
+    heap.push_back(make_pair(arrival, vertex));
+    push_heap(heap.begin(), heap.end(), greater<pair<long, uint32_t> >());
+}
+
+pair<long, uint32_t> ArrivalQueue::pop() {
+    pop_heap(heap.begin(), heap.end(), greater<pair<long, uint32_t> >());
+    auto entry = heap.back();
+    heap.pop_back();
+    return entry;
+}
+
+void HierarchyWorkspace::reset(size_t nvertices) {
+    for (uint32_t vertex: descents) {
+        descending[vertex] = false;
+        pending[vertex] = false;
+        descended[vertex] = P_L_INF;
+        descended_via[vertex] = Shortcut{NO_VIA, 0};
+    }
+
+    for (uint32_t vertex: touched) {
+        ascended[vertex] = P_L_INF;
+    }
+
+    descents.clear();
+    touched.clear();
+
+    if (ascended.size() < nvertices) {
+        ascended.resize(nvertices, P_L_INF);
+        descended.resize(nvertices, P_L_INF);
+        ascended_via.resize(nvertices);
+        descended_via.resize(nvertices, Shortcut{NO_VIA, 0});
+        descending.resize(nvertices, false);
+        pending.resize(nvertices, false);
+    }
+}
+
+void HierarchyWorkspace::ascend(uint32_t vertex, long arrival, const Shortcut& via) {
+    if (ascended[vertex] == P_L_INF) {
+        touched.push_back(vertex);
+    }
+    ascended[vertex] = arrival;
+    ascended_via[vertex] = via;
+}
+
+bool HierarchyWorkspace::descend(uint32_t vertex) {
+    if (descending[vertex]) {
+        return false;
+    }
+    descending[vertex] = true;
+    descents.push_back(vertex);
+    return true;
+}
+
+/**
+ * @brief Replaces an edge or shortcut of a hierarchy by the edges of the graph it is made of
+ * @param[in] : Hierarchy of the graph
+ * @param[in] : Source vertex of the shortcut
+ * @param[in] : Target vertex of the shortcut
+ * @param[in] : Index of the function of the shortcut
+ * @param[in] : Time of arrival at source vertex
+ * @param[in,out] : Edges of the graph traversed, to which edges of the shortcut are appended
+ * @return Time of arrival at target vertex
+ */
+static long unpack(const Hierarchy& hierarchy, uint32_t source, uint32_t target, uint32_t function, long arrival, vector<Hop>& hops) {
+    Leg taken;
+    long reached = hierarchy.function(function).arrival(arrival, taken);
+
+    if (taken.via == NO_VIA) {
+        hops.push_back(Hop{source, taken.edge, arrival});
+        return reached;
+    }
+
+    // Functions compose exactly, hence descending into the contracted vertex arrives at the time the shortcut does
+    long midway = unpack(hierarchy, source, taken.via, hierarchy.between(source, taken.via), arrival, hops);
+    return unpack(hierarchy, taken.via, target, hierarchy.between(taken.via, target), midway, hops);
+}
+
+ContractionHierarchy::ContractionHierarchy() : any_requested(false), latest_requested(0), stopping(false), builder(&ContractionHierarchy::build, this) {}
+
+ContractionHierarchy::~ContractionHierarchy() {
+    {
+        lock_guard<mutex> hierarchy_lock(hierarchy_mutex);
+        stopping = true;
+    }
+    requested.notify_all();
+    builder.join();
+}
+
+void ContractionHierarchy::build() {
+    unique_lock<mutex> hierarchy_lock(hierarchy_mutex);
+
+    while (true) {
+        requested.wait(hierarchy_lock, [this]() { return stopping || pending; });
+
+        if (stopping) {
+            return;
+        }
+
+        shared_ptr<const CompactGraph> image = move(pending);
+        shared_ptr<const Hierarchy> earlier = hierarchy;
+        pending.reset();
+        hierarchy_lock.unlock();
+
+        shared_ptr<const Hierarchy> built;
+
+        // Queries keep falling back to Dijkstra should contraction fail, until a later version is requested
+        try {
+            built = make_shared<const Hierarchy>(*image, earlier.get());
+        }
+        catch (const exception&) {}
+
+        hierarchy_lock.lock();
+
+        if (built && (!hierarchy || hierarchy->version() < built->version())) {
+            hierarchy = built;
+        }
+    }
+}
+
+shared_ptr<const Hierarchy> ContractionHierarchy::current(const GraphView& view) const {
+    shared_ptr<const CompactGraph> image = view.compacted();
+    lock_guard<mutex> hierarchy_lock(hierarchy_mutex);
+
+    if (hierarchy && hierarchy->version() == image->version()) {
+        return hierarchy;
+    }
+
+    // Versions only ever grow, hence a view of a version older than the one requested last is left to Dijkstra
+    if (!any_requested || latest_requested < image->version()) {
+        any_requested = true;
+        latest_requested = image->version();
+        pending = image;
+        requested.notify_one();
+    }
+    return nullptr;
+}
+
+bool ContractionHierarchy::run_query(const Hierarchy& hierarchy, ArrivalQueue& queue, HierarchyWorkspace& search, Vertex src, const vector<Vertex>& dsts, long t_start, long t_max, const function<bool(Vertex, long, const vector<Hop>&)>& settled) const {
+    search.reset(hierarchy.vertices());
+    queue.clear();
+
+    // Vertices from which any destination is descended to, along with destinations themselves
+    size_t remaining = 0;
+
+    for (Vertex dst: dsts) {
+        if (!search.pending[dst]) {
+            search.pending[dst] = true;
+            search.descend(dst);
+            remaining++;
+        }
+    }
+
+    for (size_t position = 0; position < search.descents.size(); position++) {
+        for (auto edges = hierarchy.downward_into(search.descents[position]); edges.first != edges.second; edges.first++) {
+            search.descend(edges.first->head);
+        }
+    }
+
+    search.ascend(src, t_start, Shortcut{NO_VIA, 0});
+    queue.push(t_start, src);
+
+    while (!queue.empty()) {
+        auto current = queue.pop();
+
+        if (current.first > search.ascended[current.second]) {
+            continue;
+        }
+
+        for (auto edges = hierarchy.upward(current.second); edges.first != edges.second; edges.first++) {
+            long arrival = hierarchy.function(edges.first->function).arrival(current.first);
+
+            if (arrival <= t_max && arrival < search.ascended[edges.first->head]) {
+                search.ascend(edges.first->head, arrival, Shortcut{current.second, edges.first->function});
+                queue.push(arrival, edges.first->head);
+            }
+        }
+    }
+
+    // Every vertex ascended to from which a destination is descended to starts the descent
+    for (uint32_t vertex: search.descents) {
+        if (search.ascended[vertex] != P_L_INF) {
+            search.descended[vertex] = search.ascended[vertex];
+            queue.push(search.ascended[vertex], vertex);
+        }
+    }
+
+    vector<pair<uint32_t, Shortcut> > traversed;
+    vector<Hop> hops;
+
+    // Edges of the hierarchy from a destination back to source, descended first then ascended, unpacked into edges of the graph
+    auto trace = [&](uint32_t destination) {
+        traversed.clear();
+        hops.clear();
+        uint32_t current = destination;
+
+        while (search.descended_via[current].head != NO_VIA) {
+            traversed.push_back(make_pair(current, search.descended_via[current]));
+            current = search.descended_via[current].head;
+        }
+
+        while (current != src) {
+            traversed.push_back(make_pair(current, search.ascended_via[current]));
+            current = search.ascended_via[current].head;
+        }
+
+        long arrival = t_start;
+
+        for (auto edge = traversed.rbegin(); edge != traversed.rend(); edge++) {
+            arrival = unpack(hierarchy, edge->second.head, edge->first, edge->second.function, arrival, hops);
+        }
+        return arrival;
+    };
+
+    // Destinations settled at the same time as the one the search is stopped at are settled as well
+    long stopped_at = P_L_INF;
+
+    while (!queue.empty()) {
+        auto current = queue.pop();
+
+        if (current.first > search.descended[current.second]) {
+            continue;
+        }
+
+        if (current.first > stopped_at) {
+            break;
+        }
+
+        if (search.pending[current.second]) {
+            search.pending[current.second] = false;
+
+            if (settled(current.second, trace(current.second), hops)) {
+                stopped_at = current.first;
+            }
+
+            if (--remaining == 0) {
+                return true;
+            }
+        }
+
+        for (auto edges = hierarchy.downward(current.second); edges.first != edges.second; edges.first++) {
+            if (!search.descending[edges.first->head]) {
+                continue;
+            }
+
+            long arrival = hierarchy.function(edges.first->function).arrival(current.first);
+
+            if (arrival <= t_max && arrival < search.descended[edges.first->head]) {
+                search.descended[edges.first->head] = arrival;
+                search.descended_via[edges.first->head] = Shortcut{current.second, edges.first->function};
+                queue.push(arrival, edges.first->head);
+            }
+        }
+    }
+    return stopped_at != P_L_INF;
+}
+
+void ContractionHierarchy::run_dijkstra(const CompactGraph& compact, ArrivalQueue& queue, Workspace& workspace, Vertex src, const vector<Vertex>& dsts, long t_start, long t_max, const function<bool(Vertex, long, const vector<Hop>&)>& settled) const {
+    const Compact& g = compact.graph();
+    workspace.reset(boost::num_vertices(g));
+    queue.clear();
+
+    size_t remaining = 0;
+
+    for (Vertex dst: dsts) {
+        if (workspace.await(dst)) {
+            remaining++;
+        }
+    }
+
+    vector<Hop> hops;
+
+    // Cost is not optimized on, hence distances hold the time of arrival alone
+    workspace.reach(src, Cost{0, t_start}, CompactEdgeDescriptor());
+    queue.push(t_start, src);
+
+    auto trace = [&](Vertex destination) {
+        hops.clear();
+
+        for (Vertex current = destination; current != src;) {
+            CompactEdgeDescriptor inbound = workspace.predecessor(current);
+            current = boost::source(inbound, g);
+            hops.push_back(Hop{uint32_t(current), uint32_t(boost::get(boost::edge_index, g, inbound)), workspace.distance(current).second});
+        }
+
+        std::reverse(hops.begin(), hops.end());
+        return workspace.distance(destination).second;
+    };
+
+    long stopped_at = P_L_INF;
+
+    while (!queue.empty()) {
+        auto current = queue.pop();
+
+        if (current.first > workspace.distance(current.second).second) {
+            continue;
+        }
+
+        if (current.first > stopped_at) {
+            break;
+        }
+
+        if (workspace.arrive(current.second)) {
+            if (settled(current.second, trace(current.second), hops)) {
+                stopped_at = current.first;
+            }
+
+            if (--remaining == 0) {
+                break;
+            }
+        }
+
+        for (auto edges = boost::out_edges(CompactVertex(current.second), g); edges.first != edges.second; edges.first++) {
+            if (!compact.enabled(*edges.first)) {
+                continue;
+            }
+
+            const EdgeProperty& eprop = g[*edges.first];
+            uint32_t target = boost::target(*edges.first, g);
+            long arrival = departure_after(eprop, current.first) + (eprop.percon ? eprop._tip + eprop._tap + eprop._top : eprop.dur);
+
+            if ((eprop.percon || arrival <= t_max) && arrival < workspace.distance(target).second) {
+                workspace.reach(target, Cost{0, arrival}, *edges.first);
+                queue.push(arrival, target);
+            }
+        }
+    }
+}
+
+void ContractionHierarchy::run_search(const GraphView& view, Vertex src, const vector<Vertex>& dsts, long t_start, long t_max, const function<bool(Vertex, long, const vector<Hop>&)>& settled) const {
+    shared_ptr<const Hierarchy> built = current(view);
+
+    if (!built) {
+        run_dijkstra(view.compact(), arrival_queue, workspace, src, dsts, t_start, t_max, settled);
+        return;
+    }
+
+    if (run_query(*built, arrival_queue, hierarchy_workspace, src, dsts, t_start, t_max, settled) || !built->continuous()) {
+        return;
+    }
+
+    // Destinations arrived at by the time limit are all settled, hence those left are only arrived at by continuous edges past it
+    vector<Vertex> unsettled;
+
+    for (Vertex dst: dsts) {
+        if (hierarchy_workspace.pending[dst]) {
+            hierarchy_workspace.pending[dst] = false;
+            unsettled.push_back(dst);
+        }
+    }
+    run_dijkstra(view.compact(), arrival_queue, workspace, src, unsettled, t_start, t_max, settled);
+}
+
+vector<Path> ContractionHierarchy::to_path(const GraphView& view, Vertex destination, long arrival, const vector<Hop>& hops) const {
+    const Compact& g = view.compact().graph();
+    vector<Path> path;
+    double cost = 0;
+
+    for (auto const& hop: hops) {
+        CompactEdgeDescriptor edge(hop.src, hop.edge);
+        const EdgeProperty& eprop = g[edge];
+        long expected_by = departure_after(eprop, hop.arrival);
+        long departure = expected_by + eprop._tap + eprop._top;
+        path.push_back(Path{view.vertex_code(hop.src), view.edge_code(eprop), view.vertex_code(boost::target(edge, g)), hop.arrival, expected_by, departure, cost});
+
+        if (!eprop.percon) {
+            cost += eprop.cost;
+        }
+    }
+
+    path.push_back(Path{view.vertex_code(destination), "", "", arrival, P_L_INF, P_L_INF, cost});
+    return path;
+}
+
+void ContractionHierarchy::resolve(const GraphView& view, string_view src, const vector<pair<string_view, long> >& targets, Vertex& source, vector<Vertex>& destinations, map<long, vector<size_t> >& limits) const {
+    if (!view.vertex(src, source)) {
+        throw invalid_argument("No source <> found");
+    }
+
+    destinations.resize(targets.size());
+
+    for (size_t index = 0; index < targets.size(); index++) {
+        if (!view.vertex(targets[index].first, destinations[index])) {
+            throw invalid_argument("No destination<> found");
+        }
+        limits[targets[index].second].push_back(index);
+    }
+}
+
+vector<Path> ContractionHierarchy::find_path(const GraphView& view, string_view src, string_view dst, long t_start, long t_max) const {
+    return find_paths(view, src, t_start, vector<pair<string_view, long> >{make_pair(dst, t_max)}).front();
+}
+
+vector<vector<Path> > ContractionHierarchy::find_paths(const GraphView& view, string_view src, long t_start, const vector<pair<string_view, long> >& targets) const {
+    Vertex source;
+    vector<Vertex> destinations;
+    map<long, vector<size_t> > limits;
+    resolve(view, src, targets, source, destinations, limits);
+
+    vector<vector<Path> > paths(targets.size());
+
+    // Continuous edges are followed past the time limit, hence destinations under different limits are searched for separately
+    for (auto const& limit: limits) {
+        vector<Vertex> dsts;
+
+        for (size_t index: limit.second) {
+            dsts.push_back(destinations[index]);
+        }
+
+        auto settled = [&](Vertex vertex, long arrival, const vector<Hop>& hops) {
+            for (size_t index: limit.second) {
+                if (destinations[index] == vertex) {
+                    paths[index] = to_path(view, vertex, arrival, hops);
+                }
+            }
+            return false;
+        };
+
+        run_search(view, source, dsts, t_start, limit.first, settled);
+    }
+    return paths;
+}
+
+vector<Path> ContractionHierarchy::find_nearest(const GraphView& view, string_view src, long t_start, const vector<pair<string_view, long> >& targets, size_t& nearest) const {
+    Vertex source;
+    vector<Vertex> destinations;
+    map<long, vector<size_t> > limits;
+    resolve(view, src, targets, source, destinations, limits);
+
+    vector<Path> path;
+    nearest = targets.size();
+
+    for (auto const& limit: limits) {
+        vector<Vertex> dsts;
+
+        for (size_t index: limit.second) {
+            dsts.push_back(destinations[index]);
+        }
+
+        // Destinations are settled in order of arrival, those settled along with the first being compared on cost
+        auto settled = [&](Vertex vertex, long arrival, const vector<Hop>& hops) {
+            for (size_t index: limit.second) {
+                if (destinations[index] != vertex) {
+                    continue;
+                }
+
+                auto candidate = to_path(view, vertex, arrival, hops);
+                auto reached = make_pair(candidate.back().arr, candidate.back().cost);
+
+                if (nearest == targets.size() || reached < make_pair(path.back().arr, path.back().cost) || (reached == make_pair(path.back().arr, path.back().cost) && index < nearest)) {
+                    nearest = index;
+                    path = move(candidate);
+                }
+            }
+            return nearest != targets.size();
+        };
+
+        run_search(view, source, dsts, t_start, limit.first, settled);
+    }
+    return path;
+}
@@ -0,0 +1,317 @@
+/** @file contraction.hpp
+ * @brief Defines an earliest arrival path solver querying a time-dependent contraction hierarchy of the graph
+ * @details The hierarchy of each version of the graph is contracted on a thread of the solver, while queries against that version are
+ * answered by a plain time-dependent Dijkstra traversal of the compact image.
+ */
+#ifndef CONTRACTION_HPP_INCLUDED
+#define CONTRACTION_HPP_INCLUDED
+
+#include <condition_variable>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <thread>
+
+#include "compact.hpp"
+#include "hierarchy.hpp"
+#include "solver.hpp"
+#include "workspace.hpp"
+
+/**
+ * @brief An edge of the graph traversed by a path, as found by ContractionHierarchy
+ */
+struct Hop {
+    /**
+     * @brief Source vertex of edge
+     */
+    uint32_t src;
+
+    /**
+     * @brief Index of edge in the compact image
+     */
+    uint32_t edge;
+
+    /**
+     * @brief Time of arrival at source vertex
+     */
+    long arrival;
+};
+
+/**
+ * @brief Binary heap of vertices ordered by earliest time of arrival first
+ * @details Cleared but not released, hence a queue reused across searches stops allocating once grown.
+ */
+struct ArrivalQueue {
+    /**
+     * @brief Times of arrival paired with their vertex, ordered as a binary heap with the earliest at front
+     */
+    vector<pair<long, uint32_t> > heap;
+
+    /**
+     * @brief Empties the queue, keeping its storage
+     */
+    void clear();
+
+    /**
+     * @brief Checks if no vertex is queued
+     */
+    bool empty() const;
+
+    /**
+     * @brief Queues a vertex
+     * @param[in] : Time of arrival at vertex
+     * @param[in] : Vertex
+     */
+    void push(long, uint32_t);
+
+    /**
+     * @brief Removes the vertex arrived at earliest from the queue
+     * @return Time of arrival paired with vertex
+     */
+    pair<long, uint32_t> pop();
+};
+
+/**
+ * @brief Arrivals at vertices for one query of a hierarchy at a time, held as parallel arrays by vertex
+ * @details Only vertices ascended to or marked descending by a query are reset before the next, hence a query takes as long as the
+ * vertices it touches rather than as the hierarchy is large. A workspace is meant to be held per thread, as it is not synchronized.
+ */
+struct HierarchyWorkspace {
+    /**
+     * @brief Time of arrival per vertex ascended to from source, P_L_INF if none
+     */
+    vector<long> ascended;
+
+    /**
+     * @brief Time of arrival per vertex descended to, P_L_INF if none
+     */
+    vector<long> descended;
+
+    /**
+     * @brief Edge of the hierarchy each vertex was ascended to via, valid for vertices ascended to other than source only
+     */
+    vector<Shortcut> ascended_via;
+
+    /**
+     * @brief Edge of the hierarchy each vertex was descended to via, NO_VIA as head if none
+     */
+    vector<Shortcut> descended_via;
+
+    /**
+     * @brief Flag per vertex to indicate a destination is descended to from it, or it is one
+     */
+    vector<uint8_t> descending;
+
+    /**
+     * @brief Flag per vertex to indicate it is a destination not settled yet
+     */
+    vector<uint8_t> pending;
+
+    /**
+     * @brief Vertices marked descending since the last reset, destinations first
+     */
+    vector<uint32_t> descents;
+
+    /**
+     * @brief Vertices ascended to since the last reset
+     */
+    vector<uint32_t> touched;
+
+    /**
+     * @brief Starts a query, no vertex being ascended to, descended to or marked
+     * @param[in] : Number of vertices of the hierarchy queried. Arrays are grown to it if shorter, never shrunk
+     */
+    void reset(size_t);
+
+    /**
+     * @brief Records the arrival at a vertex ascended to
+     * @param[in] : Vertex
+     * @param[in] : Time of arrival
+     * @param[in] : Edge of the hierarchy ascended via
+     */
+    void ascend(uint32_t, long, const Shortcut&);
+
+    /**
+     * @brief Marks a vertex as descending
+     * @return True if the vertex was not marked yet
+     */
+    bool descend(uint32_t);
+};
+
+/**
+ * @brief Implements Solver as an earliest arrival search over a time-dependent contraction hierarchy
+ * @details Edges are traversed under the same rules as ConnectionScan, hence both arrive at destination at the same time. Cost is carried
+ * along the path of earliest arrival but is not optimized on.
+ *
+ * The first query against a version of the graph requests its hierarchy, which is then contracted in the background, reusing the order
+ * of contraction of the latest hierarchy built. Queries are answered by a time-dependent Dijkstra traversal until the hierarchy of their
+ * version is built.
+ */
+class ContractionHierarchy : public Solver {
+    private:
+        /**
+         * @brief Mutex guarding the hierarchy, the image pending contraction and the flag to stop
+         */
+        mutable mutex hierarchy_mutex;
+
+        /**
+         * @brief Condition signalled as an image is requested to be contracted, or as the solver stops
+         */
+        mutable condition_variable requested;
+
+        /**
+         * @brief Latest hierarchy built
+         */
+        mutable shared_ptr<const Hierarchy> hierarchy;
+
+        /**
+         * @brief Image of the graph waiting to be contracted, if any
+         */
+        mutable shared_ptr<const CompactGraph> pending;
+
+        /**
+         * @brief Flag to indicate any version of the graph has been requested to be contracted
+         */
+        mutable bool any_requested;
+
+        /**
+         * @brief Latest version of the graph requested to be contracted
+         */
+        mutable uint64_t latest_requested;
+
+        /**
+         * @brief Flag to stop contracting
+         */
+        bool stopping;
+
+        /**
+         * @brief Thread contracting images as they are requested
+         */
+        thread builder;
+
+        /**
+         * @brief Contracts images as they are requested, until the solver stops
+         */
+        void build();
+
+        /**
+         * @brief Fetch the hierarchy of the version of the graph viewed, requesting it to be contracted if not built yet
+         * @param[in] : Read only view of the graph
+         * @return Hierarchy of the version viewed, or nullptr if not built yet
+         */
+        shared_ptr<const Hierarchy> current(const GraphView&) const;
+
+        /**
+         * @brief Earliest arrival search over a hierarchy
+         * @details Searches upward from source, then downward to destinations from every vertex reached, following only edges from
+         * which a destination can be descended to. The search stops once every destination vertex has been settled, or once the
+         * callback asks to stop and every destination vertex arrived at by then has been settled.
+         *
+         * Shortcuts only keep the legs arriving earliest regardless of the time limit, hence the search never follows an edge or
+         * shortcut past the time limit, and destinations only reachable by continuous edges arriving past it are left unsettled.
+         * @param[in] : Hierarchy of the graph
+         * @param[in,out] : Queue of vertices by time of arrival, cleared by the query
+         * @param[in,out] : Workspace to record arrivals at vertices in, reset by the query
+         * @param[in] : Source vertex
+         * @param[in] : Destination vertices
+         * @param[in] : Time of arrival at source vertex
+         * @param[in] : Maximum time by which the destination vertices must be reached
+         * @param[in] : Callback invoked with each destination vertex as it is settled, along with its time of arrival and the edges of
+         * the graph traversed to it, with the time of arrival at their source. Returns true to stop the search
+         * @return True if the callback asked to stop or every destination vertex has been settled, false if any is left unsettled
+         */
+        bool run_query(const Hierarchy&, ArrivalQueue&, HierarchyWorkspace&, Vertex, const vector<Vertex>&, long, long, const function<bool(Vertex, long, const vector<Hop>&)>&) const;
+
+        /**
+         * @brief Earliest arrival time-dependent Dijkstra traversal of the compact image
+         * @details Stops as run_query does. As with ConnectionScan, only edges departing once a day need to arrive by the time limit,
+         * continuous edges being followed past it.
+         * @param[in] : Compact image of the graph
+         * @param[in,out] : Queue of vertices by time of arrival, cleared by the traversal
+         * @param[in,out] : Workspace to record the time of arrival at vertices and the edges they are arrived at via in, reset by the
+         * traversal
+         * @param[in] : Source vertex
+         * @param[in] : Destination vertices
+         * @param[in] : Time of arrival at source vertex
+         * @param[in] : Maximum time by which the destination vertices must be reached
+         * @param[in] : Callback invoked with each destination vertex as it is settled, as by run_query
+         */
+        void run_dijkstra(const CompactGraph&, ArrivalQueue&, Workspace&, Vertex, const vector<Vertex>&, long, long, const function<bool(Vertex, long, const vector<Hop>&)>&) const;
+
+        /**
+         * @brief Searches the hierarchy of the version of the graph viewed, or its compact image until the hierarchy is built
+         * @details Destinations left unsettled by the hierarchy are searched for by traversing the compact image.
+         * @param[in] : Read only view of the graph
+         * @param[in] : Source vertex
+         * @param[in] : Destination vertices
+         * @param[in] : Time of arrival at source vertex
+         * @param[in] : Maximum time by which the destination vertices must be reached
+         * @param[in] : Callback invoked with each destination vertex as it is settled, as by run_query
+         */
+        void run_search(const GraphView&, Vertex, const vector<Vertex>&, long, long, const function<bool(Vertex, long, const vector<Hop>&)>&) const;
+
+        /**
+         * @brief Builds the path to a destination from the edges of the graph traversed
+         * @param[in] : Read only view of the graph
+         * @param[in] : Destination vertex
+         * @param[in] : Time of arrival at destination vertex
+         * @param[in] : Edges of the graph traversed, with the time of arrival at their source
+         * @return Path as returned by find_path
+         */
+        vector<Path> to_path(const GraphView&, Vertex, long, const vector<Hop>&) const;
+
+        /**
+         * @brief Finds the source and destination vertices of a query, grouping destinations by their time limit
+         * @param[in] : Read only view of the graph
+         * @param[in] : Name of source vertex
+         * @param[in] : Names of destination vertices paired with the time limit by which each needs to be arrived at
+         * @param[out] : Source vertex
+         * @param[out] : Destination vertices
+         * @param[out] : Indices of destinations by time limit
+         */
+        void resolve(const GraphView&, string_view, const vector<pair<string_view, long> >&, Vertex&, vector<Vertex>&, map<long, vector<size_t> >&) const;
+
+    public:
+        /**
+         * @brief Constructs the solver, starting its thread contracting images
+         */
+        ContractionHierarchy();
+
+        /**
+         * @brief Stops the thread contracting images, waiting for any contraction in progress
+         */
+        ~ContractionHierarchy();
+
+        /**
+         * @brief Implementation of path finder declared in Solver
+         * @param[in] : Read only view of the graph to traverse
+         * @param[in] : Name of source vertex
+         * @param[in] : Name of destination vertex
+         * @param[in] : Time of arrival at source vertex
+         * @param[in] : Time limit by which destination vertex needs to be arrived at
+         */
+        vector<Path> find_path(const GraphView&, string_view, string_view, long, long) const;
+
+        /**
+         * @brief Implementation of the multi destination path finder declared in Solver
+         * @details Destinations sharing a time limit share a single search.
+         * @param[in] : Read only view of the graph to traverse
+         * @param[in] : Name of source vertex
+         * @param[in] : Time of arrival at source vertex
+         * @param[in] : Names of destination vertices paired with the time limit by which each needs to be arrived at
+         */
+        vector<vector<Path> > find_paths(const GraphView&, string_view, long, const vector<pair<string_view, long> >&) const;
+
+        /**
+         * @brief Implementation of the nearest destination path finder declared in Solver
+         * @details Destinations sharing a time limit share a single search, stopped once the first of them is settled.
+         * @param[in] : Read only view of the graph to traverse
+         * @param[in] : Name of source vertex
+         * @param[in] : Time of arrival at source vertex
+         * @param[in] : Names of destination vertices paired with the time limit by which each needs to be arrived at
+         * @param[out] : Index of the nearest destination, or the number of destinations if none is reachable
+         */
+        vector<Path> find_nearest(const GraphView&, string_view, long, const vector<pair<string_view, long> >&, size_t&) const;
+};
+
+#endif
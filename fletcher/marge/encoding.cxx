@@ -0,0 +1,60 @@
+#include <climits>
+#include <cstring>
+
+#include <jeayeson/jeayeson.hpp>
+
+#include "encoding.hpp"
+
+BinaryWriter::BinaryWriter(string& _out) : out(_out) {}
+
+void BinaryWriter::put_byte(unsigned char value) {
+    out.push_back(char(value));
+}
+
+void BinaryWriter::put_varint(uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(char((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    out.push_back(char(value));
+}
+
+void BinaryWriter::put_integer(long value) {
+    uint64_t bits = uint64_t(int64_t(value));
+
+    for (size_t i = 0; i < 8; i++) {
+        out.push_back(char((bits >> (CHAR_BIT * i)) & 0xFF));
+    }
+}
+
+void BinaryWriter::put_real(double value) {
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+
+    for (size_t i = 0; i < 8; i++) {
+        out.push_back(char((bits >> (CHAR_BIT * i)) & 0xFF));
+    }
+}
+
+void BinaryWriter::put_text(string_view value) {
+    put_varint(value.size());
+    out.append(value.data(), value.size());
+}
+
+void BinaryWriter::put_raw(string_view value) {
+    out.append(value.data(), value.size());
+}
+
+string error_response(ResponseFormat format, const string& error) {
+    if (format == FORMAT_BINARY) {
+        string body;
+        BinaryWriter writer{body};
+        writer.put_byte(BINARY_ERROR);
+        writer.put_text(error);
+        return body;
+    }
+
+    json_map response;
+    response["error"] = error;
+    return response.to_string();
+}
@@ -0,0 +1,99 @@
+/** @file encoding.hpp
+ * @brief Defines the formats responses are serialized to and a writer for the binary format
+ * @details A binary response starts with a ResponseKind, whereas a json response always starts with '{', hence a client can tell them
+ * apart by the first byte of the body. All integers are little endian.
+ * - BINARY_ERROR: A varint length followed by as many characters describing the error
+ * - BINARY_PATH: A varint number of segments, each consisting of
+ *   - Source vertex, edge and destination vertex, each as a varint length followed by as many characters
+ *   - Time of arrival at source, minimum time of arrival at source and time of departure from source as 8 byte integers
+ *   - Cost of reaching source as an 8 byte IEEE 754 double
+ * - BINARY_PATHS: A varint number of responses, each a complete BINARY_PATH or BINARY_ERROR response
+ * - BINARY_APPROXIMATE_PATH: As BINARY_PATH, for a path found within the tolerance of a query rather than exactly
+ *
+ * Varints are unsigned LEB128, i.e. 7 bits per byte, least significant first, with the high bit set on all but the last byte.
+ */
+#ifndef ENCODING_HPP_INCLUDED
+#define ENCODING_HPP_INCLUDED
+
+#include <cstdint>
+#include <string>
+#include <experimental/string_view>
+
+using namespace std;
+using std::experimental::string_view;
+
+/**
+ * @brief Formats a response can be serialized to
+ */
+enum ResponseFormat {
+    FORMAT_JSON,
+    FORMAT_BINARY
+};
+
+/**
+ * @brief Kinds of binary responses, leading their body
+ */
+enum ResponseKind : unsigned char {
+    BINARY_ERROR = 0,
+    BINARY_PATH = 1,
+    BINARY_PATHS = 2,
+    BINARY_APPROXIMATE_PATH = 3
+};
+
+/**
+ * @brief Appends fields of a binary response to a string
+ */
+class BinaryWriter {
+    private:
+        /**
+         * @brief String to which fields are appended
+         */
+        string& out;
+
+    public:
+        /**
+         * @brief Constructs a writer appending to a string
+         * @param[in,out] : String to which fields are appended
+         */
+        BinaryWriter(string&);
+
+        /**
+         * @brief Appends a single byte
+         */
+        void put_byte(unsigned char);
+
+        /**
+         * @brief Appends an unsigned integer as a varint
+         */
+        void put_varint(uint64_t);
+
+        /**
+         * @brief Appends an integer as 8 bytes
+         */
+        void put_integer(long);
+
+        /**
+         * @brief Appends a double as 8 bytes
+         */
+        void put_real(double);
+
+        /**
+         * @brief Appends characters prefixed with their length as a varint
+         */
+        void put_text(string_view);
+
+        /**
+         * @brief Appends raw bytes
+         */
+        void put_raw(string_view);
+};
+
+/**
+ * @brief Serializes an error in a format
+ * @param[in] : Format to serialize to
+ * @param[in] : Description of error
+ * @return Body of the response
+ */
+string error_response(ResponseFormat, const string&);
+
+#endif
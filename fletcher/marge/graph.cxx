@@ -1,7 +1,30 @@
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 #include <mutex>
+#include <numeric>
+#include <set>
 
+#include "compact.hpp"
 #include "graph.hpp"
 
+/**
+ * @brief Rounds a snapshot offset up to a multiple of 8 bytes
+ */
+static uint64_t align_section(uint64_t offset) {
+    return (offset + 7) & ~uint64_t(7);
+}
+
+/**
+ * @brief Builds the entry of an edge as seen by the versions of the graph
+ * @param[in] : Edge recorded in the table of all edges
+ * @param[in] : Position of edge in the order edges were added to graph
+ */
+static EdgeEntry edge_entry(const EdgeAll& edge, uint64_t sequence) {
+    return EdgeEntry{edge.property, uint32_t(edge.src), uint32_t(edge.dst), edge._dep, edge._dur, sequence, edge.enabled};
+}
+
 bool operator < (const Cost& first, const Cost& second) {
     if (second.second == P_L_INF) {
         return true;
@@ -16,41 +39,24 @@ VertexProperty::VertexProperty(size_t _index, string_view _code) {
     code = _code.to_string();
 }
 
-EdgeProperty::EdgeProperty(const size_t _index, const long __tip, const long __tap, const long __top, const double _cost, string_view _code) : index(_index), code(_code.to_string()), _tip(__tip), _tap(__tap), _top(__top), cost(_cost) {
+EdgeProperty::EdgeProperty(const size_t _index, const long __tip, const long __tap, const long __top, const double _cost) : index(_index), _tip(__tip), _tap(__tap), _top(__top), dep(0), dur(0), cost(_cost) {
     percon = true;
 }
 
-EdgeProperty::EdgeProperty(const size_t _index, const long __dep, const long __dur, const long __tip, const long __tap, const long __top, const double _cost, string_view _code) {
+EdgeProperty::EdgeProperty(const size_t _index, const long _dep, const long _dur, const long __tip, const long __tap, const long __top, const double _cost) {
     index = _index;
-    _dep = __dep;
-    _dur = __dur;
     _tip = __tip;
     _tap = __tap;
     _top = __top;
     cost = _cost;
-    code = _code.to_string();
 
     dep = _dep - _tap - _top;
     dur = _dur + _tap + _top + _tip;
 }
 
-EdgeProperty::EdgeProperty(const size_t _index, EdgeProperty another) {
-    index = _index;
-    _dep = another._dep;
-    _dur = another._dur;
-    _tip = another._tip;
-    _tap = another._tap;
-    _top = another._tip;
-    cost = another.cost;
-    code = another.code;
-    dep = another.dep;
-    dur = another.dur;
-}
-
-EdgeAll::EdgeAll(const size_t _index, const size_t _src, const size_t _dst, const long __tip, const long __tap, const long __top, const double _cost, string_view _code) : EdgeProperty(_index, __tip, __tap, __top, _cost, _code), src(_src), dst(_dst) {}
-
-EdgeAll::EdgeAll(const size_t _index, const size_t _src, const size_t _dst, const long __dep, const long __dur, const long __tip, const long __tap, const long __top, const double _cost, string_view _code) : EdgeProperty::EdgeProperty(_index, __dep, __dur, __tip, __tap, __top, _cost, _code), src(_src), dst(_dst)  {}
+EdgeAll::EdgeAll(const size_t _index, const size_t _src, const size_t _dst, const long __tip, const long __tap, const long __top, const double _cost, string_view _code) : property(_index, __tip, __tap, __top, _cost), code(_code.to_string()), src(_src), dst(_dst), _dep(0), _dur(0) {}
 
+EdgeAll::EdgeAll(const size_t _index, const size_t _src, const size_t _dst, const long __dep, const long __dur, const long __tip, const long __tap, const long __top, const double _cost, string_view _code) : property(_index, __dep, __dur, __tip, __tap, __top, _cost), code(_code.to_string()), src(_src), dst(_dst), _dep(__dep), _dur(__dur) {}
 
 long EdgeProperty::wait_time(const long t_departure) const {
     if (percon)
@@ -60,7 +66,7 @@ long EdgeProperty::wait_time(const long t_departure) const {
     return (t_departure_durinal > dep) ? (TIME_DURINAL - t_departure_durinal + dep) : (dep - t_departure_durinal);
 }
 
-Cost EdgeProperty::weight(const Cost& start, const long t_max) {
+Cost EdgeProperty::weight(const Cost& start, const long t_max) const {
     if (percon) {
         return Cost{start.first, start.second + _tip + _tap + _top};
     }
@@ -73,29 +79,123 @@ Cost EdgeProperty::weight(const Cost& start, const long t_max) {
     return Cost{cost_total, time_total};
 }
 
-void BaseGraph::check_kwargs(const map<string, any>& kwargs, string_view key) {
-    if (kwargs.find(key.to_string()) == kwargs.end()) {
-        char buffer[255];
-        sprintf(buffer, "Missing required argument \"%s\"", key.to_string().c_str());
-        throw invalid_argument(buffer);
+Cost EdgeProperty::least() const {
+    if (percon) {
+        return Cost{0, _tip + _tap + _top};
     }
+
+    // A departure before midnight, once shifted by processing, is waited upon from just past it on the previous day at the least
+    return Cost{cost, dur + min(0L, dep + 1)};
+}
+
+EdgeList::EdgeList() : count(0) {}
+
+EdgeList::EdgeList(const vector<shared_ptr<EdgeChunk> >& _chunks, size_t _count) : chunks(_chunks.begin(), _chunks.end()), count(_count) {}
+
+size_t EdgeList::size() const {
+    return count;
+}
+
+void EdgeTable::push_back(const EdgeEntry& edge) {
+    if (count % EDGE_CHUNK == 0) {
+        chunks.push_back(make_shared<EdgeChunk>());
+    }
+    chunks.back()->edges[count % EDGE_CHUNK] = edge;
+    count++;
+}
+
+EdgeEntry& EdgeTable::update(size_t index) {
+    shared_ptr<EdgeChunk>& chunk = chunks[index / EDGE_CHUNK];
+
+    // Lists are only made under the mutex, hence a chunk seen as unshared stays so. Views release lists concurrently, and the fence orders
+    // their reads of a chunk released last before the update
+    if (chunk.use_count() > 1) {
+        chunk = make_shared<EdgeChunk>(*chunk);
+    }
+    else {
+        atomic_thread_fence(memory_order_acquire);
+    }
+    return chunk->edges[index % EDGE_CHUNK];
+}
+
+size_t EdgeTable::size() const {
+    return count;
+}
+
+EdgeList EdgeTable::list() const {
+    return EdgeList(chunks, count);
+}
+
+GraphVersion::GraphVersion(size_t _nvertices, const EdgeList& _edges, shared_ptr<const GraphCodes> _codes, uint64_t version) : built_from(version), nvertices(_nvertices), edges(_edges), codes(std::move(_codes)) {}
+
+GraphVersion::GraphVersion(const GraphVersion& earlier, const EdgeList& _edges, uint64_t version) : built_from(version), nvertices(earlier.nvertices), edges(_edges), codes(earlier.codes), shape(earlier.structure()) {}
+
+uint64_t GraphVersion::version() const {
+    return built_from;
+}
+
+const shared_ptr<const CompactGraph>& GraphVersion::compacted() const {
+    call_once(image_built, [this]() {
+        if (shape) {
+            atomic_store(&image, make_shared<const CompactGraph>(shape, edges, built_from));
+        }
+        else {
+            atomic_store(&image, make_shared<const CompactGraph>(nvertices, edges, built_from));
+        }
+    });
+    return image;
 }
 
-void BaseGraph::check_kwargs(const map<string, any>& kwargs, const list<string_view>& keys) {
-    for(string_view key: keys) {
-        check_kwargs(kwargs, key);
+shared_ptr<const CompactGraph> GraphVersion::structure() const {
+    shared_ptr<const CompactGraph> built = atomic_load(&image);
+    return built ? built : shape;
+}
+
+bool GraphVersion::vertex(string_view code, Vertex& vertex) const {
+    size_t position;
+
+    if (!codes->vertices.find(code, position)) {
+        return false;
     }
+    vertex = position;
+    return true;
+}
+
+string_view GraphVersion::vertex_code(Vertex vertex) const {
+    return codes->vertices.at(vertex);
+}
+
+string_view GraphVersion::edge_code(size_t index) const {
+    return codes->edges.at(index);
+}
+
+bool GraphVersion::edge(string_view code, size_t& index) const {
+    return codes->edges.find(code, index);
+}
+
+const EdgeEntry& GraphVersion::edge_at(size_t index) const {
+    return edges.at(index);
+}
+
+GraphView BaseGraph::view() const {
+    return GraphView(current());
 }
 
 void BaseGraph::add_vertex(string_view code) {
-    unique_lock<shared_timed_mutex> graph_write_lock(graph_mutex, defer_lock);
-    graph_write_lock.lock();
+    unique_lock<mutex> graph_lock(graph_mutex, defer_lock);
+    graph_lock.lock();
 
+    insert_vertex(code);
+    publish(true);
+}
+
+void BaseGraph::insert_vertex(string_view code) {
     if (vertex_map.find(code.to_string()) == vertex_map.end()) {
 
         VertexProperty vprop{boost::num_vertices(g), code};
         Vertex created = boost::add_vertex(vprop, g);
         vertex_map[vprop.code] = created;
+        vertex_codes.push_back(code);
     }
     else {
         throw invalid_argument("Unable to add vertex. Duplicate code specified");
@@ -103,124 +203,595 @@ void BaseGraph::add_vertex(string_view code) {
 }
 
 void BaseGraph::add_edge(string_view src, string_view dst, string_view conn, const long tip, const long tap, const long top, const double cost) {
-    if (vertex_map.find(src.to_string()) == vertex_map.end()) {
-        throw domain_error("C: Invalid source <" + src.to_string() + "> specified");
+    unique_lock<mutex> graph_lock(graph_mutex, defer_lock);
+    graph_lock.lock();
+
+    auto ends = endpoints(src, dst, "C");
+    insert_edge(EdgeAll{edge_slot(conn), ends.first, ends.second, tip, tap, top, cost, conn});
+    publish(true);
+}
+
+pair<size_t, size_t> BaseGraph::endpoints(string_view src, string_view dst, const string& kind) const {
+    auto source = vertex_map.find(src.to_string());
+
+    if (source == vertex_map.end()) {
+        throw domain_error(kind + ": Invalid source <" + src.to_string() + "> specified");
     }
 
-    if (vertex_map.find(dst.to_string()) == vertex_map.end()) {
-        throw domain_error("C: Invalid destination <" + dst.to_string() + "> specified");
+    auto destination = vertex_map.find(dst.to_string());
+
+    if (destination == vertex_map.end()) {
+        throw domain_error(kind + ": Invalid destination <" + dst.to_string() + "> specified");
     }
+    return make_pair(source->second, destination->second);
+}
 
-    if (edge_map.find(conn.to_string()) == edge_map.end()) {
-        size_t sindex = vertex_map.at(src.to_string());
-        size_t dindex = vertex_map.at(dst.to_string());
+size_t BaseGraph::edge_slot(string_view conn) const {
+    auto found = edge_map_all.find(conn);
 
-        unique_lock<shared_timed_mutex> graph_write_lock(graph_mutex, defer_lock);
-        graph_write_lock.lock();
+    if (found == edge_map_all.end()) {
+        return edges_all.size();
+    }
+
+    if (edges_all[found->second].enabled) {
+        throw invalid_argument("Unable to create edge. Duplicate connection specified");
+    }
+    return found->second;
+}
 
-        EdgeProperty eprop{boost::num_edges(g), tip, tap, top, cost, conn};
-        auto created = boost::add_edge(sindex, dindex, eprop, g);
+void BaseGraph::insert_edge(EdgeAll&& edge) {
+    auto created = boost::add_edge(edge.src, edge.dst, edge.property, g);
 
-        if (created.second) {
-            edge_map[eprop.code] = created.first;
-            edge_map_all[eprop.code] = EdgeAll(eprop.index, sindex, dindex, tip, tap, top, cost, conn);
-        }
-        else {
-            throw runtime_error("Unable to create edge");
-        }
+    if (!created.second) {
+        throw runtime_error("Unable to create edge");
+    }
+    edge.enabled = true;
+    edge.descriptor = created.first;
+    store_edge(std::move(edge));
+}
+
+void BaseGraph::store_edge(EdgeAll&& edge) {
+    size_t index = edge.property.index;
+
+    if (index == edges_all.size()) {
+        edge_map_all.emplace(edge.code, index);
+        edge_codes.push_back(edge.code);
+        edge_table.push_back(edge_entry(edge, sequence++));
+        edges_all.push_back(std::move(edge));
     }
     else {
-        throw invalid_argument("Unable to create edge. Duplicate connection specified");
+        // The disabled edge replaced is still held in graph, and the edge replacing it follows the out edges of its source
+        boost::remove_edge(edges_all[index].descriptor, g);
+        edge_table.update(index) = edge_entry(edge, sequence++);
+        edges_all[index] = std::move(edge);
     }
 }
 
+void BaseGraph::set_enabled(size_t index, bool state) {
+    edges_all[index].enabled = state;
+    edge_table.update(index).enabled = state;
+}
+
 void BaseGraph::toggle_edge(string_view conn, bool state) {
-    if (state == true) {
-        if (edge_map.find(conn.to_string()) == edge_map.end()) {
-            if (edge_map_all.find(conn.to_string()) == edge_map_all.end()) {
-                throw domain_error("Invalid edge <" + conn.to_string() + "> specified");
+    // The version is published along with the flag of the edge, hence both happen under the mutex
+    unique_lock<mutex> graph_lock(graph_mutex, defer_lock);
+    graph_lock.lock();
+
+    auto found = edge_map_all.find(conn);
+
+    if (found == edge_map_all.end()) {
+        if (state == true) {
+            throw domain_error("Invalid edge <" + conn.to_string() + "> specified");
+        }
+        return;
+    }
+
+    // Edges remain in graph once disabled, hence toggling leaves the structure of the graph as is
+    EdgeAll& edge = edges_all[found->second];
+
+    if (edge.enabled != state) {
+        set_enabled(found->second, state);
+        publish(false);
+    }
+}
+
+size_t BaseGraph::toggle_edges(const vector<ToggleArgs>& toggles) {
+    unique_lock<mutex> graph_lock(graph_mutex, defer_lock);
+    graph_lock.lock();
+
+    vector<size_t> indices(toggles.size(), edges_all.size());
+
+    for (size_t position = 0; position < toggles.size(); position++) {
+        auto found = edge_map_all.find(toggles[position].code);
+
+        if (found != edge_map_all.end()) {
+            indices[position] = found->second;
+        }
+        else if (toggles[position].state == 1) {
+            throw domain_error("Invalid edge <" + toggles[position].code + "> specified");
+        }
+    }
+
+    size_t toggled = 0;
+
+    // Edges toggled more than once end up in their last state, as if toggled one after another
+    for (size_t position = 0; position < toggles.size(); position++) {
+        if (indices[position] == edges_all.size()) {
+            continue;
+        }
+
+        bool state = toggles[position].state == 1;
+
+        if (edges_all[indices[position]].enabled != state) {
+            set_enabled(indices[position], state);
+            toggled++;
+        }
+    }
+
+    if (toggled > 0) {
+        publish(false);
+    }
+    return toggled;
+}
+
+size_t BaseGraph::apply(const vector<GraphMutation>& mutations) {
+    unique_lock<mutex> graph_lock(graph_mutex, defer_lock);
+    graph_lock.lock();
+
+    // Vertices added and states of edges added or toggled by the mutations checked so far, as seen by those after them
+    set<string, less<>> vertices_added;
+    map<string, bool, less<>> states;
+
+    auto has_vertex = [&](const string& code) {
+        return vertex_map.find(code) != vertex_map.end() || vertices_added.find(code) != vertices_added.end();
+    };
+
+    auto edge_exists = [&](const string& code, bool& enabled) {
+        auto state = states.find(code);
+
+        if (state != states.end()) {
+            enabled = state->second;
+            return true;
+        }
+
+        auto found = edge_map_all.find(code);
+
+        if (found != edge_map_all.end()) {
+            enabled = edges_all[found->second].enabled;
+            return true;
+        }
+        return false;
+    };
+
+    auto check_edge = [&](size_t position, const string& src, const string& dst, const string& conn, const string& kind) {
+        bool enabled = false;
+
+        if (!has_vertex(src)) {
+            throw domain_error("Mutation " + to_string(position) + ": " + kind + ": Invalid source <" + src + "> specified");
+        }
+
+        if (!has_vertex(dst)) {
+            throw domain_error("Mutation " + to_string(position) + ": " + kind + ": Invalid destination <" + dst + "> specified");
+        }
+
+        if (edge_exists(conn, enabled) && enabled) {
+            throw invalid_argument("Mutation " + to_string(position) + ": Unable to create edge. Duplicate connection specified");
+        }
+        states[conn] = true;
+    };
+
+    for (size_t position = 0; position < mutations.size(); position++) {
+        const GraphMutation& mutation = mutations[position];
+        bool enabled = false;
+
+        switch (mutation.type) {
+            case MUTATION_ADDV:
+                if (has_vertex(mutation.vertex.code)) {
+                    throw invalid_argument("Mutation " + to_string(position) + ": Unable to add vertex. Duplicate code specified");
+                }
+                vertices_added.insert(mutation.vertex.code);
+                break;
+
+            case MUTATION_ADDE:
+                check_edge(position, mutation.edge.src, mutation.edge.dst, mutation.edge.conn, "E");
+                break;
+
+            case MUTATION_ADDC:
+                check_edge(position, mutation.continuous.src, mutation.continuous.dst, mutation.continuous.conn, "C");
+                break;
+
+            case MUTATION_MODC:
+                if (edge_exists(mutation.toggle.code, enabled)) {
+                    states[mutation.toggle.code] = mutation.toggle.state == 1;
+                }
+                else if (mutation.toggle.state == 1) {
+                    throw domain_error("Mutation " + to_string(position) + ": Invalid edge <" + mutation.toggle.code + "> specified");
+                }
+                break;
+        }
+    }
+
+    // Mutations checked apply without failing, hence the graph is never left partly mutated
+    bool shaped = false, toggled = false;
+
+    for (const GraphMutation& mutation: mutations) {
+        switch (mutation.type) {
+            case MUTATION_ADDV:
+                insert_vertex(mutation.vertex.code);
+                shaped = true;
+                break;
+
+            case MUTATION_ADDE: {
+                const EdgeArgs& args = mutation.edge;
+                auto ends = endpoints(args.src, args.dst, "E");
+
+                insert_edge(EdgeAll{edge_slot(args.conn), ends.first, ends.second, args.dep, args.dur, args.tip, args.tap, args.top, args.cost, args.conn});
+                shaped = true;
+                break;
             }
-            unique_lock<shared_timed_mutex> graph_write_lock(graph_mutex, defer_lock);
-            graph_write_lock.lock();
 
-            EdgeAll eprop_all = edge_map_all.at(conn.to_string());
-            EdgeProperty eprop{boost::num_edges(g), eprop_all};
-            auto created = boost::add_edge(eprop_all.src, eprop_all.dst, eprop, g);
+            case MUTATION_ADDC: {
+                const ContinuousEdgeArgs& args = mutation.continuous;
+                auto ends = endpoints(args.src, args.dst, "C");
 
-            if (created.second) {
-                edge_map[eprop.code] = created.first;
+                insert_edge(EdgeAll{edge_slot(args.conn), ends.first, ends.second, args.tip, args.tap, args.top, CONTINUOUS_COST, args.conn});
+                shaped = true;
+                break;
             }
-            else {
-                throw runtime_error("Unable to create edge");
+
+            case MUTATION_MODC: {
+                auto found = edge_map_all.find(mutation.toggle.code);
+
+                if (found == edge_map_all.end()) {
+                    break;
+                }
+
+                bool state = mutation.toggle.state == 1;
+
+                if (edges_all[found->second].enabled != state) {
+                    set_enabled(found->second, state);
+                    toggled = true;
+                }
+                break;
             }
         }
     }
-    else {
-        if (edge_map.find(conn.to_string()) != edge_map.end()) {
-            Edge edesc = edge_map.at(conn.to_string());
-            boost::remove_edge(edesc, g);
-            edge_map.erase(edge_map.find(conn.to_string()), edge_map.end());
-        }
+
+    if (shaped) {
+        publish(true);
+    }
+    else if (toggled) {
+        publish(false);
     }
+    return mutations.size();
 }
 
 void BaseGraph::add_edge(string_view src, string_view dst, string_view conn, const long dep, const long dur, const long tip, const long tap, const long top, const double cost) {
-    if (vertex_map.find(src.to_string()) == vertex_map.end()) {
-        throw domain_error("E: Invalid source <" + src.to_string() + "> specified");
+    unique_lock<mutex> graph_lock(graph_mutex, defer_lock);
+    graph_lock.lock();
+
+    auto ends = endpoints(src, dst, "E");
+    insert_edge(EdgeAll{edge_slot(conn), ends.first, ends.second, dep, dur, tip, tap, top, cost, conn});
+    publish(true);
+}
+
+pair<EdgeAll, VertexProperty> BaseGraph::lookup(string_view vertex, string_view edge) const {
+    // The version looked up in is pinned for the duration of the lookup, hence updates proceed meanwhile
+    shared_ptr<const GraphVersion> pinned = current();
+    Vertex vdesc;
+    size_t index;
+
+    if (!pinned->vertex(vertex, vdesc))
+        throw domain_error("No source vertex<" + vertex.to_string() + "> found in database");
+
+    if (!pinned->edge(edge, index) || !pinned->edge_at(index).enabled)
+        throw domain_error("Connection<" + edge.to_string() + "> not in database");
+
+    const EdgeEntry& entry = pinned->edge_at(index);
+
+    if (entry.src != vdesc) {
+        throw invalid_argument("No connection<" + edge.to_string() + "> from source<" + vertex.to_string() + ">");
     }
 
-    if (vertex_map.find(dst.to_string()) == vertex_map.end()) {
-        throw domain_error("E: Invalid destination <" + dst.to_string() + "> specified");
+    EdgeAll eall;
+    eall.property = entry.property;
+    eall.code = pinned->edge_code(index).to_string();
+    eall.src = entry.src;
+    eall.dst = entry.dst;
+    eall._dep = entry._dep;
+    eall._dur = entry._dur;
+    eall.enabled = entry.enabled;
+
+    return std::make_pair(eall, VertexProperty{entry.dst, pinned->vertex_code(entry.dst)});
+}
+
+void BaseGraph::save_snapshot(string_view path) const {
+    unique_lock<mutex> graph_lock(graph_mutex, defer_lock);
+    graph_lock.lock();
+
+    size_t nvertices = boost::num_vertices(g);
+    size_t nedges = edge_map_all.size();
+
+    string pool;
+    vector<SnapshotVertex> vertices(nvertices);
+
+    for (size_t vertex = 0; vertex < nvertices; vertex++) {
+        vertices[vertex].code_offset = pool.size();
+        vertices[vertex].code_length = g[vertex].code.size();
+        pool += g[vertex].code;
     }
 
-    if (edge_map.find(conn.to_string()) == edge_map.end()) {
+    vector<uint32_t> vertex_index;
+    vertex_index.reserve(nvertices);
+
+    for (auto const& entry: vertex_map) {
+        vertex_index.push_back(entry.second);
+    }
 
-        size_t sindex = vertex_map.at(src.to_string());
-        size_t dindex = vertex_map.at(dst.to_string());
+    // Edges are collected in order of their codes and then stably sorted by source
+    vector<SnapshotEdge> by_code;
+    by_code.reserve(nedges);
+
+    for (auto const& entry: edge_map_all) {
+        const EdgeAll& eall = edges_all[entry.second];
+        const EdgeProperty& eprop = eall.property;
+
+        SnapshotEdge record;
+        memset(&record, 0, sizeof(record));
+        record.src = eall.src;
+        record.dst = eall.dst;
+        record.code_offset = pool.size();
+        record.code_length = entry.first.size();
+        record.percon = eprop.percon;
+        record.enabled = eall.enabled;
+        record.dep = eprop.percon ? 0 : eall._dep;
+        record.dur = eprop.percon ? 0 : eall._dur;
+        record.tip = eprop._tip;
+        record.tap = eprop._tap;
+        record.top = eprop._top;
+        record.cost = eprop.cost;
+        pool += entry.first;
+        by_code.push_back(record);
+    }
 
-        unique_lock<shared_timed_mutex> graph_write_lock(graph_mutex, defer_lock);
-        graph_write_lock.lock();
+    vector<uint32_t> order(nedges);
+    iota(order.begin(), order.end(), 0);
+    stable_sort(order.begin(), order.end(), [&by_code](uint32_t first, uint32_t second) {
+        return by_code[first].src < by_code[second].src;
+    });
 
-        EdgeProperty eprop{boost::num_edges(g), dep, dur, tip, tap, top, cost, conn};
-        auto created = boost::add_edge(sindex, dindex, eprop, g);
+    vector<SnapshotEdge> edges(nedges);
+    vector<uint32_t> edge_index(nedges);
+    vector<uint32_t> offsets(nvertices + 1, 0);
 
-        if (created.second) {
-            edge_map[eprop.code] = created.first;
-            edge_map_all[eprop.code] = EdgeAll(eprop.index, sindex, dindex, tip, tap, top, cost, conn);
+    for (size_t position = 0; position < nedges; position++) {
+        edges[position] = by_code[order[position]];
+        edge_index[order[position]] = position;
+        offsets[edges[position].src + 1]++;
+    }
+
+    for (size_t vertex = 0; vertex < nvertices; vertex++) {
+        offsets[vertex + 1] += offsets[vertex];
+    }
+
+    // Sections are copies of the graph, hence are written without holding updates back
+    graph_lock.unlock();
+
+    SnapshotHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    header.version = SNAPSHOT_VERSION;
+    header.nvertices = nvertices;
+    header.nedges = nedges;
+    header.pool_length = pool.size();
+    header.vertices = align_section(sizeof(header));
+    header.offsets = align_section(header.vertices + nvertices * sizeof(SnapshotVertex));
+    header.edges = align_section(header.offsets + (nvertices + 1) * sizeof(uint32_t));
+    header.vertex_index = align_section(header.edges + nedges * sizeof(SnapshotEdge));
+    header.edge_index = align_section(header.vertex_index + nvertices * sizeof(uint32_t));
+    header.pool = align_section(header.edge_index + nedges * sizeof(uint32_t));
+
+    string temporary = path.to_string() + ".tmp";
+    ofstream output(temporary, ios::binary | ios::trunc);
+
+    auto write_section = [&output](uint64_t offset, const void* buffer, size_t length) {
+        static const char padding[8] = {0};
+        output.write(padding, offset - output.tellp());
+        output.write(static_cast<const char*>(buffer), length);
+    };
+
+    output.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    write_section(header.vertices, vertices.data(), nvertices * sizeof(SnapshotVertex));
+    write_section(header.offsets, offsets.data(), (nvertices + 1) * sizeof(uint32_t));
+    write_section(header.edges, edges.data(), nedges * sizeof(SnapshotEdge));
+    write_section(header.vertex_index, vertex_index.data(), nvertices * sizeof(uint32_t));
+    write_section(header.edge_index, edge_index.data(), nedges * sizeof(uint32_t));
+    write_section(header.pool, pool.data(), pool.size());
+    output.close();
+
+    if (!output) {
+        remove(temporary.c_str());
+        throw runtime_error("Unable to write snapshot <" + temporary + ">");
+    }
+
+    if (rename(temporary.c_str(), path.to_string().c_str()) != 0) {
+        remove(temporary.c_str());
+        throw runtime_error("Unable to move snapshot to <" + path.to_string() + ">");
+    }
+}
+
+void BaseGraph::load_snapshot(const Snapshot& snapshot) {
+    const SnapshotHeader& header = snapshot.header();
+    const SnapshotVertex* vertices = snapshot.vertices();
+    const uint32_t* offsets = snapshot.offsets();
+    const SnapshotEdge* edges = snapshot.edges();
+    const uint32_t* vertex_index = snapshot.vertex_index();
+    const uint32_t* edge_index = snapshot.edge_index();
+
+    Graph fresh(header.nvertices);
+    map<string, Vertex, less<>> fresh_vertex_map;
+    vector<EdgeAll> fresh_edges_all(header.nedges);
+    map<string, size_t, less<>> fresh_edge_map_all;
+
+    for (size_t vertex = 0; vertex < header.nvertices; vertex++) {
+        fresh[vertex] = VertexProperty{vertex, snapshot.code(vertices[vertex].code_offset, vertices[vertex].code_length)};
+    }
+
+    // Indices list codes in sorted order, hence maps are built in linear time by inserting at the end
+    for (size_t position = 0; position < header.nvertices; position++) {
+        uint32_t vertex = vertex_index[position];
+
+        if (vertex >= header.nvertices) {
+            throw runtime_error("Invalid snapshot. Vertex index out of bounds");
+        }
+        fresh_vertex_map.emplace_hint(fresh_vertex_map.end(), fresh[vertex].code, vertex);
+    }
+
+    if (offsets[0] != 0 || offsets[header.nvertices] != header.nedges) {
+        throw runtime_error("Invalid snapshot. Edge offsets do not span the edges");
+    }
+
+    // Outbound edges of each vertex are read from its range of the edge section, which holds edges of that vertex only
+    for (size_t vertex = 0; vertex < header.nvertices; vertex++) {
+        if (offsets[vertex] > offsets[vertex + 1] || offsets[vertex + 1] > header.nedges) {
+            throw runtime_error("Invalid snapshot. Edge offsets out of order");
+        }
+
+        for (size_t position = offsets[vertex]; position < offsets[vertex + 1]; position++) {
+            const SnapshotEdge& record = edges[position];
+
+            if (record.src != vertex) {
+                throw runtime_error("Invalid snapshot. Edge outside the offsets of its source");
+            }
+
+            if (record.dst >= header.nvertices) {
+                throw runtime_error("Invalid snapshot. Edge endpoint out of bounds");
+            }
+
+            string_view code = snapshot.code(record.code_offset, record.code_length);
+
+            EdgeAll& edge = fresh_edges_all[position];
+
+            if (record.percon) {
+                edge = EdgeAll(position, record.src, record.dst, record.tip, record.tap, record.top, record.cost, code);
+            }
+            else {
+                edge = EdgeAll(position, record.src, record.dst, record.dep, record.dur, record.tip, record.tap, record.top, record.cost, code);
+            }
+
+            edge.enabled = record.enabled;
+            edge.descriptor = boost::add_edge(record.src, record.dst, edge.property, fresh).first;
+        }
+    }
+
+    for (size_t rank = 0; rank < header.nedges; rank++) {
+        uint32_t position = edge_index[rank];
+
+        if (position >= header.nedges) {
+            throw runtime_error("Invalid snapshot. Edge index out of bounds");
+        }
+        fresh_edge_map_all.emplace_hint(fresh_edge_map_all.end(), fresh_edges_all[position].code, position);
+    }
+
+    replace(fresh, fresh_vertex_map, fresh_edges_all, fresh_edge_map_all);
+}
+
+void BaseGraph::load_edges(const EdgeReader& reader) {
+    const vector<string_view>& codes = reader.vertices();
+    const vector<EdgeRecord>& records = reader.edges();
+
+    Graph fresh(codes.size());
+    map<string, Vertex, less<>> fresh_vertex_map;
+    vector<EdgeAll> fresh_edges_all(records.size());
+    map<string, size_t, less<>> fresh_edge_map_all;
+
+    for (size_t vertex = 0; vertex < codes.size(); vertex++) {
+        fresh[vertex] = VertexProperty{vertex, codes[vertex]};
+        fresh_vertex_map.emplace(fresh[vertex].code, vertex);
+    }
+
+    for (size_t index = 0; index < records.size(); index++) {
+        const EdgeRecord& record = records[index];
+        EdgeAll& edge = fresh_edges_all[index];
+
+        if (record.dur == 0) {
+            edge = EdgeAll(index, record.src_index, record.dst_index, record.tip, record.tap, record.top, CONTINUOUS_COST, record.conn);
         }
         else {
-            throw runtime_error("Unable to create edge.");
+            edge = EdgeAll(index, record.src_index, record.dst_index, record.dep, record.dur, record.tip, record.tap, record.top, record.cost, record.conn);
         }
+
+        auto inserted = fresh_edge_map_all.emplace(edge.code, index);
+
+        if (!inserted.second) {
+            throw invalid_argument("Unable to load edges. Duplicate connection <" + edge.code + "> specified");
+        }
+
+        edge.enabled = true;
+        edge.descriptor = boost::add_edge(record.src_index, record.dst_index, edge.property, fresh).first;
     }
-    else {
-        throw invalid_argument("Unable to create edge. Duplicate connection specified");
+
+    replace(fresh, fresh_vertex_map, fresh_edges_all, fresh_edge_map_all);
+}
+
+void BaseGraph::replace(Graph& fresh, map<string, Vertex, less<>>& fresh_vertex_map, vector<EdgeAll>& fresh_edges_all, map<string, size_t, less<>>& fresh_edge_map_all) {
+    CodeTable fresh_vertex_codes(true), fresh_edge_codes(true);
+    EdgeTable fresh_edge_table;
+
+    for (size_t vertex = 0; vertex < boost::num_vertices(fresh); vertex++) {
+        fresh_vertex_codes.push_back(fresh[vertex].code);
+    }
+
+    // Edges are added to the fresh graph in order of their index
+    for (size_t index = 0; index < fresh_edges_all.size(); index++) {
+        fresh_edge_codes.push_back(fresh_edges_all[index].code);
+        fresh_edge_table.push_back(edge_entry(fresh_edges_all[index], index));
     }
+
+    unique_lock<mutex> graph_lock(graph_mutex, defer_lock);
+    graph_lock.lock();
+
+    // Edge descriptors point into the stored edge properties. adjacency_list::swap copies the graph, hence the
+    // storage of both graphs is exchanged directly to keep the descriptors in the fresh edges valid
+    g.m_vertices.swap(fresh.m_vertices);
+    g.m_edges.swap(fresh.m_edges);
+    vertex_map = std::move(fresh_vertex_map);
+    edges_all = std::move(fresh_edges_all);
+    edge_map_all = std::move(fresh_edge_map_all);
+    vertex_codes = std::move(fresh_vertex_codes);
+    edge_codes = std::move(fresh_edge_codes);
+    edge_table = std::move(fresh_edge_table);
+    sequence = edges_all.size();
+    publish(true);
 }
 
-pair<EdgeProperty, VertexProperty> BaseGraph::lookup(string_view vertex, string_view edge) {
-    if (vertex_map.find(vertex.to_string()) == vertex_map.end())
-        throw domain_error("No source vertex<" + vertex.to_string() + "> found in database");
+BaseGraph::BaseGraph() {
+    publish(true);
+}
 
-    if (edge_map.find(edge.to_string()) == edge_map.end())
-        throw domain_error("Connection<" + edge.to_string() + "> not in database");
+void BaseGraph::publish(bool shaped) {
+    shared_ptr<const GraphVersion> latest = atomic_load(&published);
 
-    Vertex vdesc = vertex_map.at(vertex.to_string());
-    Edge edesc = edge_map.at(edge.to_string());
+    version++;
 
-    if (boost::source(edesc, g) != vdesc) {
-        throw invalid_argument("No connection<" + edge.to_string() + "> from source<" + vertex.to_string() + ">");
+    // Versions following the last published by toggles alone share its structure, building only the state of edges
+    if (latest && !shaped) {
+        latest = make_shared<const GraphVersion>(*latest, edge_table.list(), version);
     }
+    else {
+        latest = make_shared<const GraphVersion>(vertex_codes.size(), edge_table.list(), make_shared<const GraphCodes>(GraphCodes{vertex_codes.list(), edge_codes.list()}), version);
+    }
+    atomic_store(&published, latest);
+}
 
-    Vertex edest = boost::target(edesc, g);
-    return std::make_pair(g[edesc], g[edest]);
+shared_ptr<const GraphVersion> BaseGraph::current() const {
+    return atomic_load(&published);
 }
 
-json_map BaseGraph::addv(shared_ptr<BaseGraph> solver, const map<string, any>& kwargs) {
+json_map BaseGraph::addv(shared_ptr<BaseGraph> solver, const VertexArgs& args) {
     json_map response;
     try {
-        check_kwargs(kwargs, "code");
-        string value = any_cast<string>(kwargs.at("code"));
-        solver->add_vertex(value);
+        solver->add_vertex(args.code);
         response["success"] = true;
     }
     catch (const exception& exc) {
@@ -231,27 +802,29 @@ json_map BaseGraph::addv(shared_ptr<BaseGraph> solver, const map<string, any>& k
 }
 
 
-json_map BaseGraph::adde(shared_ptr<BaseGraph> solver, const map<string, any>& kwargs) {
+json_map BaseGraph::adde(shared_ptr<BaseGraph> solver, const EdgeArgs& args) {
     json_map response;
     try {
-        string src, dst, conn;
-        long dep, dur, tip, top, tap;
-        double cost;
+        solver->add_edge(args.src, args.dst, args.conn, args.dep, args.dur, args.tip, args.tap, args.top, args.cost);
+        response["success"] = true;
+    }
+    catch (const exception& exc) {
+        response["error"] = exc.what();
+    }
+    return response;
+}
 
-        check_kwargs(kwargs, list<string_view>{"src", "dst", "conn", "dep", "dur", "tip", "tap", "top", "cost"});
-        src  = any_cast<string>(kwargs.at("src"));
-        dst  = any_cast<string>(kwargs.at("dst"));
-        conn = any_cast<string>(kwargs.at("conn"));
+json_map BaseGraph::modc(shared_ptr<BaseGraph> solver, const ToggleArgs& args) {
+    json_map response;
 
-        dep  = any_cast<long>(kwargs.at("dep"));
-        dur  = any_cast<long>(kwargs.at("dur"));
-        tip  = any_cast<long>(kwargs.at("tip"));
-        tap  = any_cast<long>(kwargs.at("tap"));
-        top  = any_cast<long>(kwargs.at("top"));
+    try {
+        bool enabled = false;
 
-        cost = any_cast<double>(kwargs.at("cost"));
+        if (args.state == 1) {
+            enabled = true;
+        }
 
-        solver->add_edge(src, dst, conn, dep, dur, tip, tap, top, cost);
+        solver->toggle_edge(args.code, enabled);
         response["success"] = true;
     }
     catch (const exception& exc) {
@@ -260,25 +833,24 @@ json_map BaseGraph::adde(shared_ptr<BaseGraph> solver, const map<string, any>& k
     return response;
 }
 
-json_map BaseGraph::modc(shared_ptr<BaseGraph> solver, const map<string, any>& kwargs) {
+json_map BaseGraph::bmod(shared_ptr<BaseGraph> solver, const ToggleBatchArgs& args) {
     json_map response;
 
     try {
-        string code;
-        long state;
-        bool enabled;
-        check_kwargs(kwargs, list<string_view>{"code", "state"});
-
-        code = any_cast<string>(kwargs.at("code"));
-        state = any_cast<long>(kwargs.at("state"));
-
-        enabled = false;
+        response["toggled"] = solver->toggle_edges(args.toggles);
+        response["success"] = true;
+    }
+    catch (const exception& exc) {
+        response["error"] = exc.what();
+    }
+    return response;
+}
 
-        if (state == 1) {
-            enabled = true;
-        }
+json_map BaseGraph::txn(shared_ptr<BaseGraph> solver, const TransactionArgs& args) {
+    json_map response;
 
-        solver->toggle_edge(code, enabled);
+    try {
+        response["applied"] = solver->apply(args.mutations);
         response["success"] = true;
     }
     catch (const exception& exc) {
@@ -287,22 +859,12 @@ json_map BaseGraph::modc(shared_ptr<BaseGraph> solver, const map<string, any>& k
     return response;
 }
 
-json_map BaseGraph::addc(shared_ptr<BaseGraph> solver, const map<string, any>& kwargs) {
+json_map BaseGraph::addc(shared_ptr<BaseGraph> solver, const ContinuousEdgeArgs& args) {
     json_map response;
     try {
-        string src, dst, conn;
-        long tip, top, tap;
-        double cost = 0.30;
-        
-        check_kwargs(kwargs, list<string_view>{"src", "dst", "conn", "tip", "tap", "top"});
-        src = any_cast<string>(kwargs.at("src"));
-        dst = any_cast<string>(kwargs.at("dst"));
-        conn = any_cast<string>(kwargs.at("conn"));
-
-        top = any_cast<long>(kwargs.at("tap"));
-        tap = any_cast<long>(kwargs.at("top"));
-        tip = any_cast<long>(kwargs.at("tip"));
-        solver->add_edge(src, dst, conn, tip, top, tap, cost);
+        double cost = CONTINUOUS_COST;
+
+        solver->add_edge(args.src, args.dst, args.conn, args.tip, args.tap, args.top, cost);
         response["success"] = true;
     }
     catch (const exception& exc) {
@@ -311,23 +873,20 @@ json_map BaseGraph::addc(shared_ptr<BaseGraph> solver, const map<string, any>& k
     return response;
 }
 
-json_map BaseGraph::look(shared_ptr<BaseGraph> solver, const map<string, any>& kwargs) {
+json_map BaseGraph::look(shared_ptr<BaseGraph> solver, const LookupArgs& args) {
     json_map response;
 
     try {
-        check_kwargs(kwargs, list<string_view>{"src", "conn"});
-        string vertex = any_cast<string>(kwargs.at("src"));
-        string edge = any_cast<string>(kwargs.at("conn"));
-        auto edge_property = solver->lookup(vertex, edge);
+        auto edge_property = solver->lookup(args.src, args.conn);
 
         json_map conn;
         conn["code"] = edge_property.first.code;
         conn["dep"]  = edge_property.first._dep;
         conn["dur"]  = edge_property.first._dur;
-        conn["tip"]  = edge_property.first._tip;
-        conn["tap"]  = edge_property.first._tap;
-        conn["top"]  = edge_property.first._top;
-        conn["cost"] = edge_property.first.cost;
+        conn["tip"]  = edge_property.first.property._tip;
+        conn["tap"]  = edge_property.first.property._tap;
+        conn["top"]  = edge_property.first.property._top;
+        conn["cost"] = edge_property.first.property.cost;
         conn["dst"] = edge_property.second.code;
 
         response["connection"] = conn;
@@ -339,30 +898,25 @@ json_map BaseGraph::look(shared_ptr<BaseGraph> solver, const map<string, any>& k
     return response;
 }
 
-json_map BaseGraph::find(shared_ptr<BaseGraph> solver, const map<string, any>& kwargs) {
+json_map BaseGraph::save(shared_ptr<BaseGraph> graph, const FileArgs& args) {
     json_map response;
     try {
-        check_kwargs(kwargs, list<string_view>{"src", "dst", "beg", "tmax"});
-        string src = any_cast<string>(kwargs.at("src"));
-        string dst = any_cast<string>(kwargs.at("dst"));
-        long t_start    = any_cast<long>(kwargs.at("beg"));
-        long t_max      = any_cast<long>(kwargs.at("tmax"));
-
-        auto path = solver->find_path(src, dst, t_start, t_max);
-        json_array segments;
-
-        for (auto const& segment: path) {
-            json_map seg;
-            seg["source"] = segment.src.to_string();
-            seg["connection"] = segment.conn.to_string();
-            seg["destination"] = segment.dst.to_string();
-            seg["arrival_at_source"] = segment.arr;
-            seg["arrival_max_by"] = segment.mdep;
-            seg["departure_from_source"] = segment.dep;
-            seg["cost_reaching_source"] = segment.cost;
-            segments.push_back(seg);
-        }
-        response["path"] = segments;
+        graph->save_snapshot(args.path);
+        response["success"] = true;
+    }
+    catch (const exception& exc) {
+        response["error"] = exc.what();
+    }
+    return response;
+}
+
+json_map BaseGraph::load(shared_ptr<BaseGraph> graph, const FileArgs& args) {
+    json_map response;
+    try {
+        EdgeReader reader{args.path};
+        graph->load_edges(reader);
+        response["vertices"] = reader.vertices().size();
+        response["edges"] = reader.edges().size();
         response["success"] = true;
     }
     catch (const exception& exc) {
@@ -370,3 +924,29 @@ json_map BaseGraph::find(shared_ptr<BaseGraph> solver, const map<string, any>& k
     }
     return response;
 }
+
+GraphView::GraphView(shared_ptr<const GraphVersion> _pinned) : pinned(std::move(_pinned)) {}
+
+const CompactGraph& GraphView::compact() const {
+    return *pinned->compacted();
+}
+
+shared_ptr<const CompactGraph> GraphView::compacted() const {
+    return pinned->compacted();
+}
+
+uint64_t GraphView::version() const {
+    return pinned->version();
+}
+
+bool GraphView::vertex(string_view code, Vertex& vertex) const {
+    return pinned->vertex(code, vertex);
+}
+
+string_view GraphView::vertex_code(Vertex vertex) const {
+    return pinned->vertex_code(vertex);
+}
+
+string_view GraphView::edge_code(const EdgeProperty& edge) const {
+    return pinned->edge_code(edge.index);
+}
@@ -4,19 +4,25 @@
 #ifndef GRAPH_HPP_INCLUDED
 #define GRAPH_HPP_INCLUDED
 
+#include <atomic>
+#include <cstdint>
 #include <limits>
-#include <shared_mutex>
+#include <memory>
+#include <mutex>
 #include <map>
+#include <vector>
 #include <experimental/string_view>
-#include <experimental/any>
 
 #include <jeayeson/jeayeson.hpp>
 
 #include <boost/graph/adjacency_list.hpp>
 
+#include "arguments.hpp"
+#include "codes.hpp"
+#include "loader.hpp"
+#include "snapshot.hpp"
+
 using namespace std;
-using std::experimental::any;
-using std::experimental::any_cast;
 using std::experimental::string_view;
 
 const double P_D_INF = numeric_limits<double>::infinity();
@@ -26,6 +32,11 @@ const long P_L_INF = 4102444800;
 
 const long TIME_DURINAL = 24 * 3600;
 
+/**
+ * @brief Cost recorded against continuous edges
+ */
+const double CONTINUOUS_COST = 0.30;
+
 /**
  * @brief A pair representing the cost incurred on traversal of an edge both in terms of physical costs and time spent
  */
@@ -65,6 +76,8 @@ struct VertexProperty {
 
 /**
  * @brief Structure representing a bundled properties of an edge in a graph/tree.
+ * @details Holds only the attributes required to traverse the edge and is trivially copyable. The code of the edge and its actual
+ * departure and duration are held apart in an EdgeAll, found by index, and are read only once a path is materialized.
  */
 struct EdgeProperty {
     /**
@@ -73,25 +86,10 @@ struct EdgeProperty {
     bool percon = false;
 
     /**
-     * @brief Index of edge in graph
+     * @brief Index of the EdgeAll holding the edge
      */
     size_t index;
 
-    /**
-     * @brief Unique human readable name of the edge
-     */
-    string code;
-
-    /**
-     * @brief Actual departure time at source of edge
-     */
-    long _dep;
-
-    /**
-     * @brief Actual duration of traversal of edge
-     */
-    long _dur;
-
     /**
      * @brief Time to process inbound at edge destination
      */
@@ -132,33 +130,26 @@ struct EdgeProperty {
     /**
      * @brief Constructs an edge property for a continuous edge(such as custody scan).
      * @details Continuous edges are free i.e. there is no physical cost associated against movement via them.
-     * @param[in] : Index of the edge in the underlying graph
+     * @param[in] : Index of the EdgeAll holding the edge
      * @param[in] : Processing time in seconds for outbound at source vertex
      * @param[in] : Processing time in seconds for aggregation at source vertex
      * @param[in] : Processing time in seconds for inbound at destination vertex.
      * @param[in] : Cost of iterating the edge.
-     * @param[in] : Unique human readable name for edge
      */
-    EdgeProperty(const size_t, const long, const long, const long, const double, string_view);
+    EdgeProperty(const size_t, const long, const long, const long, const double);
 
     /**
      * @brief Constructs an edge property for a time-discrete edge
      * @details A time-discrete edge is an edge with a discrete start and duration attribute
-     * @param[in] : Index of the edge in the underlying graph
+     * @param[in] : Index of the EdgeAll holding the edge
      * @param[in] : Time of departure from source vertex
      * @param[in] : Duration of iterating the edge
      * @param[in] : Processing time in seconds for outbound at source vertex
      * @param[in] : Processing time in seconds for aggregation at source vertex
      * @param[in] : Processing time in seconds for inbound at destination vertex.
      * @param[in] : Cost of iterating the edge
-     * @param[in] : Unique human readable name for edge
-     */
-    EdgeProperty(const size_t, const long, const long, const long, const long, const long, const double, string_view);
-
-    /**
-     * @brief Construct an edge property from another ( copy constructor) with a new index
      */
-    EdgeProperty(const size_t, EdgeProperty another);
+    EdgeProperty(const size_t, const long, const long, const long, const long, const long, const double);
 
     /**
      * @brief Calculate the wait time to traverse this edge.
@@ -173,13 +164,34 @@ struct EdgeProperty {
      * @param[in] : Maximum time permissible to reach destination
      * @return Cost on traversing this edge.
      */
-    Cost weight(const Cost&, const long);
+    Cost weight(const Cost&, const long) const;
+
+    /**
+     * @brief Returns the least Cost to traverse this edge at any time of day
+     * @return Cost added and time taken by a traversal arriving at edge source just before departure
+     */
+    Cost least() const;
 };
 
+typedef boost::adjacency_list<boost::vecS, boost::vecS, boost::directedS, VertexProperty, EdgeProperty> Graph;
+typedef boost::graph_traits<Graph>::vertex_descriptor Vertex;
+typedef boost::graph_traits<Graph>::edge_descriptor Edge;
+
 /**
- * @brief Structure representing an edge with its src, dst in graph
+ * @brief Structure representing an edge with its src, dst in graph, whether or not it is enabled
+ * @details Edges are held exactly once, in order of creation, in a table indexed by EdgeProperty::index
  */
-struct EdgeAll : EdgeProperty {
+struct EdgeAll {
+    /**
+     * @brief Properties of edge required to traverse it, as bundled with the edge in graph
+     */
+    EdgeProperty property;
+
+    /**
+     * @brief Unique human readable name of the edge
+     */
+    string code;
+
     /**
      * @brief Property to store source vertex
      */
@@ -191,14 +203,34 @@ struct EdgeAll : EdgeProperty {
     size_t dst;
 
     /**
-     * @brief Default constructs an empty edge property.
+     * @brief Actual departure time at source of edge
      */
-    EdgeAll() : EdgeProperty() {}
+    long _dep;
 
     /**
-     * @brief Constructs an edge property for a continuous edge(such as custody scan).
+     * @brief Actual duration of traversal of edge
+     */
+    long _dur;
+
+    /**
+     * @brief Flag to indicate the edge is enabled, i.e. traversed by solvers. Disabled edges remain in graph
+     */
+    bool enabled = false;
+
+    /**
+     * @brief Edge in graph
+     */
+    Edge descriptor;
+
+    /**
+     * @brief Default constructs an empty edge.
+     */
+    EdgeAll() {}
+
+    /**
+     * @brief Constructs a continuous edge(such as custody scan).
      * @details Continuous edges are free i.e. there is no physical cost associated against movement via them.
-     * @param[in] : Index of the edge in the underlying graph
+     * @param[in] : Index of the edge in the table of all edges
      * @param[in] : Index of source vertex in underlying graph
      * @param[in] : Index of destination vertex in underlying graph
      * @param[in] : Processing time in seconds for outbound at source vertex
@@ -210,9 +242,9 @@ struct EdgeAll : EdgeProperty {
     EdgeAll(const size_t, const size_t, const size_t, const long, const long, const long, const double, string_view);
 
     /**
-     * @brief Constructs an edge property for a time-discrete edge
+     * @brief Constructs a time-discrete edge
      * @details A time-discrete edge is an edge with a discrete start and duration attribute
-     * @param[in] : Index of the edge in the underlying graph
+     * @param[in] : Index of the edge in the table of all edges
      * @param[in] : Index of source vertex in underlying graph
      * @param[in] : Index of destination vertex in underlying graph
      * @param[in] : Time of departure from source vertex
@@ -224,10 +256,142 @@ struct EdgeAll : EdgeProperty {
      * @param[in] : Unique human readable name for edge
      */
     EdgeAll(const size_t, const size_t, const size_t, const long, const long, const long, const long, const long, const double, string_view);
+};
+
+/**
+ * @brief Edge of the graph as seen by its versions, by EdgeProperty::index
+ */
+struct EdgeEntry {
+    /**
+     * @brief Properties of edge required to traverse it
+     */
+    EdgeProperty property;
 
+    /**
+     * @brief Index of source vertex
+     */
+    uint32_t src;
 
+    /**
+     * @brief Index of destination vertex
+     */
+    uint32_t dst;
+
+    /**
+     * @brief Actual departure time at source of edge
+     */
+    long _dep;
+
+    /**
+     * @brief Actual duration of traversal of edge
+     */
+    long _dur;
+
+    /**
+     * @brief Position of edge in the order edges were added to graph, ordering the out edges of its source
+     */
+    uint64_t sequence;
+
+    /**
+     * @brief Flag to indicate the edge is enabled
+     */
+    bool enabled;
+};
+
+/**
+ * @brief Number of edges held by a chunk
+ */
+const size_t EDGE_CHUNK = 1024;
+
+/**
+ * @brief Edges of consecutive indices of a table
+ */
+struct EdgeChunk {
+    EdgeEntry edges[EDGE_CHUNK];
+};
+
+/**
+ * @brief Immutable list of the edges of a table as of a version of the graph
+ */
+class EdgeList {
+    private:
+        /**
+         * @brief Chunks of the table holding the edges listed
+         */
+        vector<shared_ptr<const EdgeChunk> > chunks;
+
+        /**
+         * @brief Number of edges listed
+         */
+        size_t count;
+
+    public:
+        /**
+         * @brief Constructs an empty list
+         */
+        EdgeList();
+
+        /**
+         * @brief Constructs a list of the first edges of a table
+         * @param[in] : Chunks of the table
+         * @param[in] : Number of edges listed
+         */
+        EdgeList(const vector<shared_ptr<EdgeChunk> >&, size_t);
+
+        /**
+         * @brief Fetch the number of edges listed
+         */
+        size_t size() const;
+
+        /**
+         * @brief Fetch the edge at an index
+         */
+        const EdgeEntry& at(size_t) const;
 };
 
+/**
+ * @brief Table of edges by index, as held by the graph and updated under its mutex
+ * @details Edges are appended past the edges of any list, hence are added in place. Chunks are otherwise shared with the lists of the
+ * table, hence a chunk held by a list is copied before any of its edges is updated, the list keeping the chunk as it was.
+ */
+class EdgeTable {
+    private:
+        /**
+         * @brief Chunks holding the edges, the last one possibly partly filled
+         */
+        vector<shared_ptr<EdgeChunk> > chunks;
+
+        /**
+         * @brief Number of edges
+         */
+        size_t count = 0;
+
+    public:
+        /**
+         * @brief Appends an edge at the next index
+         */
+        void push_back(const EdgeEntry&);
+
+        /**
+         * @brief Fetch an edge to update, copying its chunk first if held by a list
+         */
+        EdgeEntry& update(size_t);
+
+        /**
+         * @brief Fetch the number of edges
+         */
+        size_t size() const;
+
+        /**
+         * @brief Lists the edges of the table as of now
+         */
+        EdgeList list() const;
+};
+
+inline const EdgeEntry& EdgeList::at(size_t index) const {
+    return chunks[index / EDGE_CHUNK]->edges[index % EDGE_CHUNK];
+}
+
 /**
  * @brief Structure representing a segment in the traversal of the graph/tree.
  */
@@ -282,15 +446,151 @@ struct Path {
     Path(string_view, string_view, string_view, long, long, long, double);
 };
 
-typedef boost::adjacency_list<boost::vecS, boost::vecS, boost::directedS, VertexProperty, EdgeProperty> Graph;
-typedef boost::graph_traits<Graph>::vertex_descriptor Vertex;
-typedef boost::graph_traits<Graph>::edge_descriptor Edge;
+class GraphView;
+class CompactGraph;
+
+/**
+ * @brief Codes resolving the vertices and edges of a version of the graph
+ */
+struct GraphCodes {
+    /**
+     * @brief Unique human readable name of each vertex, found by name
+     */
+    CodeList vertices;
+
+    /**
+     * @brief Unique human readable name of each edge, enabled or not, indexed by EdgeProperty::index and found by name
+     */
+    CodeList edges;
+};
+
+/**
+ * @brief Immutable version of the graph as traversed by solvers
+ * @details Holds the vertices, edges and codes of a version of the graph, listed from the tables of the graph without copying any edge
+ * or code, and the compact image traversed by solvers. The image is built from the edges listed by the first view traversing the
+ * version, without holding the mutex of the graph, while other views of the version wait for it. A version differing from an earlier one
+ * by the state of its edges alone shares the structure of the image of the earlier version and only builds its mask. A version is never
+ * modified once built but for its image, built once, hence is read without any lock for as long as it is held.
+ */
+class GraphVersion {
+    private:
+        /**
+         * @brief Version of the graph
+         */
+        uint64_t built_from;
+
+        /**
+         * @brief Number of vertices
+         */
+        size_t nvertices;
+
+        /**
+         * @brief Edges, enabled or not, indexed by EdgeProperty::index
+         */
+        EdgeList edges;
+
+        /**
+         * @brief Codes of vertices and edges
+         */
+        shared_ptr<const GraphCodes> codes;
+
+        /**
+         * @brief Image of an earlier version of the same structure whose structure is shared, or nullptr to build the image anew
+         */
+        shared_ptr<const CompactGraph> shape;
+
+        /**
+         * @brief Compact image of the graph, built on first use
+         */
+        mutable shared_ptr<const CompactGraph> image;
+
+        /**
+         * @brief Flag serializing the build of the image between views
+         */
+        mutable once_flag image_built;
+
+    public:
+        /**
+         * @brief Constructs a version of the graph, its image to be built anew
+         * @param[in] : Number of vertices
+         * @param[in] : Edges, indexed by EdgeProperty::index
+         * @param[in] : Codes of vertices and edges of the graph
+         * @param[in] : Version of the graph
+         */
+        GraphVersion(size_t, const EdgeList&, shared_ptr<const GraphCodes>, uint64_t);
+
+        /**
+         * @brief Constructs a version differing from an earlier version by the state of its edges alone
+         * @param[in] : Earlier version
+         * @param[in] : Edges, indexed by EdgeProperty::index
+         * @param[in] : Version of the graph
+         */
+        GraphVersion(const GraphVersion&, const EdgeList&, uint64_t);
+
+        /**
+         * @brief Fetch the version of the graph
+         */
+        uint64_t version() const;
+
+        /**
+         * @brief Fetch the compact image of the graph, shared with its owners, building it if not built yet
+         */
+        const shared_ptr<const CompactGraph>& compacted() const;
+
+        /**
+         * @brief Fetch an image holding the structure of the version, built already
+         * @return Image of the version if built, else the image whose structure it shares, if any
+         */
+        shared_ptr<const CompactGraph> structure() const;
+
+        /**
+         * @brief Finds a vertex by its human readable name
+         * @param[in] : Unique human readable name for the vertex
+         * @param[out] : Vertex matching the name, if found
+         * @return True if a matching vertex was found else False
+         */
+        bool vertex(string_view, Vertex&) const;
+
+        /**
+         * @brief Fetch the human readable name of a vertex
+         */
+        string_view vertex_code(Vertex) const;
+
+        /**
+         * @brief Fetch the human readable name of an edge by its index
+         */
+        string_view edge_code(size_t) const;
+
+        /**
+         * @brief Finds an edge, enabled or not, by its human readable name
+         * @param[in] : Unique human readable name for the edge
+         * @param[out] : Index of the edge matching the name, if found
+         * @return True if a matching edge was found else False
+         */
+        bool edge(string_view, size_t&) const;
+
+        /**
+         * @brief Fetch an edge by its index
+         */
+        const EdgeEntry& edge_at(size_t) const;
+};
 
 /**
- * @brief Interface representing the graph which can be traversed in different ways to satisfy various constraints
+ * @brief Store holding the graph shared by all solvers
+ * @details The graph and its indices are held exactly once irrespective of the number of solvers. Updates are serialized against a
+ * mutex while solvers traverse an immutable GraphVersion of the graph, hence updates never wait on a traversal nor traversals on an
+ * update.
+ *
+ * Each update bumps the version of the graph and publishes the next GraphVersion atomically, hence views never take the mutex and only
+ * ever wait on an atomic load. Publishing a version only lists the chunks of the tables of edges and codes, and leaves its image to be
+ * built by the first view traversing it, hence a stream of updates costs nothing per update but the update itself and the image is
+ * built once for all updates published before a traversal. Disabling an edge only clears its flag, the edge remaining in graph, hence
+ * the version published after toggles derives from the last one by the state of its edges alone, sharing its structure and only
+ * building the mask of its edges. A batch of updates, as by BMOD or TXNS, publishes a single version. Views keep their version alive
+ * for as long as they are held, however many updates follow.
  */
 class BaseGraph {
-    protected:
+    private:
         /**
          * @brief Actual graph, stored as a bgl::adjacency_list
          */
@@ -302,44 +602,124 @@ class BaseGraph {
         map<string, Vertex, less<>> vertex_map;
 
         /**
-         * @brief Mapping for verbose edge names to edges in graph
+         * @brief All possible edges, enabled or not, indexed by EdgeProperty::index
          */
-        map<string, Edge, less<>> edge_map;
+        vector<EdgeAll> edges_all;
 
         /**
-        * @brief Mapping for verbose edge names to all possible edges
+        * @brief Mapping for verbose edge names to all possible edges, by their index in edges_all
         */
-        map<string, EdgeAll, less<>> edge_map_all;
+        map<string, size_t, less<>> edge_map_all;
 
         /**
-         * @brief Mutex to handle locks for read/write on graph
+         * @brief All possible edges as seen by the versions of the graph, shared with them and updated along with edges_all
          */
-        mutable shared_timed_mutex graph_mutex;
+        EdgeTable edge_table;
+
+        /**
+         * @brief Number of edges added to graph since it was last replaced, ordering the out edges of each vertex
+         */
+        uint64_t sequence = 0;
 
-    public:
         /**
-         * @brief Default constructs an empty Graph
+         * @brief Codes of vertices by index, shared with the versions of the graph
          */
-        BaseGraph() {}
+        CodeTable vertex_codes{true};
 
         /**
-         * @brief Destroys the graph
+         * @brief Codes of edges by EdgeProperty::index, shared with the versions of the graph
          */
-        virtual ~BaseGraph() {}
+        CodeTable edge_codes{true};
 
         /**
-         * @brief Utility function to verify if the specified key exists in the kwargs
-         * @param[in] : A map of named arguments
-         * @param[in] : Key to look for the the map
+         * @brief Mutex serializing updates to the graph and the publication of its versions
          */
-        static void check_kwargs(const map<string, any>&, string_view);
+        mutable mutex graph_mutex;
 
         /**
-         * @brief Utility function to verify if a list of specified keys exist in the kwargs
-         * @param[in] : A map of named arguments
-         * @param[in] : List of keys to look for in the map
+         * @brief Version of graph, bumped under the mutex on each update
          */
-        static void check_kwargs(const map<string, any>&, const list<string_view>&);
+        uint64_t version = 0;
+
+        /**
+         * @brief Version of the graph published last, stored under the mutex and loaded atomically without it
+         */
+        shared_ptr<const GraphVersion> published;
+
+        /**
+         * @brief Fetch the version of the graph published last
+         */
+        shared_ptr<const GraphVersion> current() const;
+
+        /**
+         * @brief Bumps the version of the graph, listing the next GraphVersion and publishing it. Requires the mutex to be held
+         * @param[in] : Flag to indicate vertices or edges were added or replaced, as opposed to enabled or disabled alone
+         */
+        void publish(bool);
+
+        /**
+         * @brief Adds a vertex to the graph. Requires the mutex to be held
+         * @param[in] : Unique human readable name for the vertex
+         */
+        void insert_vertex(string_view);
+
+        /**
+         * @brief Finds the vertices an edge added to the graph would connect. Requires the mutex to be held
+         * @param[in] : Source vertex of edge
+         * @param[in] : Destination vertex of edge
+         * @param[in] : Kind of edge, as prefixed to errors
+         * @return Indices of source and destination vertices
+         */
+        pair<size_t, size_t> endpoints(string_view, string_view, const string&) const;
+
+        /**
+         * @brief Finds the index an edge added to the graph would take, throwing if an enabled edge of the same name exists.
+         * Requires the mutex to be held
+         * @param[in] : Unique human readable name for edge
+         */
+        size_t edge_slot(string_view) const;
+
+        /**
+         * @brief Adds an edge to the graph and records it. Requires the mutex to be held
+         * @param[in] : Edge to add, indexed by edge_slot
+         */
+        void insert_edge(EdgeAll&&);
+
+        /**
+         * @brief Records an edge added to graph in the table of all edges
+         * @details An edge with the index of an existing edge, i.e. a disabled edge of the same code, replaces it. Requires the mutex
+         * to be held
+         * @param[in] : Edge to record
+         */
+        void store_edge(EdgeAll&&);
+
+        /**
+         * @brief Enables or disables an edge in the table of all edges and in the edges seen by versions. Requires the mutex to be held
+         * @param[in] : Index of edge
+         * @param[in] : State of edge
+         */
+        void set_enabled(size_t, bool);
+
+        /**
+         * @brief Replaces the graph and its indices under a single hold of the mutex
+         * @param[in,out] : Graph to move in
+         * @param[in,out] : Mapping for verbose vertex names to move in
+         * @param[in,out] : All possible edges to move in
+         * @param[in,out] : Mapping for verbose edge names to all possible edges to move in
+         */
+        void replace(Graph&, map<string, Vertex, less<>>&, vector<EdgeAll>&, map<string, size_t, less<>>&);
+
+    public:
+        /**
+         * @brief Default constructs an empty Graph, publishing its first version
+         */
+        BaseGraph();
+
+        /**
+         * @brief Acquires a read only view of the current version of the graph
+         * @return A view pinning the version for its lifetime
+         */
+        GraphView view() const;
 
         /**
          * @brief Adds a vertex to the graph
@@ -357,7 +737,7 @@ class BaseGraph {
          * @param[in] : Processing time in seconds for outbound at source vertex
          * @param[in] : Cost of iterating the edge
          */
-        virtual void add_edge(string_view, string_view, string_view, const long, const long, const long, const double);
+        void add_edge(string_view, string_view, string_view, const long, const long, const long, const double);
 
         /**
          * @brief Adds a discrete edge to the graph
@@ -371,79 +751,195 @@ class BaseGraph {
          * @param[in] : Processing time in seconds for outbound at source vertex
          * @param[in] : Cost of iterating the edge
          */
-        virtual void add_edge(string_view, string_view, string_view, const long, const long, const long, const long, const long, const double);
+        void add_edge(string_view, string_view, string_view, const long, const long, const long, const long, const long, const double);
 
         /**
         * @brief Disable or enable an edge
         * @param[in] : Unique human readable name for edge
         * @param[in] : Enable/Disable the edge
         */
-        virtual void toggle_edge(string_view, bool);
+        void toggle_edge(string_view, bool);
+
+        /**
+         * @brief Disable or enable a set of edges as a single update
+         * @details Every edge is checked before any is toggled, hence either all edges are toggled or none is
+         * @param[in] : Edges to toggle, by their unique human readable name and state
+         * @return Number of edges whose state changed
+         */
+        size_t toggle_edges(const vector<ToggleArgs>&);
 
         /**
-         * @brief Finds the properties of an edge
+         * @brief Applies a list of mutations as a single update
+         * @details Every mutation is checked against the graph as left by those before it, before any is applied. Mutations are then
+         * applied in order under a single hold of the mutex and published as a single version, hence views see either none or all
+         * of them
+         * @param[in] : Mutations to apply
+         * @return Number of mutations applied
+         */
+        size_t apply(const vector<GraphMutation>&);
+
+        /**
+         * @brief Finds the properties of an edge in the current version of the graph, without taking the mutex
          * @param[in] : Source vertex
          * @param[in] : Edge name
-         * @return Property of matching edge
+         * @return Matching edge and its destination vertex
          */
-        pair<EdgeProperty, VertexProperty> lookup(string_view, string_view);
+        pair<EdgeAll, VertexProperty> lookup(string_view, string_view) const;
 
         /**
-         * @brief Finds and returns a path based on various relaxation criteria
-         * @param[in] : Source vertex
-         * @param[in] : Destination vertex
-         * @param[in] : Time of arrival at source vertex
-         * @param[in] : Maximum time to arrive at destination vertex
-         * @return A vector of Path representing an ideal path satisfying specified constraints
+         * @brief Writes a binary snapshot of the graph, including disabled edges
+         * @details The snapshot is written to a temporary file which is then renamed to the specified path
+         * @param[in] : Path to write the snapshot to
          */
-        virtual vector<Path> find_path(string_view, string_view, long, long) = 0;
+        void save_snapshot(string_view) const;
+
+        /**
+         * @brief Replaces the graph with the contents of a snapshot
+         * @details Outbound edges of each vertex are added from its range of offsets, each edge in a range being checked to leave that
+         * vertex. The graph is copied out of the snapshot rather than served from it, hence loading takes time linear in the size of the
+         * graph, and the snapshot need not stay mapped once loaded.
+         * @param[in] : Mapped snapshot to read the graph from
+         */
+        void load_snapshot(const Snapshot&);
+
+        /**
+         * @brief Replaces the graph with the edges read from an edges file
+         * @details The graph is built without holding any lock and swapped in under a single hold of the mutex
+         * @param[in] : Reader holding the parsed edges file
+         */
+        void load_edges(const EdgeReader&);
 
         /**
          * @brief Helper function to add vertex to graph.
          * @param[in] : Pointer to an instance of BaseGraph to which a vertex would be added
-         * @param[in] : Named keyword arguments for adding a vertex
+         * @param[in] : Typed arguments for adding a vertex
          * @return A json response indicating success or failure of the command and any additional output from the underlying command
          */
-        static json_map addv(shared_ptr<BaseGraph>, const map<string, any>&);
+        static json_map addv(shared_ptr<BaseGraph>, const VertexArgs&);
 
         /**
          * @brief Helper function to add a time-discrete edge to BaseGraph.
          * @param[in] : Pointer to an instance of BaseGraph to which an edge would be added
-         * @param[in] : Named keyword arguments for adding an edge
+         * @param[in] : Typed arguments for adding an edge
          * @return A json response indicating success or failure of the command and any additional output from the underlying command
          */
-        static json_map adde(shared_ptr<BaseGraph>, const map<string, any>&);
+        static json_map adde(shared_ptr<BaseGraph>, const EdgeArgs&);
 
         /**
          * @brief Helper function to add a continuous edge to BaseGraph.
          * @param[in] : Pointer to an instance of BaseGraph to which an edge would be added
-         * @param[in] : Named keyword arguments for adding an edge
+         * @param[in] : Typed arguments for adding an edge
          * @return A json response indicating success or failure of the command and any additional output from the underlying command
          */
-        static json_map addc(shared_ptr<BaseGraph>, const map<string, any>&);
+        static json_map addc(shared_ptr<BaseGraph>, const ContinuousEdgeArgs&);
 
         /**
          * @brief Helper function to enable/disable an edge in BaseGraph
          * @param[in] : Pointer to an instance of BaseGraph to which the edge would be toggled
-         * @param[in] : Named keyword arguments to respresent the edge being enabled/disabled
+         * @param[in] : Typed arguments to respresent the edge being enabled/disabled
          * @return A json response indicating success or failure of the command and any additional output from the underlying command
          */
-        static json_map modc(shared_ptr<BaseGraph>, const map<string, any>&);
+        static json_map modc(shared_ptr<BaseGraph>, const ToggleArgs&);
+
+        /**
+         * @brief Helper function to enable/disable a set of edges in BaseGraph as a single update
+         * @param[in] : Pointer to an instance of BaseGraph in which the edges would be toggled
+         * @param[in] : Typed arguments to respresent the edges being enabled/disabled
+         * @return A json response indicating success or failure of the command and the number of edges toggled
+         */
+        static json_map bmod(shared_ptr<BaseGraph>, const ToggleBatchArgs&);
+
+        /**
+         * @brief Helper function to apply a list of mutations to BaseGraph as a single update
+         * @param[in] : Pointer to an instance of BaseGraph to be mutated
+         * @param[in] : Typed arguments to respresent the mutations
+         * @return A json response indicating success or failure of the command and the number of mutations applied
+         */
+        static json_map txn(shared_ptr<BaseGraph>, const TransactionArgs&);
 
         /**
          * @brief Helper function to find an edge in BaseGraph.
          * @param[in] : Pointer to an instance of BaseGraph against which lookup is performed
-         * @param[in] : Named keyword arguments for lookup
+         * @param[in] : Typed arguments for lookup
+         * @return A json response indicating success or failure of the command and any additional output from the underlying command
+         */
+        static json_map look(shared_ptr<BaseGraph>, const LookupArgs&);
+
+        /**
+         * @brief Helper function to write a snapshot of BaseGraph.
+         * @param[in] : Pointer to an instance of BaseGraph to be written
+         * @param[in] : Typed arguments specifying the path to write to
          * @return A json response indicating success or failure of the command and any additional output from the underlying command
          */
-        static json_map look(shared_ptr<BaseGraph>, const map<string, any>&);
+        static json_map save(shared_ptr<BaseGraph>, const FileArgs&);
 
         /**
-         * @brief Helper function to find a multi-criteria shortest path in BaseGraph.
-         * @param[in] : Pointer to an instance of BaseGraph against which a path is traversed
-         * @param[in] : Named keyword arguments for path traversal
+         * @brief Helper function to replace BaseGraph with the contents of an edges file.
+         * @param[in] : Pointer to an instance of BaseGraph to be replaced
+         * @param[in] : Typed arguments specifying the path to read from
          * @return A json response indicating success or failure of the command and any additional output from the underlying command
          */
-        static json_map find(shared_ptr<BaseGraph>, const map<string, any>&);
+        static json_map load(shared_ptr<BaseGraph>, const FileArgs&);
+
+};
+
+/**
+ * @brief Read only view of a BaseGraph handed to solvers
+ * @details Pins a version of the underlying graph for its lifetime. Updates proceed while a view is alive, and are seen by views
+ * acquired after them only.
+ */
+class GraphView {
+    private:
+        /**
+         * @brief Version of the graph being viewed
+         */
+        shared_ptr<const GraphVersion> pinned;
+
+    public:
+        /**
+         * @brief Constructs a view of a version of the graph
+         * @param[in] : Version to be viewed
+         */
+        GraphView(shared_ptr<const GraphVersion>);
+
+        /**
+         * @brief Fetch the compact image of the graph traversed by solvers
+         * @details The image is built once per version of the graph, by the first view traversing it
+         * @return Constant reference to the image, valid for the lifetime of the view
+         */
+        const CompactGraph& compact() const;
+
+        /**
+         * @brief Fetch the compact image of the graph traversed by solvers, shared with its owners
+         * @return Pointer to the image, which outlives the view for as long as it is held
+         */
+        shared_ptr<const CompactGraph> compacted() const;
+
+        /**
+         * @brief Fetch the version of the graph viewed
+         */
+        uint64_t version() const;
+
+        /**
+         * @brief Finds a vertex by its human readable name
+         * @param[in] : Unique human readable name for the vertex
+         * @param[out] : Vertex matching the name, if found
+         * @return True if a matching vertex was found else False
+         */
+        bool vertex(string_view, Vertex&) const;
+
+        /**
+         * @brief Fetch the human readable name of a vertex
+         * @param[in] : Vertex in graph
+         * @return Name of vertex, valid for the lifetime of the view
+         */
+        string_view vertex_code(Vertex) const;
+
+        /**
+         * @brief Fetch the human readable name of an edge
+         * @param[in] : Properties of edge in graph or in its compact image
+         * @return Name of edge, valid for the lifetime of the view
+         */
+        string_view edge_code(const EdgeProperty&) const;
 };
 #endif
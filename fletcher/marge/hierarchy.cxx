@@ -0,0 +1,468 @@
+#include <algorithm>
+#include <queue>
+
+#include "hierarchy.hpp"
+
+/**
+ * @brief Out or in edges of a vertex remaining to be contracted, as the vertex at the other end paired with the index of the function
+ */
+typedef vector<pair<uint32_t, uint32_t> > Adjacent;
+
+/**
+ * @brief Takes a time modulo TIME_DURINAL
+ * @param[in] : Time, possibly negative
+ * @return Time of day, in [0, TIME_DURINAL)
+ */
+static long time_of_day(long time) {
+    return ((time % TIME_DURINAL) + TIME_DURINAL) % TIME_DURINAL;
+}
+
+/**
+ * @brief Finds the edge to a vertex amongst adjacent edges
+ * @param[in] : Adjacent edges
+ * @param[in] : Vertex at the other end
+ * @return Iterator to the edge, or end of adjacent edges if there is none
+ */
+static Adjacent::const_iterator adjacent(const Adjacent& edges, uint32_t vertex) {
+    return find_if(edges.begin(), edges.end(), [vertex](const pair<uint32_t, uint32_t>& edge) {
+        return edge.first == vertex;
+    });
+}
+
+ArrivalFunction::ArrivalFunction() : anytime(Leg{0, -1, NO_VIA, 0}) {}
+
+ArrivalFunction::ArrivalFunction(vector<Leg> candidates, const Leg& _anytime) : anytime(_anytime) {
+    if (candidates.empty()) {
+        return;
+    }
+
+    // Of legs departing together, the one arriving earliest is visited first from the back, hence dominates the others
+    sort(candidates.begin(), candidates.end(), [](const Leg& first, const Leg& second) {
+        return first.dep < second.dep || (first.dep == second.dep && first.dur > second.dur);
+    });
+
+    long next_day = P_L_INF;
+
+    for (auto const& leg: candidates) {
+        next_day = min(next_day, TIME_DURINAL + leg.dep + leg.dur);
+    }
+
+    long best = next_day;
+
+    for (size_t position = candidates.size(); position-- > 0;) {
+        const Leg& leg = candidates[position];
+        long arrival = leg.dep + leg.dur;
+
+        if (arrival < best && (anytime.dur < 0 || leg.dur < anytime.dur)) {
+            legs.push_back(leg);
+        }
+        best = min(best, arrival);
+    }
+    std::reverse(legs.begin(), legs.end());
+}
+
+bool ArrivalFunction::empty() const {
+    return legs.empty() && anytime.dur < 0;
+}
+
+const vector<Leg>& ArrivalFunction::departures() const {
+    return legs;
+}
+
+const Leg& ArrivalFunction::continuous() const {
+    return anytime;
+}
+
+long ArrivalFunction::arrival(long time, Leg& taken) const {
+    long best = P_L_INF;
+
+    if (!legs.empty()) {
+        long midnight = time - time_of_day(time);
+        auto found = lower_bound(legs.begin(), legs.end(), time - midnight, [](const Leg& leg, long departure) {
+            return leg.dep < departure;
+        });
+
+        if (found == legs.end()) {
+            midnight += TIME_DURINAL;
+            found = legs.begin();
+        }
+        best = midnight + found->dep + found->dur;
+        taken = *found;
+    }
+
+    if (anytime.dur >= 0 && time + anytime.dur <= best) {
+        best = time + anytime.dur;
+        taken = anytime;
+    }
+    return best;
+}
+
+long ArrivalFunction::arrival(long time) const {
+    Leg taken;
+    return arrival(time, taken);
+}
+
+ArrivalFunction ArrivalFunction::link(const ArrivalFunction& first, const ArrivalFunction& second, uint32_t via) {
+    if (first.empty() || second.empty()) {
+        return ArrivalFunction();
+    }
+
+    vector<Leg> legs;
+
+    for (auto const& leg: first.legs) {
+        long arrival = second.arrival(leg.dep + leg.dur);
+        legs.push_back(Leg{leg.dep, arrival - leg.dep, via, NO_VIA});
+    }
+
+    // Departing at any time before a leg of the second edge catches it, hence the leg departs earlier from source by as much
+    if (first.anytime.dur >= 0) {
+        for (auto const& leg: second.legs) {
+            legs.push_back(Leg{time_of_day(leg.dep - first.anytime.dur), leg.dur + first.anytime.dur, via, NO_VIA});
+        }
+    }
+
+    Leg anytime{0, -1, via, NO_VIA};
+
+    if (first.anytime.dur >= 0 && second.anytime.dur >= 0) {
+        anytime.dur = first.anytime.dur + second.anytime.dur;
+    }
+    return ArrivalFunction(move(legs), anytime);
+}
+
+ArrivalFunction ArrivalFunction::merge(const ArrivalFunction& first, const ArrivalFunction& second) {
+    vector<Leg> legs(first.legs);
+    legs.insert(legs.end(), second.legs.begin(), second.legs.end());
+
+    const Leg& anytime = (second.anytime.dur >= 0 && (first.anytime.dur < 0 || second.anytime.dur < first.anytime.dur)) ? second.anytime : first.anytime;
+    return ArrivalFunction(move(legs), anytime);
+}
+
+/**
+ * @brief Drops the legs of a shortcut for which another path remaining in the graph, of at most two edges, arrives no later
+ * @param[in] : Function of the shortcut
+ * @param[in] : Source vertex of the shortcut
+ * @param[in] : Target vertex of the shortcut
+ * @param[in] : Vertex being contracted
+ * @param[in] : Out edges of each vertex remaining to be contracted
+ * @param[in] : Functions of edges and shortcuts
+ * @return Function of the legs of the shortcut still required
+ */
+static ArrivalFunction witness(const ArrivalFunction& shortcut, uint32_t source, uint32_t target, uint32_t contracted, const vector<Adjacent>& outs, const vector<ArrivalFunction>& functions) {
+    const ArrivalFunction* direct = nullptr;
+    vector<pair<const ArrivalFunction*, const ArrivalFunction*> > hops;
+
+    for (auto const& out: outs[source]) {
+        if (out.first == contracted) {
+            continue;
+        }
+
+        if (out.first == target) {
+            direct = &functions[out.second];
+            continue;
+        }
+
+        auto onward = adjacent(outs[out.first], target);
+
+        if (onward != outs[out.first].end()) {
+            hops.push_back(make_pair(&functions[out.second], &functions[onward->second]));
+        }
+    }
+
+    if (direct == nullptr && hops.empty()) {
+        return shortcut;
+    }
+
+    // Arrival of witnesses never decreases with departure, hence a witness no later at the departure of a leg is no later wherever it is taken
+    auto witnessed = [&](long departure, long arrival) {
+        if (direct != nullptr && direct->arrival(departure) <= arrival) {
+            return true;
+        }
+
+        for (auto const& hop: hops) {
+            long midway = hop.first->arrival(departure);
+
+            if (midway != P_L_INF && hop.second->arrival(midway) <= arrival) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    vector<Leg> legs;
+
+    for (auto const& leg: shortcut.departures()) {
+        if (!witnessed(leg.dep, leg.dep + leg.dur)) {
+            legs.push_back(leg);
+        }
+    }
+
+    Leg anytime = shortcut.continuous();
+
+    if (anytime.dur >= 0) {
+        bool dominated = (direct != nullptr && direct->continuous().dur >= 0 && direct->continuous().dur <= anytime.dur);
+
+        for (auto const& hop: hops) {
+            long first = hop.first->continuous().dur, second = hop.second->continuous().dur;
+            dominated = dominated || (first >= 0 && second >= 0 && first + second <= anytime.dur);
+        }
+
+        if (dominated) {
+            anytime.dur = -1;
+        }
+    }
+    return ArrivalFunction(move(legs), anytime);
+}
+
+/**
+ * @brief Contracts a vertex, or simulates its contraction
+ * @param[in] : Vertex to contract
+ * @param[in,out] : Out edges of each vertex remaining to be contracted
+ * @param[in,out] : In edges of each vertex remaining to be contracted
+ * @param[in,out] : Functions of edges and shortcuts
+ * @param[in] : Flag to add shortcuts, or only count them
+ * @return Number of shortcuts required
+ */
+static size_t contract(uint32_t vertex, vector<Adjacent>& outs, vector<Adjacent>& ins, vector<ArrivalFunction>& functions, bool apply) {
+    size_t required = 0;
+
+    for (auto const& in: ins[vertex]) {
+        for (auto const& out: outs[vertex]) {
+            if (in.first == out.first) {
+                continue;
+            }
+
+            ArrivalFunction shortcut = ArrivalFunction::link(functions[in.second], functions[out.second], vertex);
+
+            if (!shortcut.empty()) {
+                shortcut = witness(shortcut, in.first, out.first, vertex, outs, functions);
+            }
+
+            if (shortcut.empty()) {
+                continue;
+            }
+            required++;
+
+            if (!apply) {
+                continue;
+            }
+
+            auto existing = adjacent(outs[in.first], out.first);
+
+            if (existing != outs[in.first].end()) {
+                functions[existing->second] = ArrivalFunction::merge(functions[existing->second], shortcut);
+            }
+            else {
+                uint32_t index = functions.size();
+                functions.push_back(move(shortcut));
+                outs[in.first].push_back(make_pair(out.first, index));
+                ins[out.first].push_back(make_pair(in.first, index));
+            }
+        }
+    }
+    return required;
+}
+
+Hierarchy::Hierarchy(const CompactGraph& compact, const Hierarchy* earlier) : built_from(compact.version()), any_continuous(false) {
+    const Compact& g = compact.graph();
+    uint32_t nvertices = boost::num_vertices(g);
+
+    vector<Adjacent> outs(nvertices), ins(nvertices);
+
+    // Parallel edges share a single function
+    {
+        vector<vector<Leg> > legs;
+        vector<Leg> fastest;
+
+        for (uint32_t vertex = 0; vertex < nvertices; vertex++) {
+            for (auto edges = boost::out_edges(CompactVertex(vertex), g); edges.first != edges.second; edges.first++) {
+                const EdgeProperty& eprop = g[*edges.first];
+                uint32_t target = boost::target(*edges.first, g);
+                uint32_t index = boost::get(boost::edge_index, g, *edges.first);
+
+                if (target == vertex || !compact.enabled(index)) {
+                    continue;
+                }
+
+                auto existing = adjacent(outs[vertex], target);
+                uint32_t function = legs.size();
+
+                if (existing != outs[vertex].end()) {
+                    function = existing->second;
+                }
+                else {
+                    outs[vertex].push_back(make_pair(target, function));
+                    ins[target].push_back(make_pair(vertex, function));
+                    legs.emplace_back();
+                    fastest.push_back(Leg{0, -1, NO_VIA, 0});
+                }
+
+                if (eprop.percon) {
+                    long dur = eprop._tip + eprop._tap + eprop._top;
+                    any_continuous = true;
+
+                    if (fastest[function].dur < 0 || dur < fastest[function].dur) {
+                        fastest[function] = Leg{0, dur, NO_VIA, index};
+                    }
+                }
+                else {
+                    legs[function].push_back(Leg{time_of_day(eprop.dep), eprop.dur, NO_VIA, index});
+                }
+            }
+        }
+
+        for (size_t function = 0; function < legs.size(); function++) {
+            functions.emplace_back(move(legs[function]), fastest[function]);
+        }
+    }
+
+    vector<vector<Shortcut> > ups(nvertices), downs(nvertices);
+
+    auto remove = [&](uint32_t vertex) {
+        for (auto const& out: outs[vertex]) {
+            ups[vertex].push_back(Shortcut{out.first, out.second});
+            auto& inbound = ins[out.first];
+            inbound.erase(adjacent(inbound, vertex));
+        }
+
+        for (auto const& in: ins[vertex]) {
+            downs[in.first].push_back(Shortcut{vertex, in.second});
+            auto& outbound = outs[in.first];
+            outbound.erase(adjacent(outbound, vertex));
+        }
+
+        outs[vertex].clear();
+        ins[vertex].clear();
+        order.push_back(vertex);
+    };
+
+    if (earlier != nullptr) {
+        vector<bool> ordered(nvertices);
+
+        for (uint32_t vertex: earlier->order) {
+            if (vertex < nvertices) {
+                ordered[vertex] = true;
+                contract(vertex, outs, ins, functions, true);
+                remove(vertex);
+            }
+        }
+
+        for (uint32_t vertex = 0; vertex < nvertices; vertex++) {
+            if (!ordered[vertex]) {
+                contract(vertex, outs, ins, functions, true);
+                remove(vertex);
+            }
+        }
+    }
+    else {
+        vector<long> removed_neighbours(nvertices);
+
+        auto priority = [&](uint32_t vertex) {
+            long required = contract(vertex, outs, ins, functions, false);
+            return required - long(outs[vertex].size() + ins[vertex].size()) + removed_neighbours[vertex];
+        };
+
+        priority_queue<pair<long, uint32_t>, vector<pair<long, uint32_t> >, greater<pair<long, uint32_t> > > queue;
+
+        for (uint32_t vertex = 0; vertex < nvertices; vertex++) {
+            queue.push(make_pair(priority(vertex), vertex));
+        }
+
+        while (!queue.empty()) {
+            uint32_t vertex = queue.top().second;
+            queue.pop();
+
+            long current = priority(vertex);
+
+            if (!queue.empty() && current > queue.top().first) {
+                queue.push(make_pair(current, vertex));
+                continue;
+            }
+
+            for (auto const& out: outs[vertex]) {
+                removed_neighbours[out.first]++;
+            }
+
+            for (auto const& in: ins[vertex]) {
+                removed_neighbours[in.first]++;
+            }
+
+            contract(vertex, outs, ins, functions, true);
+            remove(vertex);
+        }
+    }
+
+    up_offsets.assign(nvertices + 1, 0);
+    down_offsets.assign(nvertices + 1, 0);
+    into_offsets.assign(nvertices + 1, 0);
+
+    for (uint32_t vertex = 0; vertex < nvertices; vertex++) {
+        up.insert(up.end(), ups[vertex].begin(), ups[vertex].end());
+        down.insert(down.end(), downs[vertex].begin(), downs[vertex].end());
+        up_offsets[vertex + 1] = up.size();
+        down_offsets[vertex + 1] = down.size();
+
+        for (auto const& edge: downs[vertex]) {
+            into_offsets[edge.head + 1]++;
+        }
+    }
+
+    for (uint32_t vertex = 0; vertex < nvertices; vertex++) {
+        into_offsets[vertex + 1] += into_offsets[vertex];
+    }
+
+    into.resize(down.size());
+    vector<uint32_t> filled(into_offsets.begin(), into_offsets.end() - 1);
+
+    for (uint32_t vertex = 0; vertex < nvertices; vertex++) {
+        for (auto const& edge: downs[vertex]) {
+            into[filled[edge.head]++] = Shortcut{vertex, edge.function};
+        }
+    }
+}
+
+uint64_t Hierarchy::version() const {
+    return built_from;
+}
+
+size_t Hierarchy::vertices() const {
+    return order.size();
+}
+
+size_t Hierarchy::size() const {
+    return functions.size();
+}
+
+bool Hierarchy::continuous() const {
+    return any_continuous;
+}
+
+const ArrivalFunction& Hierarchy::function(uint32_t index) const {
+    return functions[index];
+}
+
+pair<const Shortcut*, const Shortcut*> Hierarchy::upward(uint32_t vertex) const {
+    return make_pair(up.data() + up_offsets[vertex], up.data() + up_offsets[vertex + 1]);
+}
+
+pair<const Shortcut*, const Shortcut*> Hierarchy::downward(uint32_t vertex) const {
+    return make_pair(down.data() + down_offsets[vertex], down.data() + down_offsets[vertex + 1]);
+}
+
+pair<const Shortcut*, const Shortcut*> Hierarchy::downward_into(uint32_t vertex) const {
+    return make_pair(into.data() + into_offsets[vertex], into.data() + into_offsets[vertex + 1]);
+}
+
+uint32_t Hierarchy::between(uint32_t source, uint32_t target) const {
+    for (auto edges = upward(source); edges.first != edges.second; edges.first++) {
+        if (edges.first->head == target) {
+            return edges.first->function;
+        }
+    }
+
+    for (auto edges = downward(source); edges.first != edges.second; edges.first++) {
+        if (edges.first->head == target) {
+            return edges.first->function;
+        }
+    }
+    throw logic_error("No edge between vertices of hierarchy");
+}
@@ -0,0 +1,267 @@
+/** @file hierarchy.hpp
+ * @brief Defines a time-dependent contraction hierarchy over the daily schedule of a compact graph
+ * @details Vertices are contracted one at a time in order of importance. Contracting a vertex replaces each path through it by a shortcut
+ * between its neighbours, unless another path is never later. A query then only ever ascends from source and descends to destination,
+ * visiting a small fraction of the graph. Shortcuts carry the time of arrival at their target as a function of the time of arrival at
+ * their source, as every edge departs at the same time each day.
+ */
+#ifndef HIERARCHY_HPP_INCLUDED
+#define HIERARCHY_HPP_INCLUDED
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+
+#include "compact.hpp"
+
+/**
+ * @brief Marks a leg made of a single edge of the graph rather than of a path through a contracted vertex
+ */
+const uint32_t NO_VIA = numeric_limits<uint32_t>::max();
+
+/**
+ * @brief A way of traversing an edge or shortcut, departing once a day or whenever its source is arrived at
+ */
+struct Leg {
+    /**
+     * @brief Time of departure from source, taken modulo TIME_DURINAL. Unused for legs departing at any time
+     */
+    long dep;
+
+    /**
+     * @brief Time between departure from source and arrival at target
+     */
+    long dur;
+
+    /**
+     * @brief Vertex contracted between source and target, or NO_VIA for a single edge
+     */
+    uint32_t via;
+
+    /**
+     * @brief Index of the edge in the compact image, if the leg is a single edge
+     */
+    uint32_t edge;
+};
+
+/**
+ * @brief Time of arrival at the target of an edge or shortcut as a function of the time of arrival at its source
+ * @details Holds the legs departing once a day which are not dominated by a leg departing later, along with the fastest leg departing at
+ * any time. Legs kept arrive later the later they depart, hence evaluation is a binary search. Arrival is never earlier for a later
+ * arrival at source, hence functions compose exactly.
+ */
+class ArrivalFunction {
+    private:
+        /**
+         * @brief Legs departing once a day, sorted by time of departure
+         */
+        vector<Leg> legs;
+
+        /**
+         * @brief Fastest leg departing at any time, with a negative duration if there is none
+         */
+        Leg anytime;
+
+    public:
+        /**
+         * @brief Constructs a function of no legs, never reaching target
+         */
+        ArrivalFunction();
+
+        /**
+         * @brief Constructs a function of legs, dropping legs which are dominated
+         * @param[in] : Legs departing once a day, in any order
+         * @param[in] : Fastest leg departing at any time, with a negative duration if there is none
+         */
+        ArrivalFunction(vector<Leg>, const Leg&);
+
+        /**
+         * @brief Checks if target can be reached at all
+         */
+        bool empty() const;
+
+        /**
+         * @brief Fetch the legs departing once a day
+         */
+        const vector<Leg>& departures() const;
+
+        /**
+         * @brief Fetch the fastest leg departing at any time
+         * @return Leg, with a negative duration if there is none
+         */
+        const Leg& continuous() const;
+
+        /**
+         * @brief Finds the time of arrival at target
+         * @param[in] : Time of arrival at source
+         * @param[out] : Leg traversed
+         * @return Time of arrival at target, or P_L_INF if target can not be reached
+         */
+        long arrival(long, Leg&) const;
+
+        /**
+         * @brief Finds the time of arrival at target
+         * @param[in] : Time of arrival at source
+         * @return Time of arrival at target, or P_L_INF if target can not be reached
+         */
+        long arrival(long) const;
+
+        /**
+         * @brief Composes the functions of consecutive edges into the function of a shortcut
+         * @param[in] : Function of the edge into the contracted vertex
+         * @param[in] : Function of the edge out of the contracted vertex
+         * @param[in] : Contracted vertex
+         * @return Function of the path through the contracted vertex
+         */
+        static ArrivalFunction link(const ArrivalFunction&, const ArrivalFunction&, uint32_t);
+
+        /**
+         * @brief Finds the earliest of two functions between the same vertices at every time
+         * @param[in] : First function
+         * @param[in] : Second function
+         * @return Function arriving as early as the earlier of both
+         */
+        static ArrivalFunction merge(const ArrivalFunction&, const ArrivalFunction&);
+};
+
+/**
+ * @brief An edge or shortcut of the hierarchy
+ */
+struct Shortcut {
+    /**
+     * @brief Vertex at the other end of the shortcut
+     */
+    uint32_t head;
+
+    /**
+     * @brief Index of the function of the shortcut
+     */
+    uint32_t function;
+};
+
+/**
+ * @brief Time-dependent contraction hierarchy of a version of the graph
+ * @details Built from a CompactGraph, then immutable and shared by all queries against that version. Edges of the hierarchy are held
+ * in compressed rows per vertex, split into those ascending to a vertex contracted later and those descending to a vertex contracted
+ * earlier, along with the reverse of the latter.
+ */
+class Hierarchy {
+    private:
+        /**
+         * @brief Version of the graph the hierarchy was built from
+         */
+        uint64_t built_from;
+
+        /**
+         * @brief Flag to indicate any enabled edge of the graph departs at any time
+         */
+        bool any_continuous;
+
+        /**
+         * @brief Vertices in order of contraction
+         */
+        vector<uint32_t> order;
+
+        /**
+         * @brief Functions of edges and shortcuts
+         */
+        vector<ArrivalFunction> functions;
+
+        /**
+         * @brief Offsets of the ascending out edges of each vertex, followed by their number
+         */
+        vector<uint32_t> up_offsets;
+
+        /**
+         * @brief Ascending out edges grouped by source vertex
+         */
+        vector<Shortcut> up;
+
+        /**
+         * @brief Offsets of the descending out edges of each vertex, followed by their number
+         */
+        vector<uint32_t> down_offsets;
+
+        /**
+         * @brief Descending out edges grouped by source vertex
+         */
+        vector<Shortcut> down;
+
+        /**
+         * @brief Offsets of the descending in edges of each vertex, followed by their number
+         */
+        vector<uint32_t> into_offsets;
+
+        /**
+         * @brief Descending in edges grouped by target vertex, with head holding the source vertex
+         */
+        vector<Shortcut> into;
+
+    public:
+        /**
+         * @brief Contracts the graph of a compact image
+         * @details Without an earlier hierarchy, vertices adding the fewest shortcuts against the edges they remove are contracted first,
+         * with priorities updated lazily. Otherwise, the order of the earlier hierarchy is reused, with vertices added since contracted
+         * last, hence no contraction is simulated and only shortcuts are rebuilt.
+         * @param[in] : Compact image of the graph
+         * @param[in] : Hierarchy of an earlier version of the graph, or nullptr
+         */
+        Hierarchy(const CompactGraph&, const Hierarchy*);
+
+        /**
+         * @brief Fetch the version of the graph the hierarchy was built from
+         */
+        uint64_t version() const;
+
+        /**
+         * @brief Fetch the number of vertices of the hierarchy
+         */
+        size_t vertices() const;
+
+        /**
+         * @brief Fetch the number of edges and shortcuts of the hierarchy
+         */
+        size_t size() const;
+
+        /**
+         * @brief Checks if any edge of the hierarchy departs at any time rather than once a day
+         */
+        bool continuous() const;
+
+        /**
+         * @brief Fetch the function of an edge or shortcut
+         * @param[in] : Index of the function
+         */
+        const ArrivalFunction& function(uint32_t) const;
+
+        /**
+         * @brief Fetch the out edges of a vertex to vertices contracted later
+         * @param[in] : Source vertex
+         * @return Pointers to the first and past the last edge
+         */
+        pair<const Shortcut*, const Shortcut*> upward(uint32_t) const;
+
+        /**
+         * @brief Fetch the out edges of a vertex to vertices contracted earlier
+         * @param[in] : Source vertex
+         * @return Pointers to the first and past the last edge
+         */
+        pair<const Shortcut*, const Shortcut*> downward(uint32_t) const;
+
+        /**
+         * @brief Fetch the in edges of a vertex from vertices contracted later
+         * @param[in] : Target vertex
+         * @return Pointers to the first and past the last edge, with head holding the source vertex
+         */
+        pair<const Shortcut*, const Shortcut*> downward_into(uint32_t) const;
+
+        /**
+         * @brief Finds the edge or shortcut between two vertices
+         * @param[in] : Source vertex
+         * @param[in] : Target vertex
+         * @return Index of the function of the edge
+         */
+        uint32_t between(uint32_t, uint32_t) const;
+};
+
+#endif
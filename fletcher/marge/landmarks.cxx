@@ -0,0 +1,199 @@
+#include <algorithm>
+#include <queue>
+
+#include "landmarks.hpp"
+
+/**
+ * @brief Edges of an image grouped by the vertex they leave or enter, as offsets per vertex and a head and edge index per edge
+ */
+struct Arcs {
+    vector<uint32_t> offsets;
+    vector<pair<uint32_t, uint32_t> > heads;
+};
+
+/**
+ * @brief Groups the edges of an image by source vertex, or by target vertex if reversed
+ * @param[in] : Compact image of the graph
+ * @param[in] : Flag to group edges by target vertex
+ * @return Edges grouped by vertex, each paired with the vertex at its other end
+ */
+static Arcs group_arcs(const Compact& g, bool reversed) {
+    size_t nvertices = boost::num_vertices(g);
+    Arcs arcs{vector<uint32_t>(nvertices + 1, 0), vector<pair<uint32_t, uint32_t> >(boost::num_edges(g))};
+
+    for (auto edges = boost::edges(g); edges.first != edges.second; edges.first++) {
+        arcs.offsets[(reversed ? boost::target(*edges.first, g) : boost::source(*edges.first, g)) + 1]++;
+    }
+
+    for (size_t vertex = 0; vertex < nvertices; vertex++) {
+        arcs.offsets[vertex + 1] += arcs.offsets[vertex];
+    }
+
+    vector<uint32_t> filled(arcs.offsets.begin(), arcs.offsets.end() - 1);
+
+    for (auto edges = boost::edges(g); edges.first != edges.second; edges.first++) {
+        uint32_t source = boost::source(*edges.first, g), target = boost::target(*edges.first, g);
+        uint32_t index = boost::get(boost::edge_index, g, *edges.first);
+        arcs.heads[filled[reversed ? target : source]++] = make_pair(reversed ? source : target, index);
+    }
+    return arcs;
+}
+
+/**
+ * @brief Computes the least distance from a vertex to every vertex along static edge weights
+ * @param[in] : Edges grouped by vertex
+ * @param[in] : Weight of each edge by index
+ * @param[in] : Vertex to start from
+ * @param[in] : Distance of unreachable vertices
+ * @param[out] : Distance of each vertex
+ */
+template <typename T> static void spread(const Arcs& arcs, const vector<T>& weights, uint32_t origin, T infinity, vector<T>& distances) {
+    typedef pair<T, uint32_t> Entry;
+    priority_queue<Entry, vector<Entry>, greater<Entry> > queue;
+
+    distances.assign(arcs.offsets.size() - 1, infinity);
+    distances[origin] = 0;
+    queue.push(make_pair(T(0), origin));
+
+    while (!queue.empty()) {
+        auto current = queue.top();
+        queue.pop();
+
+        if (current.first > distances[current.second]) {
+            continue;
+        }
+
+        for (uint32_t position = arcs.offsets[current.second]; position < arcs.offsets[current.second + 1]; position++) {
+            auto const& head = arcs.heads[position];
+            T distance = current.first + weights[head.second];
+
+            if (distance < distances[head.first]) {
+                distances[head.first] = distance;
+                queue.push(make_pair(distance, head.first));
+            }
+        }
+    }
+}
+
+/**
+ * @brief Bounds the distance between two vertices from below by their distances to and from each landmark
+ * @details Distances are computed along non negative weights even for an unbounded metric, hence detect unreachable vertices regardless.
+ * @param[in] : Distance from each landmark to each vertex, by vertex then landmark
+ * @param[in] : Distance from each vertex to each landmark, by vertex then landmark
+ * @param[in] : Number of landmarks
+ * @param[in] : Source vertex
+ * @param[in] : Destination vertex
+ * @param[in] : Distance of unreachable vertices
+ * @param[in] : Flag to indicate the metric is bounded
+ * @return Lower bound, or infinity if destination can not be reached from source
+ */
+template <typename T> static T lower_bound_of(const vector<T>& from, const vector<T>& to, size_t nlandmarks, uint32_t src, uint32_t dst, T infinity, bool bounded) {
+    T lower = 0;
+
+    for (size_t landmark = 0; landmark < nlandmarks; landmark++) {
+        T src_to = to[src * nlandmarks + landmark], dst_to = to[dst * nlandmarks + landmark];
+        T src_from = from[src * nlandmarks + landmark], dst_from = from[dst * nlandmarks + landmark];
+
+        // A landmark reached from destination but not from source, or reaching source but not destination, proves destination unreachable
+        if ((src_to == infinity && dst_to != infinity) || (src_from != infinity && dst_from == infinity)) {
+            return infinity;
+        }
+
+        if (src_to != infinity && dst_to != infinity) {
+            lower = max(lower, src_to - dst_to);
+        }
+
+        if (src_from != infinity && dst_from != infinity) {
+            lower = max(lower, dst_from - src_from);
+        }
+    }
+    return bounded ? lower : 0;
+}
+
+Landmarks::Landmarks(const Compact& g, size_t count) : nlandmarks(0), timed(true), costed(true) {
+    size_t nvertices = boost::num_vertices(g);
+    size_t nedges = boost::num_edges(g);
+
+    vector<long> times(nedges);
+    vector<double> costs(nedges);
+
+    for (auto edges = boost::edges(g); edges.first != edges.second; edges.first++) {
+        Cost least = g[*edges.first].least();
+        uint32_t index = boost::get(boost::edge_index, g, *edges.first);
+
+        times[index] = least.second;
+        costs[index] = least.first;
+
+        if (times[index] < 0) {
+            timed = false;
+            times[index] = 0;
+        }
+
+        if (costs[index] < 0) {
+            costed = false;
+            costs[index] = 0;
+        }
+    }
+
+    if (nvertices == 0) {
+        return;
+    }
+
+    Arcs forward = group_arcs(g, false), backward = group_arcs(g, true);
+    vector<vector<long> > times_from, times_to;
+    vector<vector<double> > costs_from, costs_to;
+
+    // Least time from any landmark picked so far, initially from the first vertex which is not a landmark itself
+    vector<long> nearest;
+    spread(forward, times, 0, P_L_INF, nearest);
+
+    while (times_from.size() < count) {
+        uint32_t landmark = max_element(nearest.begin(), nearest.end()) - nearest.begin();
+
+        if (nearest[landmark] == 0) {
+            break;
+        }
+
+        times_from.emplace_back();
+        times_to.emplace_back();
+        costs_from.emplace_back();
+        costs_to.emplace_back();
+
+        spread(forward, times, landmark, P_L_INF, times_from.back());
+        spread(backward, times, landmark, P_L_INF, times_to.back());
+        spread(forward, costs, landmark, P_D_INF, costs_from.back());
+        spread(backward, costs, landmark, P_D_INF, costs_to.back());
+
+        for (size_t vertex = 0; vertex < nvertices; vertex++) {
+            nearest[vertex] = min(nearest[vertex], times_from.back()[vertex]);
+        }
+    }
+
+    nlandmarks = times_from.size();
+    time_from.resize(nvertices * nlandmarks);
+    time_to.resize(nvertices * nlandmarks);
+    cost_from.resize(nvertices * nlandmarks);
+    cost_to.resize(nvertices * nlandmarks);
+
+    // Distances of a vertex are adjacent, hence a bound reads two short runs of memory
+    for (size_t vertex = 0; vertex < nvertices; vertex++) {
+        for (size_t landmark = 0; landmark < nlandmarks; landmark++) {
+            time_from[vertex * nlandmarks + landmark] = times_from[landmark][vertex];
+            time_to[vertex * nlandmarks + landmark] = times_to[landmark][vertex];
+            cost_from[vertex * nlandmarks + landmark] = costs_from[landmark][vertex];
+            cost_to[vertex * nlandmarks + landmark] = costs_to[landmark][vertex];
+        }
+    }
+}
+
+size_t Landmarks::size() const {
+    return nlandmarks;
+}
+
+long Landmarks::time_bound(uint32_t src, uint32_t dst) const {
+    return lower_bound_of(time_from, time_to, nlandmarks, src, dst, P_L_INF, timed);
+}
+
+double Landmarks::cost_bound(uint32_t src, uint32_t dst) const {
+    return lower_bound_of(cost_from, cost_to, nlandmarks, src, dst, P_D_INF, costed);
+}
@@ -0,0 +1,77 @@
+/** @file landmarks.hpp
+ * @brief Defines lower bounds on the time and cost between vertices of a compact graph, as used for goal directed searches
+ * @details Least times and costs are computed between each vertex and a handful of landmark vertices, from the least time and cost of
+ * traversing each edge at any time of day. By the triangle inequality, the difference of the distances of two vertices to or from a
+ * landmark bounds the distance between them from below (ALT).
+ */
+#ifndef LANDMARKS_HPP_INCLUDED
+#define LANDMARKS_HPP_INCLUDED
+
+#include <cstdint>
+#include <vector>
+
+#include "compact.hpp"
+
+/**
+ * @brief Number of landmarks selected per image
+ */
+const size_t LANDMARK_COUNT = 8;
+
+/**
+ * @brief Least time and cost between each vertex of a compact image and a set of landmarks
+ * @details Landmarks are picked farthest first, each being the vertex farthest in time from those picked earlier, vertices unreachable
+ * from them first. A metric is left unbounded, i.e. every bound is 0, should any edge traverse in negative time or cost.
+ */
+class Landmarks {
+    private:
+        /**
+         * @brief Number of landmarks
+         */
+        size_t nlandmarks;
+
+        /**
+         * @brief Flags to indicate times and costs are bounded
+         */
+        bool timed, costed;
+
+        /**
+         * @brief Least time from each landmark to each vertex and from each vertex to each landmark, by vertex then landmark
+         */
+        vector<long> time_from, time_to;
+
+        /**
+         * @brief Least cost from each landmark to each vertex and from each vertex to each landmark, by vertex then landmark
+         */
+        vector<double> cost_from, cost_to;
+
+    public:
+        /**
+         * @brief Selects the landmarks of an image and computes the distances to and from them
+         * @param[in] : Compact image of the graph
+         * @param[in] : Optional number of landmarks. Defaults to LANDMARK_COUNT
+         */
+        Landmarks(const Compact&, size_t = LANDMARK_COUNT);
+
+        /**
+         * @brief Fetch the number of landmarks
+         */
+        size_t size() const;
+
+        /**
+         * @brief Bounds the time to travel between two vertices from below
+         * @param[in] : Source vertex
+         * @param[in] : Destination vertex
+         * @return Lower bound on the time of travel, or P_L_INF if destination can not be reached from source
+         */
+        long time_bound(uint32_t, uint32_t) const;
+
+        /**
+         * @brief Bounds the cost to travel between two vertices from below
+         * @param[in] : Source vertex
+         * @param[in] : Destination vertex
+         * @return Lower bound on the cost of travel, or P_D_INF if destination can not be reached from source
+         */
+        double cost_bound(uint32_t, uint32_t) const;
+};
+
+#endif
@@ -0,0 +1,342 @@
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <future>
+#include <stdexcept>
+#include <unordered_map>
+
+#include "loader.hpp"
+
+/**
+ * @brief Flags marking the keys seen while parsing an edge
+ */
+enum EdgeKey : unsigned {
+    KEY_SRC = 1 << 0,
+    KEY_DST = 1 << 1,
+    KEY_CONN = 1 << 2,
+    KEY_DEP = 1 << 3,
+    KEY_DUR = 1 << 4,
+    KEY_TIP = 1 << 5,
+    KEY_TAP = 1 << 6,
+    KEY_TOP = 1 << 7,
+    KEY_COST = 1 << 8
+};
+
+/**
+ * @brief Cursor over a chunk of an edges file
+ */
+class EdgeCursor {
+    private:
+        /**
+         * @brief Start of the buffer, used to report offsets
+         */
+        const char* base;
+
+        /**
+         * @brief Current position
+         */
+        const char* it;
+
+        /**
+         * @brief End of the chunk
+         */
+        const char* end;
+
+    public:
+        EdgeCursor(const char* _base, const char* _it, const char* _end) : base(_base), it(_it), end(_end) {}
+
+        [[noreturn]] void fail(const string& reason) const {
+            throw invalid_argument("Invalid edges file at offset " + to_string(it - base) + ". " + reason);
+        }
+
+        bool done() {
+            skip();
+            return it >= end;
+        }
+
+        void skip() {
+            while (it < end && (*it == ' ' || *it == '\n' || *it == '\r' || *it == '\t' || *it == ',')) {
+                it++;
+            }
+        }
+
+        void expect(char token) {
+            skip();
+
+            if (it >= end || *it != token) {
+                fail(string("Expected '") + token + "'");
+            }
+            it++;
+        }
+
+        bool peek(char token) {
+            skip();
+            return it < end && *it == token;
+        }
+
+        string_view text(deque<string>& storage) {
+            expect('"');
+            const char* start = it;
+
+            while (it < end && *it != '"' && *it != '\\') {
+                it++;
+            }
+
+            if (it < end && *it == '"') {
+                return string_view(start, (it++) - start);
+            }
+
+            string value(start, it - start);
+
+            while (it < end && *it != '"') {
+                if (*it == '\\') {
+                    if (++it >= end) {
+                        break;
+                    }
+
+                    switch (*it) {
+                        case 'b': value += '\b'; break;
+                        case 'f': value += '\f'; break;
+                        case 'n': value += '\n'; break;
+                        case 'r': value += '\r'; break;
+                        case 't': value += '\t'; break;
+                        case '"': case '\\': case '/': value += *it; break;
+                        default: fail("Unsupported escape sequence");
+                    }
+                }
+                else {
+                    value += *it;
+                }
+                it++;
+            }
+
+            if (it >= end) {
+                fail("Unterminated string");
+            }
+            it++;
+            storage.push_back(move(value));
+            return storage.back();
+        }
+
+        double number() {
+            skip();
+            char* parsed = nullptr;
+            double value = strtod(it, &parsed);
+
+            if (parsed == it || parsed > end) {
+                fail("Expected a number");
+            }
+            it = parsed;
+            return value;
+        }
+
+        void value(deque<string>& storage) {
+            skip();
+
+            if (peek('"')) {
+                text(storage);
+                return;
+            }
+
+            for (const char* literal: {"true", "false", "null"}) {
+                size_t length = strlen(literal);
+
+                if (size_t(end - it) >= length && strncmp(it, literal, length) == 0) {
+                    it += length;
+                    return;
+                }
+            }
+            number();
+        }
+};
+
+EdgeReader::EdgeReader(string_view path, size_t nthreads) {
+    ifstream input(path.to_string(), ios::binary);
+
+    if (!input) {
+        throw invalid_argument("Unable to open edges file <" + path.to_string() + ">");
+    }
+
+    input.seekg(0, ios::end);
+    buffer.resize(input.tellg());
+    input.seekg(0, ios::beg);
+    input.read(&buffer[0], buffer.size());
+
+    if (!input) {
+        throw runtime_error("Unable to read edges file <" + path.to_string() + ">");
+    }
+
+    vector<size_t> boundaries = split(nthreads == 0 ? 1 : nthreads);
+    size_t nchunks = boundaries.size() - 1;
+
+    unescaped.resize(nchunks);
+    vector<vector<EdgeRecord> > chunks(nchunks);
+    vector<future<void> > parsers;
+
+    for (size_t chunk = 1; chunk < nchunks; chunk++) {
+        parsers.push_back(async(launch::async, [this, &boundaries, &chunks, chunk]() {
+            parse(boundaries[chunk], boundaries[chunk + 1], unescaped[chunk], chunks[chunk]);
+        }));
+    }
+
+    if (nchunks > 0) {
+        parse(boundaries[0], boundaries[1], unescaped[0], chunks[0]);
+    }
+
+    for (auto& parser: parsers) {
+        parser.get();
+    }
+
+    size_t nrecords = 0;
+
+    for (auto const& chunk: chunks) {
+        nrecords += chunk.size();
+    }
+    records.reserve(nrecords);
+
+    for (auto& chunk: chunks) {
+        records.insert(records.end(), chunk.begin(), chunk.end());
+    }
+
+    unordered_map<string_view, size_t> interned;
+    interned.reserve(nrecords);
+
+    auto intern = [this, &interned](string_view code) {
+        auto found = interned.emplace(code, codes.size());
+
+        if (found.second) {
+            codes.push_back(code);
+        }
+        return found.first->second;
+    };
+
+    for (auto& record: records) {
+        record.src_index = intern(record.src);
+        record.dst_index = intern(record.dst);
+    }
+}
+
+vector<size_t> EdgeReader::split(size_t nchunks) const {
+    size_t begin = buffer.find('[');
+    size_t end = buffer.rfind(']');
+
+    if (begin == string::npos || end == string::npos || end < begin) {
+        throw invalid_argument("Invalid edges file. Expected a json array of edges");
+    }
+
+    vector<size_t> boundaries{begin + 1};
+    size_t target = (end - begin) / nchunks + 1;
+    bool quoted = false;
+    int depth = 0;
+
+    for (size_t position = begin + 1; position < end; position++) {
+        char current = buffer[position];
+
+        if (quoted) {
+            if (current == '\\') {
+                position++;
+            }
+            else if (current == '"') {
+                quoted = false;
+            }
+        }
+        else if (current == '"') {
+            quoted = true;
+        }
+        else if (current == '{') {
+            depth++;
+        }
+        else if (current == '}' && --depth == 0 && position + 1 - boundaries.back() >= target) {
+            boundaries.push_back(position + 1);
+        }
+    }
+
+    if (boundaries.back() != end) {
+        boundaries.push_back(end);
+    }
+    return boundaries;
+}
+
+void EdgeReader::parse(size_t begin, size_t end, deque<string>& storage, vector<EdgeRecord>& parsed) const {
+    EdgeCursor cursor{buffer.data(), buffer.data() + begin, buffer.data() + end};
+
+    while (!cursor.done()) {
+        EdgeRecord record;
+        unsigned seen = 0;
+
+        cursor.expect('{');
+
+        while (!cursor.peek('}')) {
+            string_view key = cursor.text(storage);
+            cursor.expect(':');
+
+            if (key == "src") {
+                record.src = cursor.text(storage);
+                seen |= KEY_SRC;
+            } else
+
+            if (key == "dst") {
+                record.dst = cursor.text(storage);
+                seen |= KEY_DST;
+            } else
+
+            if (key == "conn") {
+                record.conn = cursor.text(storage);
+                seen |= KEY_CONN;
+            } else
+
+            if (key == "dep") {
+                record.dep = cursor.number();
+                seen |= KEY_DEP;
+            } else
+
+            if (key == "dur") {
+                record.dur = cursor.number();
+                seen |= KEY_DUR;
+            } else
+
+            if (key == "tip") {
+                record.tip = cursor.number();
+                seen |= KEY_TIP;
+            } else
+
+            if (key == "tap") {
+                record.tap = cursor.number();
+                seen |= KEY_TAP;
+            } else
+
+            if (key == "top") {
+                record.top = cursor.number();
+                seen |= KEY_TOP;
+            } else
+
+            if (key == "cost") {
+                record.cost = cursor.number();
+                seen |= KEY_COST;
+            }
+            else {
+                cursor.value(storage);
+            }
+        }
+        cursor.expect('}');
+
+        unsigned required = KEY_SRC | KEY_DST | KEY_CONN | KEY_TIP | KEY_TAP | KEY_TOP;
+
+        if (record.dur != 0) {
+            required |= KEY_DEP | KEY_COST;
+        }
+
+        if ((seen & required) != required) {
+            cursor.fail("Edge <" + record.conn.to_string() + "> is missing required keys");
+        }
+        parsed.push_back(record);
+    }
+}
+
+const vector<EdgeRecord>& EdgeReader::edges() const {
+    return records;
+}
+
+const vector<string_view>& EdgeReader::vertices() const {
+    return codes;
+}
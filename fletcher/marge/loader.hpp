@@ -0,0 +1,145 @@
+/** @file loader.hpp
+ * @brief Defines a parallel reader for files listing the edges of a network
+ * @details An edges file is a json array of flat objects, each describing an edge as
+ * {"src": STR, "dst": STR, "conn": STR, "dep": INT, "dur": INT, "tip": INT, "tap": INT, "top": INT, "cost": DBL}.
+ * Edges with a zero or missing duration are continuous. Unknown keys are ignored.
+ */
+#ifndef LOADER_HPP_INCLUDED
+#define LOADER_HPP_INCLUDED
+
+#include <deque>
+#include <string>
+#include <thread>
+#include <vector>
+#include <experimental/string_view>
+
+using namespace std;
+using std::experimental::string_view;
+
+/**
+ * @brief Structure representing an edge as read from an edges file
+ * @details Codes are views into the buffer held by the EdgeReader which produced the record
+ */
+struct EdgeRecord {
+    /**
+     * @brief Code of source vertex
+     */
+    string_view src;
+
+    /**
+     * @brief Code of destination vertex
+     */
+    string_view dst;
+
+    /**
+     * @brief Unique human readable name of the edge
+     */
+    string_view conn;
+
+    /**
+     * @brief Index of source vertex in EdgeReader::vertices()
+     */
+    size_t src_index = 0;
+
+    /**
+     * @brief Index of destination vertex in EdgeReader::vertices()
+     */
+    size_t dst_index = 0;
+
+    /**
+     * @brief Time of departure from source vertex
+     */
+    long dep = 0;
+
+    /**
+     * @brief Duration of iterating the edge
+     */
+    long dur = 0;
+
+    /**
+     * @brief Processing time in seconds for inbound at destination vertex
+     */
+    long tip = 0;
+
+    /**
+     * @brief Processing time in seconds for aggregation at source vertex
+     */
+    long tap = 0;
+
+    /**
+     * @brief Processing time in seconds for outbound at source vertex
+     */
+    long top = 0;
+
+    /**
+     * @brief Cost of iterating the edge
+     */
+    double cost = 0;
+};
+
+/**
+ * @brief Reads and parses an edges file
+ * @details The file is read at once and split into chunks of whole objects which are parsed in parallel.
+ * Vertex codes are interned in order of their first appearance.
+ */
+class EdgeReader {
+    private:
+        /**
+         * @brief Contents of the edges file
+         */
+        string buffer;
+
+        /**
+         * @brief Storage for codes which had to be unescaped and can not be viewed in buffer
+         */
+        vector<deque<string> > unescaped;
+
+        /**
+         * @brief Edges in order of their appearance in file
+         */
+        vector<EdgeRecord> records;
+
+        /**
+         * @brief Unique vertex codes in order of their first appearance
+         */
+        vector<string_view> codes;
+
+        /**
+         * @brief Splits the buffer into chunks of whole objects
+         * @param[in] : Desired number of chunks
+         * @return Offsets of chunk boundaries in buffer, including start and end
+         */
+        vector<size_t> split(size_t) const;
+
+        /**
+         * @brief Parses all objects in a chunk of the buffer
+         * @param[in] : Offset of start of chunk
+         * @param[in] : Offset of end of chunk
+         * @param[in,out] : Storage for unescaped codes
+         * @param[out] : Edges parsed from the chunk
+         */
+        void parse(size_t, size_t, deque<string>&, vector<EdgeRecord>&) const;
+
+    public:
+        /**
+         * @brief Reads and parses an edges file
+         * @param[in] : Path to the edges file
+         * @param[in] : Optional number of threads to parse with. Defaults to the number of hardware threads
+         */
+        EdgeReader(string_view, size_t = thread::hardware_concurrency());
+
+        EdgeReader(const EdgeReader&) = delete;
+        EdgeReader& operator = (const EdgeReader&) = delete;
+
+        /**
+         * @brief Fetch the edges read from file
+         */
+        const vector<EdgeRecord>& edges() const;
+
+        /**
+         * @brief Fetch the unique vertex codes referred to by edges
+         */
+        const vector<string_view>& vertices() const;
+};
+
+#endif
@@ -1,73 +1,188 @@
-#include <queue>
+#include <algorithm>
+#include "landmarks.hpp"
 #include "optimal.hpp"
+#include "queue.hpp"
 
 bool Compare::operator () (const pair<Vertex, Cost>& first, const pair<Vertex, Cost>& second) const {
     return first.second > second.second;
 }
 
-void Optimal::run_dijkstra(Vertex src, Vertex dst, DistanceMap& dmap, PredecessorMap& pmap, Cost inf, Cost zero, long t_max) {
+/**
+ * @brief Binary heap of vertices by key, required over images holding edges of negative time or cost
+ */
+struct BinaryQueue {
+    static const bool monotone = false;
+    vector<pair<Vertex, Cost> > heap;
 
-    vector<int> visited(boost::num_vertices(g));
-    priority_queue<pair<Vertex, Cost>, vector<pair<Vertex, Cost> >, Compare> bin_heap;
+    void reset(long) {
+        heap.clear();
+    }
 
-    for (auto vertices = boost::vertices(g); vertices.first != vertices.second; vertices.first++) {
-        Vertex vertex = *vertices.first;
-        dmap[vertex] = inf;
-        visited[vertex] = 0;
+    bool empty() const {
+        return heap.empty();
     }
 
-    dmap[src] = zero;
+    void push(Vertex vertex, const Cost& key) {
+        heap.push_back(make_pair(vertex, key));
+        push_heap(heap.begin(), heap.end(), Compare());
+    }
 
-    /*
-    for (auto vertices = boost::vertices(g); vertices.first != vertices.second; vertices.first++) {
-        Vertex vertex = *vertices.first;
-        bin_heap.push(make_pair(vertex, dmap[vertex]));
-    }*/
-    bin_heap.push(make_pair(src, dmap[src]));
+    Vertex pop() {
+        pop_heap(heap.begin(), heap.end(), Compare());
+        Vertex vertex = heap.back().first;
+        heap.pop_back();
+        return vertex;
+    }
+};
+
+/**
+ * @brief Radix heap of vertices by time, as keyed when optimizing on time
+ */
+struct TimeQueue {
+    static const bool monotone = true;
+    RadixHeap<TimeKey> heap;
+    long base;
+
+    void reset(long _base) {
+        heap.clear();
+        base = _base;
+    }
 
-    while (!bin_heap.empty()) {
-        auto current = bin_heap.top();
-        bin_heap.pop();
+    bool empty() const {
+        return heap.empty();
+    }
 
-        if (dmap[current.first] == inf) {
-            break;
+    void push(Vertex vertex, const Cost& key) {
+        heap.push(time_key(base, key.second), vertex);
+    }
+
+    Vertex pop() {
+        return heap.pop().second;
+    }
+};
+
+/**
+ * @brief Two level radix heap of vertices by cost then time, as keyed when optimizing on cost
+ */
+struct CostTimeQueue {
+    static const bool monotone = true;
+    RadixHeap<CostTimeKey> heap;
+    long base;
+
+    void reset(long _base) {
+        heap.clear();
+        base = _base;
+    }
+
+    bool empty() const {
+        return heap.empty();
+    }
+
+    void push(Vertex vertex, const Cost& key) {
+        heap.push(cost_time_key(base, key.first, key.second), vertex);
+    }
+
+    Vertex pop() {
+        return heap.pop().second;
+    }
+};
+
+/**
+ * @brief Queues and workspace of the searches of a thread, reused across searches
+ */
+static thread_local BinaryQueue binary_queue;
+static thread_local TimeQueue time_queue;
+static thread_local CostTimeQueue cost_time_queue;
+static thread_local Workspace workspace;
+
+template <typename Q> void Optimal::run_dijkstra(Q& queue, Workspace& workspace, const CompactGraph& compact, Vertex src, const vector<Vertex>& dsts, Cost zero, long t_max, const Landmarks* bounds, const function<void(Vertex)>& settled) const {
+    const Compact& g = compact.graph();
+
+    workspace.reset(boost::num_vertices(g));
+    size_t remaining = 0;
+
+    for (Vertex dst: dsts) {
+        if (workspace.await(dst)) {
+            remaining++;
         }
+    }
+
+    workspace.reach(src, zero, CompactEdgeDescriptor());
 
-        if (current.first == dst) {
+    // Keys of vertices are their cost and time, or their time alone if cost is ignored
+    auto key = [this](const Cost& estimated) {
+        return ignore_cost ? Cost{0, estimated.second} : estimated;
+    };
+
+    queue.reset(zero.second);
+    queue.push(src, key(zero));
+
+    while (!queue.empty()) {
+        Vertex current = queue.pop();
+        Cost distance = workspace.distance(current);
+
+        if (distance.second == P_L_INF) {
             break;
         }
 
+        if (Q::monotone) {
+            if (workspace.state(current) == VERTEX_SETTLED) {
+                continue;
+            }
+            workspace.settle(current);
+        }
+
+        if (workspace.arrive(current)) {
+            settled(current);
+
+            if (--remaining == 0) {
+                break;
+            }
+        }
+
         out_edge_iter e_iter, e_iter_end;
 
-        for ( tie(e_iter, e_iter_end) = boost::out_edges(current.first, g); e_iter != e_iter_end; e_iter++) {
-            EdgeProperty edge = g[*e_iter];
+        // Out edges of a vertex, their targets and their attributes are each contiguous in the compact image
+        for ( tie(e_iter, e_iter_end) = boost::out_edges(CompactVertex(current), g); e_iter != e_iter_end; e_iter++) {
+            if (!compact.enabled(*e_iter)) {
+                continue;
+            }
+
+            const EdgeProperty& edge = g[*e_iter];
             Vertex target = boost::target(*e_iter, g);
 
-            Cost edge_iterated = edge.weight(dmap[current.first], t_max);
+            Cost edge_iterated = edge.weight(distance, t_max);
+            Cost estimated = edge_iterated;
 
-            if (edge_iterated != inf) {
-                if (visited[target] == 0) {
-                    dmap[target] = edge_iterated;
-                    pmap[target] = *e_iter;
-                    bin_heap.push(make_pair(target, dmap[target]));
-                    visited[target] = 1;
-                }
-                else if (visited[target] == 1) {
-                    bool less = false;
-
-                    if (ignore_cost) {
-                        less = edge_iterated.second < dmap[target].second;
-                    }
-                    else {
-                        less = edge_iterated < dmap[target];
-                    }
-
-                    if (less) {
-                        dmap[target] = edge_iterated;
-                        pmap[target] = *e_iter;
-                        bin_heap.push(make_pair(target, dmap[target]));
-                    }
+            if (edge_iterated.second == P_L_INF) {
+                continue;
+            }
+
+            // Vertices are queued on their cost and time bounded to destination, skipping those unable to reach it in time
+            if (bounds != nullptr) {
+                long time_left = bounds->time_bound(target, dsts.front());
+
+                if (time_left == P_L_INF || edge_iterated.second + time_left > t_max) {
+                    continue;
                 }
+                estimated = Cost{edge_iterated.first + bounds->cost_bound(target, dsts.front()), edge_iterated.second + time_left};
+            }
+
+            VertexState state = workspace.state(target);
+
+            if (state == VERTEX_SETTLED) {
+                continue;
+            }
+
+            bool less = true;
+
+            if (state == VERTEX_REACHED) {
+                less = ignore_cost ? edge_iterated.second < workspace.distance(target).second : edge_iterated < workspace.distance(target);
+            }
+
+            if (less) {
+                workspace.reach(target, edge_iterated, *e_iter);
+                queue.push(target, key(estimated));
             }
         }
     }
@@ -75,65 +190,103 @@ void Optimal::run_dijkstra(Vertex src, Vertex dst, DistanceMap& dmap, Predecesso
 
 Optimal::Optimal(bool _ignore_cost) : ignore_cost(_ignore_cost) {}
 
-vector<Path> Optimal::find_path(string_view src, string_view dst, long t_start, long t_max) {
+vector<Path> Optimal::find_path(const GraphView& view, string_view src, string_view dst, long t_start, long t_max) const {
+    return find_paths(view, src, t_start, vector<pair<string_view, long> >{make_pair(dst, t_max)}).front();
+}
 
-    if (ignore_cost)
-        t_max = P_L_INF;
+vector<vector<Path> > Optimal::find_paths(const GraphView& view, string_view src, long t_start, const vector<pair<string_view, long> >& targets) const {
+    Vertex source;
 
-    if (vertex_map.find(src.to_string()) == vertex_map.end()) {
+    if (!view.vertex(src, source)) {
         throw invalid_argument("No source <> found");
     }
 
-    if (vertex_map.find(dst.to_string()) == vertex_map.end()) {
-        throw invalid_argument("No destination<> found");
-    }
+    vector<Vertex> destinations(targets.size());
+    map<long, vector<size_t> > limits;
 
-    Vertex source = vertex_map.at(src.to_string());
-    Vertex destination = vertex_map.at(dst.to_string());
+    for (size_t index = 0; index < targets.size(); index++) {
+        if (!view.vertex(targets[index].first, destinations[index])) {
+            throw invalid_argument("No destination<> found");
+        }
+        limits[ignore_cost ? P_L_INF : targets[index].second].push_back(index);
+    }
 
+    const CompactGraph& compact = view.compact();
     Cost zero = make_pair(0, t_start);
-    Cost inf = make_pair(P_D_INF, P_L_INF);
 
-    shared_lock<shared_timed_mutex> graph_read_lock(graph_mutex, defer_lock);
-    graph_read_lock.lock();
+    vector<vector<Path> > paths(targets.size());
 
-    DistanceMap distances(boost::num_vertices(g));
-    PredecessorMap predecessors(boost::num_vertices(g));
+    for (auto const& limit: limits) {
+        vector<Vertex> dsts;
+        vector<bool> traced(targets.size());
 
-    run_dijkstra(source, destination, distances, predecessors, inf, zero, t_max);
+        for (size_t index: limit.second) {
+            dsts.push_back(destinations[index]);
+        }
+
+        auto settled = [&](Vertex vertex) {
+            for (size_t index: limit.second) {
+                if (destinations[index] == vertex) {
+                    paths[index] = trace(view, source, vertex, workspace);
+                    traced[index] = true;
+                }
+            }
+        };
+
+        // Goal direction only pays off towards a single destination, bounding towards several costing a bound per destination
+        const Landmarks* bounds = (dsts.size() == 1) ? &compact.landmarks() : nullptr;
+
+        if (!compact.monotone()) {
+            run_dijkstra(binary_queue, workspace, compact, source, dsts, zero, limit.first, bounds, settled);
+        }
+        else if (ignore_cost) {
+            run_dijkstra(time_queue, workspace, compact, source, dsts, zero, limit.first, bounds, settled);
+        }
+        else {
+            run_dijkstra(cost_time_queue, workspace, compact, source, dsts, zero, limit.first, bounds, settled);
+        }
+
+        for (size_t index: limit.second) {
+            if (!traced[index]) {
+                paths[index] = trace(view, source, destinations[index], workspace);
+            }
+        }
+    }
+    return paths;
+}
 
+vector<Path> Optimal::trace(const GraphView& view, Vertex source, Vertex destination, const Workspace& workspace) const {
+    const Compact& g = view.compact().graph();
     vector<Path> path;
 
     Vertex current = destination;
-    Edge inbound;
+    CompactEdgeDescriptor inbound;
     long departure = P_L_INF, expected_by = P_L_INF;
     bool first = true;
 
     do {
-        auto distance = distances[current];
+        auto distance = workspace.distance(current);
 
         if (distance.second == P_L_INF) {
             return path;
         }
 
-        VertexProperty vprop = g[current];
-
         if(first) {
-            path.push_back(Path{g[current].code, "", "", distance.second, expected_by, departure, distance.first});
+            path.push_back(Path{view.vertex_code(current), "", "", distance.second, expected_by, departure, distance.first});
             first = false;
         }
         else {
-            EdgeProperty eprop = g[inbound];
+            const EdgeProperty& eprop = g[inbound];
             expected_by = distance.second + eprop.wait_time(distance.second);
             departure =  expected_by + eprop._tap + eprop._top;
-            path.push_back(Path{g[current].code, g[inbound].code, g[boost::target(inbound, g)].code, distance.second, expected_by, departure, distance.first});
+            path.push_back(Path{view.vertex_code(current), view.edge_code(eprop), view.vertex_code(boost::target(inbound, g)), distance.second, expected_by, departure, distance.first});
         }
 
         if (current == source) {
             break;
         }
 
-        inbound = predecessors[current];
+        inbound = workspace.predecessor(current);
         current = boost::source(inbound, g);
     } while (true);
 
@@ -5,12 +5,14 @@
 #ifndef OPTIMAL_HPP_INCLUDED
 #define OPTIMAL_HPP_INCLUDED
 
-#include "graph.hpp"
+#include <functional>
 
-typedef vector<Cost> DistanceMap;
-typedef vector<Edge> PredecessorMap;
+#include "compact.hpp"
+#include "landmarks.hpp"
+#include "solver.hpp"
+#include "workspace.hpp"
 
-typedef typename boost::graph_traits<Graph>::out_edge_iterator out_edge_iter;
+typedef typename boost::graph_traits<Compact>::out_edge_iterator out_edge_iter;
 
 /**
  * @brief Comparison operator to compare a pair of vertices and their associated costs
@@ -27,9 +29,9 @@ struct Compare {
 };
 
 /**
- * @brief Extends BaseGraph to implement a single criteria path optimization
+ * @brief Implements Solver as a single criteria path optimization
  */
-class Optimal : public BaseGraph {
+class Optimal : public Solver {
     private:
         /**
          * @brief Boolean to handle optimization on time(True) or cost(False)
@@ -38,15 +40,36 @@ class Optimal : public BaseGraph {
 
         /**
          * @brief Actual implementation of the path finding algorithm as a dijkstra
+         * @details The traversal stops once every destination vertex has been settled. Each destination is reported as it is settled,
+         * hence distances and predecessors traced at that point are identical to those of a traversal to that destination alone.
+         * Given lower bounds, the traversal is goal directed towards the first destination vertex: vertices are queued on their cost
+         * and time plus the bounds to destination, and vertices unable to reach destination within the time limit are skipped.
+         *
+         * Vertices are keyed on time alone if optimizing on time, else on cost then time. Over a monotone image keys popped never
+         * decrease, hence a vertex is settled once popped and later entries of it are skipped. Otherwise vertices are expanded each time
+         * they are popped, as in a label correcting search.
+         * @param[in,out] :     Queue of vertices by key, empty. Monotone queues are used over monotone images only
+         * @param[in,out] :     Workspace to record distances and predecessors of vertices in, reset by the traversal
+         * @param[in] :         Compact image of the graph to traverse, disabled edges being skipped
          * @param[in] :         Source vertex
-         * @param[in] :         Destination vertex
-         * @param[in,out] :     Map of vertices to their distances from source
-         * @param[in, out] :    Map of vertices to their predecessor when iterating from source
-         * @param[in] :         Infinite Cost
+         * @param[in] :         Destination vertices
          * @param[in] :         Zero/Base Cost
          * @param[in] :         Maximum duration by which the destination vertex must be reached
+         * @param[in] :         Lower bounds between vertices of the image, or nullptr to search undirected
+         * @param[in] :         Callback invoked with each destination vertex as it is settled
          */
-        void run_dijkstra(Vertex, Vertex, DistanceMap&, PredecessorMap&, Cost, Cost, long);
+        template <typename Q> void run_dijkstra(Q&, Workspace&, const CompactGraph&, Vertex, const vector<Vertex>&, Cost, long, const Landmarks*, const function<void(Vertex)>&) const;
+
+        /**
+         * @brief Traces the path to a destination vertex from the predecessors recorded by run_dijkstra
+         * @param[in] : View of the graph traversed
+         * @param[in] : Source vertex
+         * @param[in] : Destination vertex
+         * @param[in] : Workspace holding the distances and predecessors of vertices
+         * @return Path from source to destination, empty if destination is unreachable. Codes are views into the graph
+         */
+        vector<Path> trace(const GraphView&, Vertex, Vertex, const Workspace&) const;
+
     public:
         /**
          * @brief Default constructs the solver
@@ -55,13 +78,24 @@ class Optimal : public BaseGraph {
         Optimal(bool = false);
 
         /**
-         * @brief Implementation of path finder declared in BaseGraph
+         * @brief Implementation of path finder declared in Solver
+         * @param[in] : Read only view of the graph to traverse
          * @param[in] : Name of source vertex
          * @param[in] : Name of destination vertex
          * @param[in] : Time of arrival at source vertex
          * @param[in] : Time limit by which destination vertex needs to be arrived at
          */
-        vector<Path> find_path(string_view, string_view, long, long);
+        vector<Path> find_path(const GraphView&, string_view, string_view, long, long) const;
+
+        /**
+         * @brief Implementation of the multi destination path finder declared in Solver
+         * @details Destinations sharing a time limit share a single traversal. Time limits are ignored when optimizing on time.
+         * @param[in] : Read only view of the graph to traverse
+         * @param[in] : Name of source vertex
+         * @param[in] : Time of arrival at source vertex
+         * @param[in] : Names of destination vertices paired with the time limit by which each needs to be arrived at
+         */
+        vector<vector<Path> > find_paths(const GraphView&, string_view, long, const vector<pair<string_view, long> >&) const;
 };
 
 #endif
@@ -1,105 +1,228 @@
-// Include list - missing in BGL-rcsp
-#include <list>
-#include <boost/graph/r_c_shortest_paths.hpp>
+#include <algorithm>
+#include <cmath>
+#include <queue>
 
 #include "pareto.hpp"
 
-template <typename T> struct reversion_wrapper { T& iterable; };
-template <typename T> auto begin (reversion_wrapper<T> w) { return std::rbegin(w.iterable); }
-template <typename T> auto end (reversion_wrapper<T> w) { return std::rend(w.iterable); }
-template <typename T> reversion_wrapper<T> reverse (T&& iterable) { return { iterable }; }
+void LabelArena::clear() {
+    cost.clear();
+    time.clear();
+    parent.clear();
+    next.clear();
+    edge.clear();
+}
 
-Traversal::Traversal(double _cost, long _time) : cost(_cost), time(_time) {}
+uint32_t LabelArena::push(double _cost, long _time, uint32_t _parent, CompactEdgeDescriptor _edge) {
+    cost.push_back(_cost);
+    time.push_back(_time);
+    parent.push_back(_parent);
+    next.push_back(NO_LABEL);
+    edge.push_back(_edge);
+    return cost.size() - 1;
+}
 
-Traversal& Traversal::operator = (const Traversal& other) {
-    if (this == &other) {
-        return *this;
+void LabelBags::reset(size_t nvertices) {
+    if (head.size() != nvertices) {
+        head.assign(nvertices, NO_LABEL);
+        time.assign(nvertices, P_L_INF);
+        count.assign(nvertices, 0);
+    }
+    else {
+        for (uint32_t vertex: touched) {
+            head[vertex] = NO_LABEL;
+            time[vertex] = P_L_INF;
+            count[vertex] = 0;
+        }
     }
+    touched.clear();
+}
 
-    this->~Traversal();
-    new (this) Traversal(other);
-    return *this;
+bool LabelBags::dominated(uint32_t vertex, long _time) const {
+    return time[vertex] <= _time;
 }
 
-bool operator == (const Traversal& first, const Traversal& second) {
-    return first.cost == second.cost && first.time == second.time;
+bool LabelBags::dominated(uint32_t vertex, double _cost, long _time, const LabelArena& arena) const {
+    for (uint32_t label = head[vertex]; label != NO_LABEL && arena.time[label] <= _time; label = arena.next[label]) {
+        if (arena.cost[label] <= _cost) {
+            return true;
+        }
+    }
+    return false;
 }
 
-bool operator < (const Traversal& first, const Traversal& second) {
-    if (first.cost > second.cost)
-        return false;
+void LabelBags::settle(uint32_t vertex, uint32_t label, LabelArena& arena) {
+    if (head[vertex] == NO_LABEL) {
+        touched.push_back(vertex);
+    }
+    arena.next[label] = head[vertex];
+    head[vertex] = label;
+    time[vertex] = arena.time[label];
+    count[vertex]++;
+}
 
-    if (first.cost == second.cost)
-        return first.time < second.time;
+/**
+ * @brief Labels and bags of the searches of a thread, reused across searches
+ */
+static thread_local LabelArena arena;
+static thread_local LabelBags bags;
 
-    return true;
-}
+vector<uint32_t> Pareto::run_labels(const CompactGraph& compact, const Landmarks& bounds, Vertex source, Vertex destination, long t_start, long t_max, size_t limit, const Tolerance& tolerance, LabelArena& labels, LabelBags& settled, bool& exact) const {
+    const Compact& g = compact.graph();
 
+    typedef pair<Cost, uint32_t> Entry;
+    priority_queue<Entry, vector<Entry>, greater<Entry> > queue;
+    vector<uint32_t> solutions;
 
-TimeConstraint::TimeConstraint() {}
+    labels.clear();
+    settled.reset(boost::num_vertices(g));
+    exact = true;
 
-TimeConstraint::TimeConstraint(long _t_max) : t_max(_t_max) {}
+    if (t_start > t_max || bounds.time_bound(source, destination) == P_L_INF) {
+        return solutions;
+    }
 
-inline bool TimeConstraint::operator () (const Graph& g, Traversal& fresh, const Traversal& old, Edge edge) const {
-    EdgeProperty eprop = g[edge];
-    Cost traversed = eprop.weight(Cost{old.cost, old.time}, t_max);
-    fresh.cost = traversed.first;
-    fresh.time = traversed.second;
-    return fresh.time <= t_max ? true : false;
-}
+    // Labels at a vertex are keyed on the same bounds, hence are still settled in order of cost then time at each vertex
+    auto key = [&bounds, &tolerance, destination](Vertex vertex, double cost, long time) {
+        double estimate = cost + bounds.cost_bound(vertex, destination);
+
+        if (tolerance.cost > 0) {
+            estimate = floor(estimate / tolerance.cost) * tolerance.cost;
+        }
+        return Cost{estimate, time + bounds.time_bound(vertex, destination)};
+    };
+
+    // Labels dropped within tolerance only are told apart from those dominated outright, the latter leaving paths exact
+    bool relaxed = tolerance.cost > 0 || tolerance.time > 0;
+
+    auto dominated = [&settled, &labels, &tolerance, &exact, relaxed](Vertex vertex, double cost, long time) {
+        if (!settled.dominated(vertex, time + tolerance.time)) {
+            return false;
+        }
+
+        if (relaxed && exact && !settled.dominated(vertex, cost, time, labels)) {
+            exact = false;
+        }
+        return true;
+    };
+
+    queue.push(make_pair(key(source, 0, t_start), labels.push(0, t_start, NO_LABEL, CompactEdgeDescriptor())));
+
+    while (!queue.empty() && solutions.size() < limit) {
+        uint32_t label = queue.top().second;
+        queue.pop();
+
+        // The vertex of a label is that of the target of its edge, the source label aside
+        Vertex current = (labels.parent[label] == NO_LABEL) ? source : boost::target(labels.edge[label], g);
+
+        if (dominated(current, labels.cost[label], labels.time[label])) {
+            continue;
+        }
+
+        if (tolerance.vertex_labels > 0 && current != destination && settled.count[current] >= tolerance.vertex_labels) {
+            exact = false;
+            continue;
+        }
+        settled.settle(current, label, labels);
 
-inline bool TraversalDominance::operator () (const Traversal& first, const Traversal& second) const {
-    return first.cost <= second.cost && first.time <= second.time;
+        if (current == destination) {
+            solutions.push_back(label);
+            continue;
+        }
+
+        Cost start{labels.cost[label], labels.time[label]};
+
+        for (auto edges = boost::out_edges(CompactVertex(current), g); edges.first != edges.second; edges.first++) {
+            if (!compact.enabled(*edges.first)) {
+                continue;
+            }
+
+            Vertex target = boost::target(*edges.first, g);
+            Cost reached = g[*edges.first].weight(start, t_max);
+
+            if (reached.second > t_max || dominated(target, reached.first, reached.second)) {
+                continue;
+            }
+
+            long time_left = bounds.time_bound(target, destination);
+
+            // Labels unable to reach destination in time, or only behind a solution already found, are dropped before being queued
+            if (time_left == P_L_INF || reached.second + time_left > t_max) {
+                continue;
+            }
+
+            if (dominated(destination, reached.first + bounds.cost_bound(target, destination), reached.second + time_left)) {
+                continue;
+            }
+
+            // Once the budget is spent labels queued are still settled, hence paths already reaching destination are found
+            if (tolerance.labels > 0 && labels.cost.size() >= tolerance.labels) {
+                exact = false;
+                break;
+            }
+
+            queue.push(make_pair(key(target, reached.first, reached.second), labels.push(reached.first, reached.second, label, *edges.first)));
+        }
+    }
+
+    // Solutions keyed alike within the cost tolerance are settled in order of time instead of cost
+    sort(solutions.begin(), solutions.end(), [&labels](uint32_t first, uint32_t second) {
+        return make_pair(labels.cost[first], labels.time[first]) < make_pair(labels.cost[second], labels.time[second]);
+    });
+    return solutions;
 }
 
-vector<Path> Pareto::find_path(string_view src, string_view dst, long t_start, long t_max) {
+vector<Path> Pareto::trace(const GraphView& view, const LabelArena& labels, uint32_t label, long t_start, long t_max) const {
+    const Compact& g = view.compact().graph();
+    vector<CompactEdgeDescriptor> edges;
+
+    for (; labels.parent[label] != NO_LABEL; label = labels.parent[label]) {
+        edges.push_back(labels.edge[label]);
+    }
+    reverse(edges.begin(), edges.end());
+
     vector<Path> path;
-    if (vertex_map.find(src.to_string()) == vertex_map.end()) {
+    Cost current{0, t_start};
+    Vertex target = boost::source(edges.front(), g);
+
+    for (auto const& edge: edges) {
+        Vertex source = boost::source(edge, g);
+        target = boost::target(edge, g);
+        const EdgeProperty& eprop = g[edge];
+        long expected_by = current.second + eprop.wait_time(current.second);
+        long departure = expected_by + eprop._tap + eprop._top;
+        path.push_back(Path{view.vertex_code(source), view.edge_code(eprop), view.vertex_code(target), current.second, expected_by, departure, current.first});
+        current = eprop.weight(current, t_max);
+    }
+    path.push_back(Path{view.vertex_code(target), "", "", current.second, P_L_INF, P_L_INF, current.first});
+    return path;
+}
+
+vector<Path> Pareto::find_path(const GraphView& view, string_view src, string_view dst, long t_start, long t_max) const {
+    bool exact;
+    auto paths = find_pareto(view, src, dst, t_start, t_max, 1, Tolerance(), exact);
+    return paths.empty() ? vector<Path>() : paths.front();
+}
+
+vector<vector<Path> > Pareto::find_pareto(const GraphView& view, string_view src, string_view dst, long t_start, long t_max, size_t limit, const Tolerance& tolerance, bool& exact) const {
+    Vertex source, destination;
+
+    if (!view.vertex(src, source)) {
         throw invalid_argument("P: Invalid source");
     }
 
-    if (vertex_map.find(dst.to_string()) == vertex_map.end()) {
+    if (!view.vertex(dst, destination)) {
         throw invalid_argument("P: Invalid destination");
     }
 
-    Vertex source = vertex_map.at(src.to_string());
-    Vertex destination = vertex_map.at(dst.to_string());
-
-    vector<vector<Edge> > optimal_solutions;
-    vector<Traversal> pareto_optimal_paths;
-
-    shared_lock<shared_timed_mutex> graph_read_lock(graph_mutex, defer_lock);
-    graph_read_lock.lock();
-
-    boost::r_c_shortest_paths(
-        g, get(&VertexProperty::index, g), get(&EdgeProperty::index, g),
-        source, destination, optimal_solutions, pareto_optimal_paths,
-        Traversal(0, t_start), TimeConstraint(t_max), TraversalDominance(),
-        allocator<boost::r_c_shortest_paths_label<Graph, Traversal> >(),
-        boost::default_r_c_shortest_paths_visitor()
-    );
-    
-    long departure = P_L_INF, expected_by = P_L_INF;
-
-    for (auto const& solution: optimal_solutions) {
-        Cost current{0, t_start};
-        Vertex target = destination;
-        Vertex source;
-        EdgeProperty eprop;
-
-
-        for (auto const& edge: reverse(solution)) {
-            source = boost::source(edge, g);
-            target = boost::target(edge, g);
-            eprop = g[edge];
-            expected_by = current.second + eprop.wait_time(current.second);
-            departure = expected_by + eprop._tap + eprop._top;
-            path.push_back(Path{g[source].code, g[edge].code, g[target].code, current.second, expected_by, departure, current.first});
-            current = eprop.weight(current, t_max);
+    const CompactGraph& compact = view.compact();
+    vector<vector<Path> > paths;
+
+    for (uint32_t label: run_labels(compact, compact.landmarks(), source, destination, t_start, t_max, limit, tolerance, arena, bags, exact)) {
+        if (arena.parent[label] == NO_LABEL) {
+            paths.push_back(vector<Path>{Path{view.vertex_code(destination), "", "", t_start, P_L_INF, P_L_INF, 0}});
+            continue;
         }
-        path.push_back(Path{g[target].code, "", "", current.second, P_L_INF, P_L_INF, current.first});
-        break;
+        paths.push_back(trace(view, arena, label, t_start, t_max));
     }
-
-    return path;
+    return paths;
 }
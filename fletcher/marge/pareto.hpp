@@ -1,116 +1,196 @@
 /** @file pareto.hpp
  * @brief Defines a multi objective path solver.
- * @details Defines a graph iterator to find a path from a source to destination while optimizing on a singular value without additional constraints on other parameters.
+ * @details Defines a label setting search finding the paths from a source to destination which are not dominated on both cost and time
+ * of arrival, i.e. no other path arrives as early for as little.
  */
 #ifndef PARETO_HPP_DEFINED
 #define PARETO_HPP_DEFINED
 
-#include "graph.hpp"
+#include <cstdint>
+#include <vector>
+
+#include "compact.hpp"
+#include "landmarks.hpp"
+#include "solver.hpp"
+
+/**
+ * @brief Label marking the absence of a label, i.e. the parent of the label at source or the end of a bag
+ */
+const uint32_t NO_LABEL = numeric_limits<uint32_t>::max();
 
 /**
- * @brief Structure to hold cost of traversal to a Vertex
+ * @brief Labels of a search held as parallel arrays, each label being a traversal to a vertex extending its parent label by an edge
+ * @details Arrays are cleared but not released between searches, hence an arena reused by a thread stops allocating once it has grown
+ * to the largest search of that thread.
  */
-struct Traversal {
+struct LabelArena {
     /**
-     * @brief Cost of traversal
+     * @brief Cost of each label
      */
-    double cost;
+    vector<double> cost;
 
     /**
-     * @brief Time of traversal
+     * @brief Time of arrival of each label
      */
-    long time;
+    vector<long> time;
 
     /**
-     * @brief Default constucts a Traversal
-     * @param[in] : Optional cost of traversal. Defaults to 0
-     * @param[in] : Optional time of traversal. Defaults to 0
+     * @brief Parent of each label, NO_LABEL for the label at source
      */
-    Traversal(double = 0, long = 0);
+    vector<uint32_t> parent;
 
     /**
-     * @brief Equality constructor to construct a traversal object from another
-     * @param[in] : Constant reference to the traversal object being copied.
+     * @brief Next label settled earlier at the same vertex, NO_LABEL for the first
      */
-    Traversal& operator = (const Traversal&);
+    vector<uint32_t> next;
+
+    /**
+     * @brief Edge traversed from the vertex of the parent label to reach each label
+     */
+    vector<CompactEdgeDescriptor> edge;
+
+    /**
+     * @brief Removes all labels, retaining their storage
+     */
+    void clear();
+
+    /**
+     * @brief Appends a label
+     * @param[in] : Cost of label
+     * @param[in] : Time of arrival of label
+     * @param[in] : Parent label
+     * @param[in] : Edge traversed from the vertex of parent label
+     * @return Index of label
+     */
+    uint32_t push(double, long, uint32_t, CompactEdgeDescriptor);
 };
 
 /**
- * @brief Equality operator to compare if two Traversal objects are equal
- * @param[in] : LHS Argument to compare
- * @param[in] : RHS Argument to compare
- * @return True if LHS == RHS else False
+ * @brief Labels settled per vertex, held as parallel arrays by vertex
+ * @details Labels are settled in increasing order of cost, hence those settled at a vertex arrive strictly earlier one after another. A
+ * label is dominated at a vertex iff it arrives no earlier than the label settled there last, which is all a bag needs to hold besides
+ * the labels chained through LabelArena::next. Only vertices touched by a search are reset before the next.
  */
-bool operator == (const Traversal&, const Traversal&);
+struct LabelBags {
+    /**
+     * @brief Label settled last per vertex, NO_LABEL if none
+     */
+    vector<uint32_t> head;
 
-/**
- * @brief Comparison operator to compare if one Traversal is less than another
- * @param[in] : LHS Argument to compare
- * @param[in] : RHS Argument to compare
- * @return True if LHS < RHS else False
- */
-bool operator < (const Traversal&, const Traversal&);
+    /**
+     * @brief Time of arrival of the label settled last per vertex, P_L_INF if none
+     */
+    vector<long> time;
+
+    /**
+     * @brief Number of labels settled per vertex
+     */
+    vector<uint32_t> count;
+
+    /**
+     * @brief Vertices with a label settled since the last reset
+     */
+    vector<uint32_t> touched;
+
+    /**
+     * @brief Empties the bags of all vertices
+     * @param[in] : Number of vertices of the graph searched next
+     */
+    void reset(size_t);
+
+    /**
+     * @brief Checks if a label is dominated by the labels settled at a vertex
+     * @param[in] : Vertex
+     * @param[in] : Time of arrival of a label no cheaper than those settled at vertex
+     * @return True if the label arrives no earlier than the label settled last
+     */
+    bool dominated(uint32_t, long) const;
+
+    /**
+     * @brief Checks if a label is dominated by a label settled at a vertex without tolerance
+     * @details Walks the labels settled at vertex from the last while they arrive no later than the label, hence only as far as needed.
+     * @param[in] : Vertex
+     * @param[in] : Cost of label
+     * @param[in] : Time of arrival of label
+     * @param[in] : Arena holding the labels settled
+     * @return True if some label settled at vertex is no costlier and arrives no later
+     */
+    bool dominated(uint32_t, double, long, const LabelArena&) const;
+
+    /**
+     * @brief Settles a label at a vertex
+     * @param[in] : Vertex
+     * @param[in] : Label, not dominated at vertex
+     * @param[in,out] : Arena holding the label
+     */
+    void settle(uint32_t, uint32_t, LabelArena&);
+};
 
 /**
- * @brief Structure to enfore constraints on time parameter
+ * @brief Implements Solver as a multi criteria path optimization
+ * @details Labels are settled in increasing order of cost plus the lower bound on the cost to destination, ties broken likewise by time,
+ * as a goal directed multi criteria dijkstra. Labels unable to reach destination within the time limit or dominated by a solution already
+ * found are dropped. Edge costs are assumed non negative.
+ *
+ * A tolerance relaxes dominance. Costs within the tolerance of one another are keyed alike, hence settled in order of time, and a label
+ * arriving within the time tolerance of one settled is dropped. Budgets stop settling labels at a vertex, or creating labels at all, once
+ * exhausted. Either may drop a path which would otherwise have been found, in which case the paths found are reported as not exact. As
+ * arrival times of time-discrete edges are steps, a path found within tolerance may arrive later than its tolerance suggests.
  */
-class TimeConstraint {
+class Pareto : public Solver {
     private:
         /**
-         * @brief The maximum time at which all vertices in the recommended solution(s) should be reached
-         */
-        long t_max;
-
-    public:
-        /**
-         * @brief Default constructs a TimeConstraint
-         */
-        TimeConstraint();
-
-        /**
-         * @brief Constructs a TimeConstraint
-         * @param[in] : The maximum time by which all vertices in recommended solution(s) should be reached
+         * @brief Settles labels from source until the cheapest solutions at destination are settled
+         * @param[in] : Compact image of the graph to traverse, disabled edges being skipped
+         * @param[in] : Lower bounds between vertices of the image
+         * @param[in] : Source vertex
+         * @param[in] : Destination vertex
+         * @param[in] : Time of arrival at source vertex
+         * @param[in] : Time limit by which destination vertex needs to be arrived at
+         * @param[in] : Maximum number of solutions
+         * @param[in] : Bounds on the effort of the search
+         * @param[in,out] : Arena to hold labels in
+         * @param[in,out] : Bags of labels per vertex
+         * @param[out] : Flag to indicate no label was dropped for being within tolerance or over budget
+         * @return Labels at destination in increasing order of cost and decreasing order of time
          */
-        TimeConstraint(long = 0);
+        vector<uint32_t> run_labels(const CompactGraph&, const Landmarks&, Vertex, Vertex, long, long, size_t, const Tolerance&, LabelArena&, LabelBags&, bool&) const;
 
         /**
-         * @brief Function operator to construct a Traversal given an existing Traversal and an edge to be traversed
-         * @param[in] : Graph being traversed
-         * @param[in,out] : Reference to new Traversal
-         * @param[in,out] : Reference to existing Traversal
-         * @param[in] : Edge being Traversed
-         * @return True if edge can be traversed without violating constraints else False
+         * @brief Traces the path to a label at destination
+         * @param[in] : Read only view of the graph traversed
+         * @param[in] : Arena holding the labels
+         * @param[in] : Label at destination
+         * @param[in] : Time of arrival at source vertex
+         * @param[in] : Time limit by which destination vertex needs to be arrived at
+         * @return Path to the label
          */
-        inline bool operator () (const Graph&, Traversal&, const Traversal&, Edge) const;
-};
+        vector<Path> trace(const GraphView&, const LabelArena&, uint32_t, long, long) const;
 
-/**
- * @brief Structure to identify a dominating Traversal
- */
-class TraversalDominance {
     public:
         /**
-         * @brief Function operator to identify dominating Traversal
-         * @param[in] : Reference to primary Traversal
-         * @param[in] : Reference to seconday Traversal
-         * @return True if primary dominates secondary else False
+         * @brief Implementation of path finder declared in Solver
+         * @details Finds the cheapest of the non dominated paths, ties broken by time of arrival
+         * @param[in] : Read only view of the graph to traverse
+         * @param[in] : Name of source vertex
+         * @param[in] : Name of destination vertex
+         * @param[in] : Time of arrival at source vertex
+         * @param[in] : Time limit by which destination vertex needs to be arrived at
          */
-        inline bool operator () (const Traversal&, const Traversal&) const;
-};
+        vector<Path> find_path(const GraphView&, string_view, string_view, long, long) const;
 
-/**
- * @brief Extends BaseGraph to implement a multi criteria path optimization
- */
-class Pareto : public BaseGraph {
-    public:
         /**
-         * @brief Implementation of path finder declared in BaseGraph
+         * @brief Implementation of the non dominated path finder declared in Solver
+         * @param[in] : Read only view of the graph to traverse
          * @param[in] : Name of source vertex
          * @param[in] : Name of destination vertex
          * @param[in] : Time of arrival at source vertex
          * @param[in] : Time limit by which destination vertex needs to be arrived at
+         * @param[in] : Maximum number of paths
+         * @param[in] : Bounds on the effort of the search
+         * @param[out] : Flag to indicate the paths are exact
          */
-        vector<Path> find_path(string_view, string_view, long, long);
+        vector<vector<Path> > find_pareto(const GraphView&, string_view, string_view, long, long, size_t, const Tolerance&, bool&) const;
 };
 
 #endif
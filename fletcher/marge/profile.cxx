@@ -0,0 +1,45 @@
+#include <algorithm>
+
+#include "profile.hpp"
+
+Profile::Profile(vector<ProfileEntry> _entries, long _walk, long _t_max) : entries(move(_entries)), earliest(entries.size()), walk(_walk), t_max(_t_max) {
+    for (size_t position = entries.size(); position-- > 0;) {
+        earliest[position] = position;
+
+        if (position + 1 < entries.size()) {
+            const ProfileEntry& current = entries[position];
+            const ProfileEntry& later = entries[earliest[position + 1]];
+
+            if (later.arr < current.arr || (later.arr == current.arr && later.cost < current.cost)) {
+                earliest[position] = earliest[position + 1];
+            }
+        }
+    }
+}
+
+const vector<ProfileEntry>& Profile::journeys() const {
+    return entries;
+}
+
+long Profile::continuous() const {
+    return walk;
+}
+
+bool Profile::at(long arrival, ProfileEntry& journey) const {
+    auto found = lower_bound(entries.begin(), entries.end(), arrival, [](const ProfileEntry& entry, long time) {
+        return entry.dep < time;
+    });
+    bool reachable = (found != entries.end());
+
+    if (reachable) {
+        journey = entries[earliest[found - entries.begin()]];
+    }
+
+    if (walk >= 0 && arrival + walk <= t_max) {
+        if (!reachable || arrival + walk < journey.arr || (arrival + walk == journey.arr && journey.cost > 0)) {
+            journey = ProfileEntry{arrival, arrival + walk, 0};
+        }
+        reachable = true;
+    }
+    return reachable;
+}
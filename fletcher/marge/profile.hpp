@@ -0,0 +1,88 @@
+/** @file profile.hpp
+ * @brief Defines the profile of a pair of vertices, i.e. the time of arrival at destination as a function of time of departure from source
+ */
+#ifndef PROFILE_HPP_INCLUDED
+#define PROFILE_HPP_INCLUDED
+
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief A journey from source to destination in a profile
+ */
+struct ProfileEntry {
+    /**
+     * @brief Latest time of arrival at source to make the journey
+     */
+    long dep;
+
+    /**
+     * @brief Time of arrival at destination
+     */
+    long arr;
+
+    /**
+     * @brief Cost of the journey
+     */
+    double cost;
+};
+
+/**
+ * @brief Pareto optimal journeys from a source to a destination over a window of departures
+ * @details No journey departs later, arrives no later and costs no more than another one. Journeys departing after the window are
+ * represented only by the one arriving earliest, hence a departure anywhere in the window is answered exactly. A journey via continuous
+ * edges alone departs whenever source is arrived at, and is kept apart from journeys bound to a time of departure.
+ */
+class Profile {
+    private:
+        /**
+         * @brief Journeys sorted by time of departure
+         */
+        vector<ProfileEntry> entries;
+
+        /**
+         * @brief Position of the journey arriving earliest, and cheapest amongst those, of all journeys departing at or after each journey
+         */
+        vector<size_t> earliest;
+
+        /**
+         * @brief Duration of the journey via continuous edges alone, negative if there is none
+         */
+        long walk;
+
+        /**
+         * @brief Maximum time by which destination must be reached
+         */
+        long t_max;
+
+    public:
+        /**
+         * @brief Constructs a profile
+         * @param[in] : Pareto optimal journeys, sorted by time of departure
+         * @param[in] : Duration of the journey via continuous edges alone, negative if there is none
+         * @param[in] : Maximum time by which destination must be reached
+         */
+        Profile(vector<ProfileEntry>, long, long);
+
+        /**
+         * @brief Fetch all journeys sorted by time of departure
+         */
+        const vector<ProfileEntry>& journeys() const;
+
+        /**
+         * @brief Fetch the duration of the journey via continuous edges alone
+         * @return Duration, negative if there is no such journey
+         */
+        long continuous() const;
+
+        /**
+         * @brief Finds the journey arriving earliest, and cheapest amongst those, on arrival at source at a time
+         * @param[in] : Time of arrival at source
+         * @param[out] : Journey found
+         * @return True if destination can be reached, false otherwise
+         */
+        bool at(long, ProfileEntry&) const;
+};
+
+#endif
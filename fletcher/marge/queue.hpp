@@ -0,0 +1,172 @@
+/** @file queue.hpp
+ * @brief Defines monotone priority queues over integral keys, as used by dijkstra once every edge traverses in non negative time and cost
+ * @details A radix heap holds an entry in the bucket of the most significant bit in which its key differs from the key popped last. Keys
+ * pushed are no less than the key popped last, hence an entry only ever moves to a lower bucket and is moved at most once per bit of its
+ * key, each push and pop taking constant amortized time.
+ */
+#ifndef QUEUE_HPP_INCLUDED
+#define QUEUE_HPP_INCLUDED
+
+#include <cstdint>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+/**
+ * @brief Key of a queue ordered on time alone, as seconds past the time of arrival at source
+ */
+typedef uint64_t TimeKey;
+
+/**
+ * @brief Key of a queue ordered on cost then time, as the bits of a non negative cost and seconds past the time of arrival at source
+ * @details The bits of non negative doubles order as the doubles do, hence costs are bucketed on their bits on the first level and tied
+ * costs on time on the second, without quantizing either.
+ */
+typedef pair<uint64_t, uint64_t> CostTimeKey;
+
+/**
+ * @brief Builds the key of a time
+ * @param[in] : Time of arrival at source vertex
+ * @param[in] : Time, no earlier than arrival at source
+ */
+inline TimeKey time_key(long base, long time) {
+    return uint64_t(time - base);
+}
+
+/**
+ * @brief Builds the key of a cost and time
+ * @param[in] : Time of arrival at source vertex
+ * @param[in] : Non negative cost
+ * @param[in] : Time, no earlier than arrival at source
+ */
+inline CostTimeKey cost_time_key(long base, double cost, long time) {
+    uint64_t bits;
+
+    // Adding zero turns a negative zero into a positive one, whose bits order first
+    cost += 0.0;
+    memcpy(&bits, &cost, sizeof(bits));
+    return CostTimeKey{bits, uint64_t(time - base)};
+}
+
+/**
+ * @brief Fetch the bucket of a key relative to the key popped last, i.e. one past its most significant differing bit or 0 if equal
+ */
+inline size_t radix_bucket(TimeKey last, TimeKey key) {
+    return (last == key) ? 0 : 64 - __builtin_clzll(last ^ key);
+}
+
+/**
+ * @brief Fetch the bucket of a key relative to the key popped last, cost bits ranking above time bits
+ */
+inline size_t radix_bucket(const CostTimeKey& last, const CostTimeKey& key) {
+    return (last.first == key.first) ? radix_bucket(last.second, key.second) : 64 + radix_bucket(last.first, key.first);
+}
+
+/**
+ * @brief Monotone priority queue of values by key
+ * @details Buckets are cleared but not released, hence a heap reused across searches stops allocating once grown.
+ */
+template <typename K> class RadixHeap {
+    private:
+        /**
+         * @brief Number of buckets, one per bit of the key and one for keys equal to the key popped last
+         */
+        static const size_t BUCKETS = 8 * sizeof(K) + 1;
+
+        /**
+         * @brief Entries by bucket
+         */
+        vector<pair<K, uint32_t> > buckets[BUCKETS];
+
+        /**
+         * @brief Key popped last
+         */
+        K last;
+
+        /**
+         * @brief Number of entries
+         */
+        size_t count;
+
+    public:
+        /**
+         * @brief Constructs an empty heap, with keys starting at 0
+         */
+        RadixHeap();
+
+        /**
+         * @brief Empties the heap, with keys starting at 0
+         */
+        void clear();
+
+        /**
+         * @brief Checks if the heap is empty
+         */
+        bool empty() const;
+
+        /**
+         * @brief Inserts a value
+         * @param[in] : Key, expected no less than the key popped last. A lesser key, as from rounding a goal directed cost, is popped
+         * as if equal to the key popped last
+         * @param[in] : Value
+         */
+        void push(const K&, uint32_t);
+
+        /**
+         * @brief Removes a value with the least key
+         * @return Least key and its value
+         */
+        pair<K, uint32_t> pop();
+};
+
+template <typename K> RadixHeap<K>::RadixHeap() : last(), count(0) {}
+
+template <typename K> void RadixHeap<K>::clear() {
+    for (auto& bucket: buckets) {
+        bucket.clear();
+    }
+    last = K();
+    count = 0;
+}
+
+template <typename K> bool RadixHeap<K>::empty() const {
+    return count == 0;
+}
+
+template <typename K> void RadixHeap<K>::push(const K& key, uint32_t value) {
+    buckets[(key < last) ? 0 : radix_bucket(last, key)].emplace_back((key < last) ? last : key, value);
+    count++;
+}
+
+template <typename K> pair<K, uint32_t> RadixHeap<K>::pop() {
+    if (buckets[0].empty()) {
+        size_t index = 1;
+
+        while (buckets[index].empty()) {
+            index++;
+        }
+
+        // Entries of the lowest non empty bucket differ from the least of them below the bit of the bucket, hence all move lower
+        last = buckets[index].front().first;
+
+        for (auto const& entry: buckets[index]) {
+            if (entry.first < last) {
+                last = entry.first;
+            }
+        }
+
+        for (auto const& entry: buckets[index]) {
+            buckets[radix_bucket(last, entry.first)].push_back(entry);
+        }
+        buckets[index].clear();
+    }
+
+    auto entry = buckets[0].back();
+    buckets[0].pop_back();
+    count--;
+    return entry;
+}
+
+#endif
@@ -0,0 +1,454 @@
+#include <algorithm>
+
+#include "scan.hpp"
+
+/**
+ * @brief Workspace of the scans of a thread, reused across scans
+ */
+static thread_local Workspace workspace;
+
+/**
+ * @brief Finds the vertices reached from a vertex through enabled continuous edges alone
+ * @param[in] : Compact image of the graph
+ * @param[in] : Vertex to start from
+ * @param[out] : Vertices reached, starting with the vertex itself, paired with the least time to reach each
+ * @param[in,out] : Scratch space for positions in reached vertices yet to be followed
+ */
+static void follow_transfers(const CompactGraph& compact, uint32_t vertex, vector<pair<uint32_t, long> >& reachable, vector<size_t>& pending) {
+    const Timetable& table = compact.timetable();
+
+    reachable.assign(1, make_pair(vertex, 0L));
+    pending.assign(1, 0);
+
+    while (!pending.empty()) {
+        auto current = reachable[pending.back()];
+        pending.pop_back();
+
+        for (auto transfers = table.transfers_from(current.first); transfers.first != transfers.second; transfers.first++) {
+            if (!compact.enabled(transfers.first->edge)) {
+                continue;
+            }
+
+            long time = current.second + transfers.first->dur;
+            auto found = find_if(reachable.begin(), reachable.end(), [&transfers](const pair<uint32_t, long>& reached) {
+                return reached.first == transfers.first->dst;
+            });
+
+            if (found == reachable.end()) {
+                pending.push_back(reachable.size());
+                reachable.push_back(make_pair(transfers.first->dst, time));
+            }
+            else if (time < found->second) {
+                found->second = time;
+                pending.push_back(found - reachable.begin());
+            }
+        }
+    }
+}
+
+void ConnectionScan::run_scan(const CompactGraph& compact, Vertex src, const vector<Vertex>& dsts, long t_start, long t_max, Workspace& workspace, bool nearest) const {
+    const Timetable& table = compact.timetable();
+    const vector<Connection>& departures = table.departures();
+
+    workspace.reset(boost::num_vertices(compact.graph()));
+    workspace.reach(src, make_pair(0, t_start), CompactEdgeDescriptor());
+
+    // Latest time any vertex has been reached at, and latest time any destination vertex has been reached at, or earliest when
+    // searching for the nearest destination
+    long latest = t_start;
+    long bound = P_L_INF;
+    vector<uint32_t> reached;
+
+    auto update_bound = [&]() {
+        bound = nearest ? P_L_INF : t_start;
+
+        for (Vertex dst: dsts) {
+            bound = nearest ? min(bound, workspace.distance(dst).second) : max(bound, workspace.distance(dst).second);
+        }
+    };
+
+    // Continuous edges are traversed as soon as their source is reached, following chains of them until no vertex is reached earlier
+    auto transfer = [&](uint32_t vertex) {
+        reached.push_back(vertex);
+
+        while (!reached.empty()) {
+            uint32_t current = reached.back();
+            reached.pop_back();
+
+            for (auto transfers = table.transfers_from(current); transfers.first != transfers.second; transfers.first++) {
+                const Transfer& edge = *transfers.first;
+
+                if (!compact.enabled(edge.edge)) {
+                    continue;
+                }
+
+                Cost reached_at = workspace.distance(current);
+                long arrival = reached_at.second + edge.dur;
+
+                if (arrival < workspace.distance(edge.dst).second) {
+                    workspace.reach(edge.dst, make_pair(reached_at.first, arrival), CompactEdgeDescriptor(current, edge.edge));
+                    latest = max(latest, arrival);
+                    reached.push_back(edge.dst);
+                }
+            }
+        }
+    };
+
+    transfer(src);
+    update_bound();
+
+    long day = t_start / TIME_DURINAL;
+
+    for (bool done = false; !done; day++) {
+        long midnight = day * TIME_DURINAL;
+
+        if (midnight > t_max) {
+            break;
+        }
+
+        bool whole = midnight >= t_start;
+        bool improved = false;
+        size_t position = whole ? 0 : table.first_departure(t_start - midnight);
+
+        // Connections of a day are contiguous and sorted by departure, hence are scanned in a single linear pass
+        for (; position < departures.size(); position++) {
+            const Connection& connection = departures[position];
+            long departure = midnight + connection.dep;
+
+            if (departure > t_max || departure >= bound) {
+                done = true;
+                break;
+            }
+
+            if (!compact.enabled(connection.edge)) {
+                continue;
+            }
+
+            Cost departed_from = workspace.distance(connection.src);
+
+            if (departed_from.second > departure) {
+                continue;
+            }
+
+            long arrival = departure + connection.dur;
+
+            if (arrival > t_max || arrival >= workspace.distance(connection.dst).second) {
+                continue;
+            }
+
+            workspace.reach(connection.dst, make_pair(departed_from.first + connection.cost, arrival), CompactEdgeDescriptor(connection.src, connection.edge));
+            latest = max(latest, arrival);
+            improved = true;
+            transfer(connection.dst);
+            update_bound();
+        }
+
+        // Every vertex reached was reached by midnight, hence each connection of the next day repeats one which already failed
+        if (whole && !improved && latest <= midnight) {
+            break;
+        }
+    }
+}
+
+vector<Path> ConnectionScan::find_path(const GraphView& view, string_view src, string_view dst, long t_start, long t_max) const {
+    return find_paths(view, src, t_start, vector<pair<string_view, long> >{make_pair(dst, t_max)}).front();
+}
+
+vector<vector<Path> > ConnectionScan::find_paths(const GraphView& view, string_view src, long t_start, const vector<pair<string_view, long> >& targets) const {
+    Vertex source;
+
+    if (!view.vertex(src, source)) {
+        throw invalid_argument("No source <> found");
+    }
+
+    vector<Vertex> destinations(targets.size());
+    map<long, vector<size_t> > limits;
+
+    for (size_t index = 0; index < targets.size(); index++) {
+        if (!view.vertex(targets[index].first, destinations[index])) {
+            throw invalid_argument("No destination<> found");
+        }
+        limits[targets[index].second].push_back(index);
+    }
+
+    const CompactGraph& compact = view.compact();
+    vector<vector<Path> > paths(targets.size());
+
+    for (auto const& limit: limits) {
+        vector<Vertex> dsts;
+
+        for (size_t index: limit.second) {
+            dsts.push_back(destinations[index]);
+        }
+
+        run_scan(compact, source, dsts, t_start, limit.first, workspace);
+
+        for (size_t index: limit.second) {
+            paths[index] = trace(view, source, destinations[index], workspace);
+        }
+    }
+    return paths;
+}
+
+vector<Path> ConnectionScan::find_nearest(const GraphView& view, string_view src, long t_start, const vector<pair<string_view, long> >& targets, size_t& nearest) const {
+    Vertex source;
+
+    if (!view.vertex(src, source)) {
+        throw invalid_argument("No source <> found");
+    }
+
+    vector<Vertex> destinations(targets.size());
+    map<long, vector<size_t> > limits;
+
+    for (size_t index = 0; index < targets.size(); index++) {
+        if (!view.vertex(targets[index].first, destinations[index])) {
+            throw invalid_argument("No destination<> found");
+        }
+        limits[targets[index].second].push_back(index);
+    }
+
+    const CompactGraph& compact = view.compact();
+    vector<Path> path;
+    nearest = targets.size();
+
+    for (auto const& limit: limits) {
+        vector<Vertex> dsts;
+
+        for (size_t index: limit.second) {
+            dsts.push_back(destinations[index]);
+        }
+
+        run_scan(compact, source, dsts, t_start, limit.first, workspace, true);
+
+        // Destinations reached later than the nearest may not be settled, but are never picked over it
+        for (size_t index: limit.second) {
+            Cost reached = workspace.distance(destinations[index]);
+
+            if (reached.second == P_L_INF) {
+                continue;
+            }
+
+            if (nearest == targets.size() || make_pair(reached.second, reached.first) < make_pair(path.back().arr, path.back().cost) ||
+                (make_pair(reached.second, reached.first) == make_pair(path.back().arr, path.back().cost) && index < nearest)) {
+                nearest = index;
+                path = trace(view, source, destinations[index], workspace);
+            }
+        }
+    }
+    return path;
+}
+
+vector<Path> ConnectionScan::trace(const GraphView& view, Vertex source, Vertex destination, const Workspace& workspace) const {
+    const Compact& g = view.compact().graph();
+    vector<Path> path;
+    Cost arrived = workspace.distance(destination);
+
+    if (arrived.second == P_L_INF) {
+        return path;
+    }
+
+    Vertex current = destination;
+    path.push_back(Path{view.vertex_code(current), "", "", arrived.second, P_L_INF, P_L_INF, arrived.first});
+
+    while (current != source) {
+        CompactEdgeDescriptor inbound = workspace.predecessor(current);
+        const EdgeProperty& eprop = g[inbound];
+        current = boost::source(inbound, g);
+
+        auto distance = workspace.distance(current);
+        long expected_by = departure_after(eprop, distance.second);
+        long departure = expected_by + eprop._tap + eprop._top;
+        path.push_back(Path{view.vertex_code(current), view.edge_code(eprop), view.vertex_code(boost::target(inbound, g)), distance.second, expected_by, departure, distance.first});
+    }
+
+    std::reverse(path.begin(), path.end());
+    return path;
+}
+
+Profile ConnectionScan::run_profile(const CompactGraph& compact, Vertex source, Vertex destination, long beg, long end, long t_max) const {
+    const Timetable& table = compact.timetable();
+    const vector<Connection>& departures = table.departures();
+    size_t nvertices = boost::num_vertices(compact.graph());
+
+    // Journeys to destination from each vertex in decreasing order of departure, and the arrival and cost of those not dominated
+    vector<vector<ProfileEntry> > bags(nvertices);
+    vector<vector<pair<long, double> > > fronts(nvertices);
+
+    vector<pair<uint32_t, long> > reachable;
+    vector<size_t> pending;
+    vector<pair<long, double> > options;
+
+    // Arrival and cost of the journeys to destination on arrival at a vertex which are not dominated by one another
+    auto continuations = [&](uint32_t vertex, long arrival) {
+        options.clear();
+        follow_transfers(compact, vertex, reachable, pending);
+
+        for (auto const& reached: reachable) {
+            long time = arrival + reached.second;
+
+            if (reached.first == destination) {
+                if (time <= t_max) {
+                    options.push_back(make_pair(time, 0.0));
+                }
+                continue;
+            }
+
+            for (auto const& entry: bags[reached.first]) {
+                if (entry.dep < time) {
+                    break;
+                }
+                options.push_back(make_pair(entry.arr, entry.cost));
+            }
+        }
+
+        sort(options.begin(), options.end());
+        size_t kept = 0;
+
+        for (auto const& option: options) {
+            if (kept == 0 || option.second < options[kept - 1].second) {
+                options[kept++] = option;
+            }
+        }
+        options.resize(kept);
+    };
+
+    for (long day = t_max / TIME_DURINAL; day >= beg / TIME_DURINAL; day--) {
+        long midnight = day * TIME_DURINAL;
+
+        for (size_t position = departures.size(); position-- > 0;) {
+            const Connection& connection = departures[position];
+            long departure = midnight + connection.dep;
+            long arrival = departure + connection.dur;
+
+            if (departure < beg) {
+                break;
+            }
+
+            if (arrival > t_max || !compact.enabled(connection.edge)) {
+                continue;
+            }
+
+            continuations(connection.dst, arrival);
+
+            vector<pair<long, double> >& front = fronts[connection.src];
+
+            for (auto const& option: options) {
+                double cost = option.second + connection.cost;
+                bool dominated = any_of(front.begin(), front.end(), [&option, cost](const pair<long, double>& other) {
+                    return other.first <= option.first && other.second <= cost;
+                });
+
+                if (dominated) {
+                    continue;
+                }
+
+                front.erase(remove_if(front.begin(), front.end(), [&option, cost](const pair<long, double>& other) {
+                    return other.first >= option.first && other.second >= cost;
+                }), front.end());
+                front.push_back(make_pair(option.first, cost));
+                bags[connection.src].push_back(ProfileEntry{departure, option.first, cost});
+            }
+        }
+    }
+
+    // Journeys from source, either directly or after transfers, are filtered once more as transfers shift their departure
+    vector<ProfileEntry> candidates;
+    long walk = -1;
+    follow_transfers(compact, source, reachable, pending);
+
+    for (auto const& reached: reachable) {
+        if (reached.first == destination) {
+            walk = reached.second;
+            continue;
+        }
+
+        for (auto const& entry: bags[reached.first]) {
+            if (entry.dep - reached.second >= beg) {
+                candidates.push_back(ProfileEntry{entry.dep - reached.second, entry.arr, entry.cost});
+            }
+        }
+    }
+
+    sort(candidates.begin(), candidates.end(), [](const ProfileEntry& first, const ProfileEntry& second) {
+        return make_tuple(-first.dep, first.arr, first.cost) < make_tuple(-second.dep, second.arr, second.cost);
+    });
+
+    vector<ProfileEntry> journeys;
+    vector<pair<long, double> > front;
+    const ProfileEntry* after = nullptr;
+
+    for (auto const& candidate: candidates) {
+        bool dominated = any_of(front.begin(), front.end(), [&candidate](const pair<long, double>& other) {
+            return other.first <= candidate.arr && other.second <= candidate.cost;
+        });
+
+        // Journeys arriving no earlier, at no less cost, than via continuous edges alone from the same departure are dominated
+        if (dominated || (walk >= 0 && candidate.arr >= candidate.dep + walk && candidate.cost >= 0)) {
+            continue;
+        }
+        front.push_back(make_pair(candidate.arr, candidate.cost));
+
+        // Of journeys departing after the window, only the one arriving earliest answers a departure in the window
+        if (candidate.dep > end) {
+            if (after == nullptr || candidate.arr < after->arr || (candidate.arr == after->arr && candidate.cost < after->cost)) {
+                after = &candidate;
+            }
+            continue;
+        }
+        journeys.push_back(candidate);
+    }
+
+    if (after != nullptr) {
+        journeys.insert(journeys.begin(), *after);
+    }
+
+    std::reverse(journeys.begin(), journeys.end());
+    return Profile(move(journeys), walk, t_max);
+}
+
+shared_ptr<const Profile> ConnectionScan::find_profile(const GraphView& view, string_view src, string_view dst, long beg, long end, long t_max) const {
+    Vertex source, destination;
+
+    if (!view.vertex(src, source)) {
+        throw invalid_argument("No source <> found");
+    }
+
+    if (!view.vertex(dst, destination)) {
+        throw invalid_argument("No destination<> found");
+    }
+
+    if (end < beg) {
+        throw invalid_argument("Window of departures ends before it begins");
+    }
+
+    if (t_max - beg > MAX_PROFILE_SPAN) {
+        throw invalid_argument("Time limit is more than " + to_string(MAX_PROFILE_SPAN / TIME_DURINAL) + " days after the window begins");
+    }
+
+    const CompactGraph& compact = view.compact();
+    ProfileKey key{compact.version(), src.to_string(), dst.to_string(), beg, end, t_max};
+
+    {
+        lock_guard<mutex> profiles_lock(profiles_mutex);
+        auto found = profiles.find(key);
+
+        if (found != profiles.end()) {
+            return found->second;
+        }
+    }
+
+    auto profile = make_shared<const Profile>(run_profile(compact, source, destination, beg, end, t_max));
+
+    lock_guard<mutex> profiles_lock(profiles_mutex);
+
+    // Keys order by version first, hence profiles of earlier versions, which are never looked up again, lead the cache
+    while (!profiles.empty() && get<0>(profiles.begin()->first) < compact.version()) {
+        profiles.erase(profiles.begin());
+    }
+
+    if (profiles.size() >= MAX_CACHED_PROFILES) {
+        profiles.erase(profiles.begin());
+    }
+    profiles.emplace(key, profile);
+    return profile;
+}
@@ -0,0 +1,139 @@
+/** @file scan.hpp
+ * @brief Defines an earliest arrival path solver for daily time-discrete schedules.
+ * @details Defines a solver implementing the Connection Scan Algorithm, which scans connections in order of departure instead of
+ * settling vertices through a priority queue.
+ */
+#ifndef SCAN_HPP_INCLUDED
+#define SCAN_HPP_INCLUDED
+
+#include <map>
+#include <mutex>
+#include <tuple>
+
+#include "compact.hpp"
+#include "solver.hpp"
+#include "timetable.hpp"
+#include "workspace.hpp"
+
+/**
+ * @brief Maximum time between the earliest arrival at source and the time limit of a profile
+ */
+const long MAX_PROFILE_SPAN = 14 * TIME_DURINAL;
+
+/**
+ * @brief Maximum number of profiles cached by a solver. A cached profile is dropped to make room once reached
+ */
+const size_t MAX_CACHED_PROFILES = 1024;
+
+/**
+ * @brief Key of a cached profile, as the version of the graph, source, destination, window of departures and time limit
+ */
+typedef tuple<uint64_t, string, string, long, long, long> ProfileKey;
+
+/**
+ * @brief Implements Solver as an earliest arrival search scanning connections in order of departure
+ * @details Edges are traversed under the same rules as EdgeProperty::weight, except that departures are taken modulo TIME_DURINAL,
+ * hence an edge is never departed via before the time of arrival at its source. Continuous edges are traversed as transfers as soon as
+ * their source is reached. Cost is carried along the path of earliest arrival but is not optimized on.
+ *
+ * Profiles are found by scanning connections in reverse order of departure once, and are cached per version of the graph.
+ */
+class ConnectionScan : public Solver {
+    private:
+        /**
+         * @brief Profiles found, by the version of the graph and the query they were found for
+         */
+        mutable map<ProfileKey, shared_ptr<const Profile> > profiles;
+
+        /**
+         * @brief Mutex serializing access to cached profiles
+         */
+        mutable mutex profiles_mutex;
+
+        /**
+         * @brief Actual implementation of the path finding algorithm as a connection scan
+         * @details Connections are scanned day by day from the time of arrival at source, stopping once every destination vertex is
+         * reached before the departure being scanned, once departures pass the time limit or once a whole day is scanned without any
+         * vertex being reached earlier. Searching for the nearest destination stops once any destination vertex is reached before the
+         * departure being scanned instead, other destinations being left unsettled.
+         * @param[in] :         Compact image of the graph to traverse
+         * @param[in] :         Source vertex
+         * @param[in] :         Destination vertices
+         * @param[in] :         Time of arrival at source vertex
+         * @param[in] :         Maximum time by which the destination vertex must be reached
+         * @param[in,out] :     Workspace to record the cost and time of earliest arrival at vertices and the edges they are arrived at
+         * via in, reset by the scan
+         * @param[in] :         Flag to search for the nearest destination only
+         */
+        void run_scan(const CompactGraph&, Vertex, const vector<Vertex>&, long, long, Workspace&, bool = false) const;
+
+        /**
+         * @brief Traces the path to a destination vertex from the edges recorded by run_scan
+         * @param[in] : View of the graph traversed
+         * @param[in] : Source vertex
+         * @param[in] : Destination vertex
+         * @param[in] : Workspace holding the cost and time of earliest arrival at vertices and the edges they are arrived at via
+         * @return Path from source to destination, empty if destination is unreachable. Codes are views into the graph
+         */
+        vector<Path> trace(const GraphView&, Vertex, Vertex, const Workspace&) const;
+
+        /**
+         * @brief Actual implementation of the profile search as a connection scan in reverse order of departure
+         * @details Each vertex keeps the journeys to destination departing from it, in decreasing order of departure, which are not
+         * dominated by a journey departing later. A connection extends every journey of its destination vertex, or of a vertex reached
+         * from it by transfers, departing after its arrival.
+         * @param[in] : Compact image of the graph to traverse
+         * @param[in] : Source vertex
+         * @param[in] : Destination vertex
+         * @param[in] : Earliest time of arrival at source vertex
+         * @param[in] : Latest time of arrival at source vertex
+         * @param[in] : Maximum time by which the destination vertex must be reached
+         * @return Profile of journeys from source to destination
+         */
+        Profile run_profile(const CompactGraph&, Vertex, Vertex, long, long, long) const;
+
+    public:
+        /**
+         * @brief Implementation of path finder declared in Solver
+         * @param[in] : Read only view of the graph to traverse
+         * @param[in] : Name of source vertex
+         * @param[in] : Name of destination vertex
+         * @param[in] : Time of arrival at source vertex
+         * @param[in] : Time limit by which destination vertex needs to be arrived at
+         */
+        vector<Path> find_path(const GraphView&, string_view, string_view, long, long) const;
+
+        /**
+         * @brief Implementation of the multi destination path finder declared in Solver
+         * @details Destinations sharing a time limit share a single scan.
+         * @param[in] : Read only view of the graph to traverse
+         * @param[in] : Name of source vertex
+         * @param[in] : Time of arrival at source vertex
+         * @param[in] : Names of destination vertices paired with the time limit by which each needs to be arrived at
+         */
+        vector<vector<Path> > find_paths(const GraphView&, string_view, long, const vector<pair<string_view, long> >&) const;
+
+        /**
+         * @brief Implementation of the nearest destination path finder declared in Solver
+         * @details Destinations sharing a time limit share a single scan, stopped once the first of them is reached.
+         * @param[in] : Read only view of the graph to traverse
+         * @param[in] : Name of source vertex
+         * @param[in] : Time of arrival at source vertex
+         * @param[in] : Names of destination vertices paired with the time limit by which each needs to be arrived at
+         * @param[out] : Index of the nearest destination, or the number of destinations if none is reachable
+         */
+        vector<Path> find_nearest(const GraphView&, string_view, long, const vector<pair<string_view, long> >&, size_t&) const;
+
+        /**
+         * @brief Implementation of the profile finder declared in Solver
+         * @param[in] : Read only view of the graph to traverse
+         * @param[in] : Name of source vertex
+         * @param[in] : Name of destination vertex
+         * @param[in] : Earliest time of arrival at source vertex
+         * @param[in] : Latest time of arrival at source vertex
+         * @param[in] : Time limit by which destination vertex needs to be arrived at
+         */
+        shared_ptr<const Profile> find_profile(const GraphView&, string_view, string_view, long, long, long) const;
+};
+
+#endif
@@ -0,0 +1,106 @@
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "snapshot.hpp"
+
+Snapshot::Snapshot(string_view path) {
+    int fd = open(path.to_string().c_str(), O_RDONLY);
+
+    if (fd < 0) {
+        throw system_error(errno, system_category(), "Unable to open snapshot <" + path.to_string() + ">");
+    }
+
+    struct stat st;
+
+    if (fstat(fd, &st) < 0) {
+        int error = errno;
+        close(fd);
+        throw system_error(error, system_category(), "Unable to stat snapshot <" + path.to_string() + ">");
+    }
+
+    length = st.st_size;
+
+    if (length < sizeof(SnapshotHeader)) {
+        close(fd);
+        throw runtime_error("Invalid snapshot <" + path.to_string() + ">. Truncated header");
+    }
+
+    void* mapped = mmap(nullptr, length, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (mapped == MAP_FAILED) {
+        throw system_error(errno, system_category(), "Unable to map snapshot <" + path.to_string() + ">");
+    }
+    data = static_cast<const char*>(mapped);
+
+    try {
+        const SnapshotHeader& head = header();
+
+        if (memcmp(head.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0) {
+            throw runtime_error("Invalid snapshot <" + path.to_string() + ">. Bad magic");
+        }
+
+        if (head.version != SNAPSHOT_VERSION) {
+            throw runtime_error("Unsupported snapshot version <" + to_string(head.version) + ">");
+        }
+
+        section(head.vertices, uint64_t(head.nvertices) * sizeof(SnapshotVertex));
+        section(head.offsets, (uint64_t(head.nvertices) + 1) * sizeof(uint32_t));
+        section(head.edges, uint64_t(head.nedges) * sizeof(SnapshotEdge));
+        section(head.vertex_index, uint64_t(head.nvertices) * sizeof(uint32_t));
+        section(head.edge_index, uint64_t(head.nedges) * sizeof(uint32_t));
+        section(head.pool, head.pool_length);
+    }
+    catch (...) {
+        munmap(const_cast<char*>(data), length);
+        throw;
+    }
+}
+
+Snapshot::~Snapshot() {
+    munmap(const_cast<char*>(data), length);
+}
+
+const char* Snapshot::section(uint64_t offset, uint64_t size) const {
+    if (offset > length || size > length - offset) {
+        throw runtime_error("Invalid snapshot. Section exceeds file bounds");
+    }
+    return data + offset;
+}
+
+const SnapshotHeader& Snapshot::header() const {
+    return *reinterpret_cast<const SnapshotHeader*>(data);
+}
+
+const SnapshotVertex* Snapshot::vertices() const {
+    return reinterpret_cast<const SnapshotVertex*>(data + header().vertices);
+}
+
+const uint32_t* Snapshot::offsets() const {
+    return reinterpret_cast<const uint32_t*>(data + header().offsets);
+}
+
+const SnapshotEdge* Snapshot::edges() const {
+    return reinterpret_cast<const SnapshotEdge*>(data + header().edges);
+}
+
+const uint32_t* Snapshot::vertex_index() const {
+    return reinterpret_cast<const uint32_t*>(data + header().vertex_index);
+}
+
+const uint32_t* Snapshot::edge_index() const {
+    return reinterpret_cast<const uint32_t*>(data + header().edge_index);
+}
+
+string_view Snapshot::code(uint32_t offset, uint32_t size) const {
+    if (uint64_t(offset) + size > header().pool_length) {
+        throw runtime_error("Invalid snapshot. Code exceeds pool bounds");
+    }
+    return string_view(data + header().pool + offset, size);
+}
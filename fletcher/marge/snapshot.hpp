@@ -0,0 +1,260 @@
+/** @file snapshot.hpp
+ * @brief Defines a binary, memory mappable image of the graph
+ * @details A snapshot is laid out as a header followed by fixed width sections. All integers are stored in host byte order.
+ * - Vertices (SnapshotVertex[nvertices]) in order of their index in graph
+ * - Offsets (uint32_t[nvertices + 1]) of the first outbound edge of each vertex in the edge section
+ * - Edges (SnapshotEdge[nedges]) sorted by source vertex
+ * - Vertex index (uint32_t[nvertices]) listing vertices in order of their codes
+ * - Edge index (uint32_t[nedges]) listing edges in order of their codes
+ * - Pool (char[pool_length]) holding codes of all vertices and edges
+ */
+#ifndef SNAPSHOT_HPP_INCLUDED
+#define SNAPSHOT_HPP_INCLUDED
+
+#include <cstdint>
+#include <string>
+#include <experimental/string_view>
+
+using namespace std;
+using std::experimental::string_view;
+
+/**
+ * @brief Magic bytes identifying a snapshot
+ */
+const char SNAPSHOT_MAGIC[8] = {'R', 'E', 'B', 'A', 'R', 'S', 'N', 'P'};
+
+/**
+ * @brief Version of the snapshot layout
+ */
+const uint32_t SNAPSHOT_VERSION = 1;
+
+/**
+ * @brief Header of a snapshot describing the location of each section
+ */
+struct SnapshotHeader {
+    /**
+     * @brief Magic bytes identifying the file as a snapshot
+     */
+    char magic[8];
+
+    /**
+     * @brief Version of snapshot layout
+     */
+    uint32_t version;
+
+    /**
+     * @brief Number of vertices in graph
+     */
+    uint32_t nvertices;
+
+    /**
+     * @brief Number of edges in graph, including disabled edges
+     */
+    uint32_t nedges;
+
+    /**
+     * @brief Padding to align sections
+     */
+    uint32_t reserved;
+
+    /**
+     * @brief Length of the pool of codes in bytes
+     */
+    uint64_t pool_length;
+
+    /**
+     * @brief Offset of the vertex section from start of file
+     */
+    uint64_t vertices;
+
+    /**
+     * @brief Offset of the outbound edge offsets section from start of file
+     */
+    uint64_t offsets;
+
+    /**
+     * @brief Offset of the edge section from start of file
+     */
+    uint64_t edges;
+
+    /**
+     * @brief Offset of the vertex index section from start of file
+     */
+    uint64_t vertex_index;
+
+    /**
+     * @brief Offset of the edge index section from start of file
+     */
+    uint64_t edge_index;
+
+    /**
+     * @brief Offset of the pool of codes from start of file
+     */
+    uint64_t pool;
+};
+
+/**
+ * @brief Structure representing a vertex in a snapshot
+ */
+struct SnapshotVertex {
+    /**
+     * @brief Offset of the vertex code in pool
+     */
+    uint32_t code_offset;
+
+    /**
+     * @brief Length of the vertex code
+     */
+    uint32_t code_length;
+};
+
+/**
+ * @brief Structure representing an edge in a snapshot
+ */
+struct SnapshotEdge {
+    /**
+     * @brief Index of source vertex
+     */
+    uint32_t src;
+
+    /**
+     * @brief Index of destination vertex
+     */
+    uint32_t dst;
+
+    /**
+     * @brief Offset of the edge code in pool
+     */
+    uint32_t code_offset;
+
+    /**
+     * @brief Length of the edge code
+     */
+    uint32_t code_length;
+
+    /**
+     * @brief Actual departure time at source of edge
+     */
+    int64_t dep;
+
+    /**
+     * @brief Actual duration of traversal of edge
+     */
+    int64_t dur;
+
+    /**
+     * @brief Time to process inbound at edge destination
+     */
+    int64_t tip;
+
+    /**
+     * @brief Time to aggregate items for outbound via edge at edge source
+     */
+    int64_t tap;
+
+    /**
+     * @brief Time to process outbound via edge at edge source
+     */
+    int64_t top;
+
+    /**
+     * @brief Actual cost of traversing the edge
+     */
+    double cost;
+
+    /**
+     * @brief Flag to indicate connection as continuous(1) or time-discrete(0)
+     */
+    uint8_t percon;
+
+    /**
+     * @brief Flag to indicate connection as enabled(1) or disabled(0)
+     */
+    uint8_t enabled;
+
+    /**
+     * @brief Padding to align records
+     */
+    uint8_t reserved[6];
+};
+
+/**
+ * @brief Read only memory mapping of a snapshot file
+ * @details The file is mapped shared, hence multiple processes mapping the same snapshot share its pages for as long as they keep it
+ * mapped. BaseGraph copies the graph out of the mapping when loading, hence pages are not shared once loaded.
+ */
+class Snapshot {
+    private:
+        /**
+         * @brief Start of the mapped file
+         */
+        const char* data = nullptr;
+
+        /**
+         * @brief Length of the mapped file
+         */
+        size_t length = 0;
+
+        /**
+         * @brief Fetch a pointer to a section of the file
+         * @param[in] : Offset of the section from start of file
+         * @param[in] : Length of the section in bytes
+         * @return Pointer to start of section
+         */
+        const char* section(uint64_t, uint64_t) const;
+
+    public:
+        /**
+         * @brief Maps a snapshot file and validates its layout
+         * @param[in] : Path to the snapshot file
+         */
+        Snapshot(string_view);
+
+        Snapshot(const Snapshot&) = delete;
+        Snapshot& operator = (const Snapshot&) = delete;
+
+        /**
+         * @brief Unmaps the snapshot file
+         */
+        ~Snapshot();
+
+        /**
+         * @brief Fetch the header of snapshot
+         */
+        const SnapshotHeader& header() const;
+
+        /**
+         * @brief Fetch the vertices in snapshot
+         */
+        const SnapshotVertex* vertices() const;
+
+        /**
+         * @brief Fetch the offsets of first outbound edge per vertex
+         */
+        const uint32_t* offsets() const;
+
+        /**
+         * @brief Fetch the edges in snapshot
+         */
+        const SnapshotEdge* edges() const;
+
+        /**
+         * @brief Fetch the vertices sorted by code
+         */
+        const uint32_t* vertex_index() const;
+
+        /**
+         * @brief Fetch the edges sorted by code
+         */
+        const uint32_t* edge_index() const;
+
+        /**
+         * @brief Fetch a code from the pool
+         * @param[in] : Offset of code in pool
+         * @param[in] : Length of code
+         * @return View of the code in the mapped file
+         */
+        string_view code(uint32_t, uint32_t) const;
+};
+
+#endif
@@ -0,0 +1,365 @@
+#include "solver.hpp"
+#include "compact.hpp"
+
+vector<vector<Path> > Solver::find_paths(const GraphView& view, string_view src, long t_start, const vector<pair<string_view, long> >& targets) const {
+    vector<vector<Path> > paths;
+    paths.reserve(targets.size());
+
+    for (auto const& target: targets) {
+        paths.push_back(find_path(view, src, target.first, t_start, target.second));
+    }
+    return paths;
+}
+
+vector<Path> Solver::find_nearest(const GraphView& view, string_view src, long t_start, const vector<pair<string_view, long> >& targets, size_t& nearest) const {
+    auto paths = find_paths(view, src, t_start, targets);
+    nearest = targets.size();
+
+    for (size_t index = 0; index < paths.size(); index++) {
+        if (paths[index].empty()) {
+            continue;
+        }
+
+        if (nearest == targets.size() || make_pair(paths[index].back().arr, paths[index].back().cost) < make_pair(paths[nearest].back().arr, paths[nearest].back().cost)) {
+            nearest = index;
+        }
+    }
+    return (nearest == targets.size()) ? vector<Path>() : paths[nearest];
+}
+
+bool Solver::slot_key(const GraphView& view, Vertex source, const FindArgs& args, PathKey& key) {
+    if (args.beg > args.tmax) {
+        return false;
+    }
+
+    const CompactGraph& compact = view.compact();
+    const Compact& g = compact.graph();
+    long day = args.beg / TIME_DURINAL - (args.beg % TIME_DURINAL < 0 ? 1 : 0);
+    long time_of_day = args.beg - day * TIME_DURINAL;
+    long slot = TIME_DURINAL;
+
+    for (auto edges = boost::out_edges(CompactVertex(source), g); edges.first != edges.second; edges.first++) {
+        const EdgeProperty& eprop = g[*edges.first];
+
+        if (!compact.enabled(*edges.first)) {
+            continue;
+        }
+
+        if (eprop.percon) {
+            return false;
+        }
+
+        long dep = ((eprop.dep % TIME_DURINAL) + TIME_DURINAL) % TIME_DURINAL;
+
+        if (dep >= time_of_day) {
+            slot = min(slot, dep);
+        }
+    }
+
+    slot = min(slot, args.tmax - day * TIME_DURINAL);
+    key = PathKey{args.src, args.dst, day, slot, args.tmax};
+    return true;
+}
+
+vector<Path> Solver::find_cached(const GraphView& view, const FindArgs& args, shared_ptr<const CachedPath>& held, bool& exact) const {
+    Vertex source;
+    PathKey key;
+    exact = true;
+
+    if (!args.tolerance.exact()) {
+        auto paths = find_pareto(view, args.src, args.dst, args.beg, args.tmax, 1, args.tolerance, exact);
+        return paths.empty() ? vector<Path>() : paths.front();
+    }
+
+    if (!view.vertex(args.src, source) || !slot_key(view, source, args, key)) {
+        return find_path(view, args.src, args.dst, args.beg, args.tmax);
+    }
+
+    held = cache.find(key, view.version());
+
+    if (!held) {
+        held = make_shared<const CachedPath>(view.version(), args.beg, find_path(view, args.src, args.dst, args.beg, args.tmax));
+        cache.insert(key, held);
+    }
+    return held->at(args.beg);
+}
+
+vector<vector<Path> > Solver::find_pareto(const GraphView& view, string_view src, string_view dst, long t_start, long t_max, size_t, const Tolerance&, bool& exact) const {
+    vector<vector<Path> > paths;
+    exact = true;
+    auto path = find_path(view, src, dst, t_start, t_max);
+
+    if (!path.empty()) {
+        paths.push_back(path);
+    }
+    return paths;
+}
+
+shared_ptr<const Profile> Solver::find_profile(const GraphView&, string_view, string_view, long, long, long) const {
+    throw invalid_argument("Profiles are not supported by this mode");
+}
+
+json_array Solver::to_json(const vector<Path>& path) {
+    json_array segments;
+
+    for (auto const& segment: path) {
+        json_map seg;
+        seg["source"] = segment.src.to_string();
+        seg["connection"] = segment.conn.to_string();
+        seg["destination"] = segment.dst.to_string();
+        seg["arrival_at_source"] = segment.arr;
+        seg["arrival_max_by"] = segment.mdep;
+        seg["departure_from_source"] = segment.dep;
+        seg["cost_reaching_source"] = segment.cost;
+        segments.push_back(seg);
+    }
+    return segments;
+}
+
+void Solver::to_binary(const vector<Path>& path, BinaryWriter& writer, bool exact) {
+    writer.put_byte(exact ? BINARY_PATH : BINARY_APPROXIMATE_PATH);
+    writer.put_varint(path.size());
+
+    for (auto const& segment: path) {
+        writer.put_text(segment.src);
+        writer.put_text(segment.conn);
+        writer.put_text(segment.dst);
+        writer.put_integer(segment.arr);
+        writer.put_integer(segment.mdep);
+        writer.put_integer(segment.dep);
+        writer.put_real(segment.cost);
+    }
+}
+
+string Solver::encode(ResponseFormat format, const vector<Path>& path, bool exact) {
+    if (format == FORMAT_BINARY) {
+        string body;
+        BinaryWriter writer{body};
+        to_binary(path, writer, exact);
+        return body;
+    }
+
+    json_map response;
+    response["path"] = to_json(path);
+    response["exact"] = exact;
+    response["success"] = true;
+    return response.to_string();
+}
+
+vector<vector<size_t> > Solver::group_batch(const vector<FindArgs>& batch) {
+    map<pair<string_view, long>, size_t> groups;
+    vector<vector<size_t> > grouped;
+
+    for (size_t index = 0; index < batch.size(); index++) {
+        auto found = groups.emplace(make_pair(string_view(batch[index].src), batch[index].beg), grouped.size());
+
+        if (found.second) {
+            grouped.emplace_back();
+        }
+        grouped[found.first->second].push_back(index);
+    }
+    return grouped;
+}
+
+void Solver::find_group(shared_ptr<BaseGraph> graph, const vector<FindArgs>& batch, const vector<size_t>& group, ResponseFormat format, vector<string>& results) const {
+    const FindArgs& head = batch[group.front()];
+
+    try {
+        GraphView view = graph->view();
+        Vertex vertex;
+
+        if (!view.vertex(head.src, vertex)) {
+            for (size_t index: group) {
+                results[index] = error_response(format, "No source <" + head.src + "> found");
+            }
+            return;
+        }
+
+        Vertex source = vertex;
+        vector<size_t> solvable;
+        vector<pair<bool, PathKey> > keys;
+        vector<pair<string_view, long> > targets;
+
+        for (size_t index: group) {
+            if (!view.vertex(batch[index].dst, vertex)) {
+                results[index] = error_response(format, "No destination <" + batch[index].dst + "> found");
+                continue;
+            }
+
+            PathKey key;
+            bool keyed = slot_key(view, source, batch[index], key);
+
+            if (keyed) {
+                auto held = cache.find(key, view.version());
+
+                if (held) {
+                    results[index] = encode(format, held->at(batch[index].beg));
+                    continue;
+                }
+            }
+
+            solvable.push_back(index);
+            keys.push_back(make_pair(keyed, key));
+            targets.push_back(make_pair(string_view(batch[index].dst), batch[index].tmax));
+        }
+
+        if (targets.empty()) {
+            return;
+        }
+
+        auto paths = find_paths(view, head.src, head.beg, targets);
+
+        // Paths refer to codes held by the graph, hence are serialized while the view is held
+        for (size_t position = 0; position < solvable.size(); position++) {
+            if (keys[position].first) {
+                cache.insert(keys[position].second, make_shared<const CachedPath>(view.version(), batch[solvable[position]].beg, paths[position]));
+            }
+            results[solvable[position]] = encode(format, paths[position]);
+        }
+    }
+    catch (const exception& exc) {
+        for (size_t index: group) {
+            results[index] = error_response(format, exc.what());
+        }
+    }
+}
+
+json_map Solver::find(shared_ptr<BaseGraph> graph, shared_ptr<Solver> solver, const FindArgs& args) {
+    json_map response;
+    try {
+        GraphView view = graph->view();
+        shared_ptr<const CachedPath> held;
+        bool exact;
+        auto path = solver->find_cached(view, args, held, exact);
+        response["path"] = to_json(path);
+        response["exact"] = exact;
+        response["success"] = true;
+    }
+    catch (const exception& exc) {
+        response["error"] = exc.what();
+    }
+    return response;
+}
+
+json_map Solver::prof(shared_ptr<BaseGraph> graph, shared_ptr<Solver> solver, const ProfileArgs& args) {
+    json_map response;
+    try {
+        if (args.point && (args.at < args.beg || args.at > args.end)) {
+            throw invalid_argument("Time <" + to_string(args.at) + "> is outside the window of the profile");
+        }
+
+        GraphView view = graph->view();
+        auto profile = solver->find_profile(view, args.src, args.dst, args.beg, args.end, args.tmax);
+
+        json_array journeys;
+
+        auto add_journey = [&journeys](const ProfileEntry& entry) {
+            json_map journey;
+            journey["departure"] = entry.dep;
+            journey["arrival"] = entry.arr;
+            journey["cost"] = entry.cost;
+            journeys.push_back(journey);
+        };
+
+        if (args.point) {
+            ProfileEntry entry;
+
+            if (profile->at(args.at, entry)) {
+                add_journey(entry);
+            }
+        }
+        else {
+            for (auto const& entry: profile->journeys()) {
+                add_journey(entry);
+            }
+
+            if (profile->continuous() >= 0) {
+                response["continuous"] = profile->continuous();
+            }
+        }
+
+        response["profile"] = journeys;
+        response["success"] = true;
+    }
+    catch (const exception& exc) {
+        response["error"] = exc.what();
+    }
+    return response;
+}
+
+json_map Solver::many(shared_ptr<BaseGraph> graph, shared_ptr<Solver> solver, const ManyArgs& args) {
+    json_map response;
+    try {
+        GraphView view = graph->view();
+        vector<pair<string_view, long> > targets;
+
+        for (auto const& dst: args.dsts) {
+            targets.push_back(make_pair(string_view(dst), args.tmax));
+        }
+
+        if (args.best) {
+            size_t nearest;
+            auto path = solver->find_nearest(view, args.src, args.beg, targets, nearest);
+
+            if (nearest < targets.size()) {
+                response["index"] = nearest;
+            }
+            response["path"] = to_json(path);
+        }
+        else {
+            json_array paths;
+
+            for (auto const& path: solver->find_paths(view, args.src, args.beg, targets)) {
+                paths.push_back(to_json(path));
+            }
+            response["paths"] = paths;
+        }
+        response["success"] = true;
+    }
+    catch (const exception& exc) {
+        response["error"] = exc.what();
+    }
+    return response;
+}
+
+json_map Solver::pset(shared_ptr<BaseGraph> graph, shared_ptr<Solver> solver, const ParetoArgs& args) {
+    json_map response;
+    try {
+        GraphView view = graph->view();
+        json_array paths;
+        bool exact;
+
+        for (auto const& path: solver->find_pareto(view, args.src, args.dst, args.beg, args.tmax, args.limit, args.tolerance, exact)) {
+            paths.push_back(to_json(path));
+        }
+        response["paths"] = paths;
+        response["exact"] = exact;
+        response["success"] = true;
+    }
+    catch (const exception& exc) {
+        response["error"] = exc.what();
+    }
+    return response;
+}
+
+json_map Solver::stat(shared_ptr<Solver> solver) {
+    json_map response;
+    response["hits"] = solver->cache.hit_count();
+    response["misses"] = solver->cache.miss_count();
+    response["cached"] = solver->cache.size();
+    response["success"] = true;
+    return response;
+}
+
+string Solver::find_binary(shared_ptr<BaseGraph> graph, shared_ptr<Solver> solver, const FindArgs& args) {
+    try {
+        GraphView view = graph->view();
+        shared_ptr<const CachedPath> held;
+        bool exact;
+        auto path = solver->find_cached(view, args, held, exact);
+        return encode(FORMAT_BINARY, path, exact);
+    }
+    catch (const exception& exc) {
+        return error_response(FORMAT_BINARY, exc.what());
+    }
+}
@@ -0,0 +1,288 @@
+/** @file solver.hpp
+ * @brief Defines the interface for path solvers traversing a shared graph
+ */
+#ifndef SOLVER_HPP_INCLUDED
+#define SOLVER_HPP_INCLUDED
+
+#include <atomic>
+#include <functional>
+
+#include "cache.hpp"
+#include "encoding.hpp"
+#include "graph.hpp"
+#include "profile.hpp"
+
+/**
+ * @brief Interface representing an algorithm which traverses the graph in different ways to satisfy various constraints
+ * @details Solvers are stateless with respect to the graph. They traverse a read only view of the graph shared by all solvers. Each solver
+ * caches the paths it finds for FIND and BFND, tagged with the version of the graph they were found against.
+ */
+class Solver {
+    private:
+        /**
+         * @brief Paths found by the solver, by departure slot
+         */
+        mutable PathCache cache;
+
+        /**
+         * @brief Builds the key of the departure slot of a query
+         * @details A slot closes at the next departure out of source, at midnight or at the time limit, whichever is earliest. Queries
+         * from a source with continuous out edges reach their neighbours at a time depending on the time of arrival at source, hence
+         * have no slot.
+         * @param[in] : Read only view of the graph
+         * @param[in] : Source vertex
+         * @param[in] : Typed arguments of query
+         * @param[out] : Key of the slot
+         * @return True if the query has a slot, false if it can not be cached
+         */
+        static bool slot_key(const GraphView&, Vertex, const FindArgs&, PathKey&);
+
+        /**
+         * @brief Finds a path, looking it up in the cache first
+         * @details Queries with a tolerance are answered by find_pareto and bypass the cache, their paths depending on the tolerance.
+         * @param[in] : Read only view of the graph to traverse
+         * @param[in] : Typed arguments of query
+         * @param[out] : Cached path the path returned refers to
+         * @param[out] : Flag to indicate the path is exact rather than within the tolerance of the query
+         * @return Path as returned by find_path. Codes are views into the graph or the cached path
+         */
+        vector<Path> find_cached(const GraphView&, const FindArgs&, shared_ptr<const CachedPath>&, bool&) const;
+
+    public:
+        /**
+         * @brief Destroys the solver
+         */
+        virtual ~Solver() {}
+
+        /**
+         * @brief Finds and returns a path based on various relaxation criteria
+         * @param[in] : Read only view of the graph to traverse
+         * @param[in] : Source vertex
+         * @param[in] : Destination vertex
+         * @param[in] : Time of arrival at source vertex
+         * @param[in] : Maximum time to arrive at destination vertex
+         * @return A vector of Path representing an ideal path satisfying specified constraints
+         */
+        virtual vector<Path> find_path(const GraphView&, string_view, string_view, long, long) const = 0;
+
+        /**
+         * @brief Finds paths from a source vertex to several destination vertices
+         * @details Defaults to finding each path independently. Solvers able to share a traversal between destinations override it.
+         * @param[in] : Read only view of the graph to traverse
+         * @param[in] : Source vertex
+         * @param[in] : Time of arrival at source vertex
+         * @param[in] : Destination vertices paired with the maximum time to arrive at each
+         * @return Paths in order of destinations as returned by find_path
+         */
+        virtual vector<vector<Path> > find_paths(const GraphView&, string_view, long, const vector<pair<string_view, long> >&) const;
+
+        /**
+         * @brief Finds the path to the nearest of several destination vertices
+         * @details The nearest destination is the one arrived at earliest, ties broken by least cost then by order. Defaults to picking it
+         * from the paths found by find_paths. Solvers able to stop once the nearest destination is settled override it.
+         * @param[in] : Read only view of the graph to traverse
+         * @param[in] : Source vertex
+         * @param[in] : Time of arrival at source vertex
+         * @param[in] : Destination vertices paired with the maximum time to arrive at each
+         * @param[out] : Index of the nearest destination, or the number of destinations if none is reachable
+         * @return Path to the nearest destination as returned by find_path, empty if none is reachable
+         */
+        virtual vector<Path> find_nearest(const GraphView&, string_view, long, const vector<pair<string_view, long> >&, size_t&) const;
+
+        /**
+         * @brief Finds the paths from a source vertex to a destination vertex which are not dominated on both cost and time of arrival
+         * @details Defaults to the single path found by find_path, which is exact regardless of tolerance. Solvers able to find every non
+         * dominated path override it.
+         * @param[in] : Read only view of the graph to traverse
+         * @param[in] : Source vertex
+         * @param[in] : Destination vertex
+         * @param[in] : Time of arrival at source vertex
+         * @param[in] : Maximum time to arrive at destination vertex
+         * @param[in] : Maximum number of paths
+         * @param[in] : Bounds on the effort of the search
+         * @param[out] : Flag to indicate the paths are exact, i.e. no path was dropped for being within tolerance or over budget
+         * @return Paths as returned by find_path in increasing order of cost, empty if destination can not be reached
+         */
+        virtual vector<vector<Path> > find_pareto(const GraphView&, string_view, string_view, long, long, size_t, const Tolerance&, bool&) const;
+
+        /**
+         * @brief Finds the profile of journeys from a source vertex to a destination vertex over a window of departures
+         * @details Defaults to failing. Solvers able to compute a profile in a single search override it.
+         * @param[in] : Read only view of the graph to traverse
+         * @param[in] : Source vertex
+         * @param[in] : Destination vertex
+         * @param[in] : Earliest time of arrival at source vertex
+         * @param[in] : Latest time of arrival at source vertex
+         * @param[in] : Maximum time to arrive at destination vertex
+         * @return Profile of journeys, which may be shared with other queries
+         */
+        virtual shared_ptr<const Profile> find_profile(const GraphView&, string_view, string_view, long, long, long) const;
+
+        /**
+         * @brief Serializes a path to json
+         * @param[in] : Path as returned by find_path
+         * @return A json array of segments in path
+         */
+        static json_array to_json(const vector<Path>&);
+
+        /**
+         * @brief Serializes a path to a BINARY_PATH response, or a BINARY_APPROXIMATE_PATH response if not exact
+         * @param[in] : Path as returned by find_path
+         * @param[in,out] : Writer to which the response is appended
+         * @param[in] : Optional flag to indicate the path is exact. Defaults to true
+         */
+        static void to_binary(const vector<Path>&, BinaryWriter&, bool = true);
+
+        /**
+         * @brief Serializes a path to a response in a format
+         * @param[in] : Format to serialize to
+         * @param[in] : Path as returned by find_path
+         * @param[in] : Optional flag to indicate the path is exact. Defaults to true
+         * @return Body of the response, as generated by find
+         */
+        static string encode(ResponseFormat, const vector<Path>&, bool = true);
+
+        /**
+         * @brief Groups queries of a batch which share a source vertex and time of arrival at it
+         * @param[in] : Queries of batch
+         * @return Indices of queries per group
+         */
+        static vector<vector<size_t> > group_batch(const vector<FindArgs>&);
+
+        /**
+         * @brief Finds paths for a group of queries sharing a source vertex and time of arrival at it
+         * @details Queries failing individually are reported against themselves without failing the group. Never throws.
+         * @param[in] : Pointer to an instance of BaseGraph against which paths are traversed
+         * @param[in] : Queries of batch
+         * @param[in] : Indices of queries in group
+         * @param[in] : Format to serialize responses to
+         * @param[out] : Serialized responses per query, indexed as the queries
+         */
+        void find_group(shared_ptr<BaseGraph>, const vector<FindArgs>&, const vector<size_t>&, ResponseFormat, vector<string>&) const;
+
+        /**
+         * @brief Helper function to find a multi-criteria shortest path in BaseGraph.
+         * @param[in] : Pointer to an instance of BaseGraph against which a path is traversed
+         * @param[in] : Pointer to an instance of Solver used to traverse the graph
+         * @param[in] : Typed arguments for path traversal
+         * @return A json response indicating success or failure of the command and any additional output from the underlying command
+         */
+        static json_map find(shared_ptr<BaseGraph>, shared_ptr<Solver>, const FindArgs&);
+
+        /**
+         * @brief Helper function to find a multi-criteria shortest path in BaseGraph, responding in the binary format
+         * @details Segments are written straight to the response as they are read off the path, without building a json document
+         * @param[in] : Pointer to an instance of BaseGraph against which a path is traversed
+         * @param[in] : Pointer to an instance of Solver used to traverse the graph
+         * @param[in] : Typed arguments for path traversal
+         * @return A BINARY_PATH, BINARY_APPROXIMATE_PATH or BINARY_ERROR response
+         */
+        static string find_binary(shared_ptr<BaseGraph>, shared_ptr<Solver>, const FindArgs&);
+
+        /**
+         * @brief Helper function to find the profile of a pair of vertices in BaseGraph.
+         * @param[in] : Pointer to an instance of BaseGraph against which journeys are traversed
+         * @param[in] : Pointer to an instance of Solver used to traverse the graph
+         * @param[in] : Typed arguments for the profile
+         * @return A json response indicating success or failure of the command and any additional output from the underlying command
+         */
+        static json_map prof(shared_ptr<BaseGraph>, shared_ptr<Solver>, const ProfileArgs&);
+
+        /**
+         * @brief Helper function to find paths from a source vertex to a set of destination vertices in BaseGraph.
+         * @param[in] : Pointer to an instance of BaseGraph against which paths are traversed
+         * @param[in] : Pointer to an instance of Solver used to traverse the graph
+         * @param[in] : Typed arguments of query
+         * @return A json response holding a path per destination, or the path to the nearest destination along with its index
+         */
+        static json_map many(shared_ptr<BaseGraph>, shared_ptr<Solver>, const ManyArgs&);
+
+        /**
+         * @brief Helper function to find the non dominated paths between a pair of vertices in BaseGraph.
+         * @param[in] : Pointer to an instance of BaseGraph against which paths are traversed
+         * @param[in] : Pointer to an instance of Solver used to traverse the graph
+         * @param[in] : Typed arguments of query
+         * @return A json response holding the paths in increasing order of cost, hence decreasing order of time of arrival, and whether
+         * they are exact
+         */
+        static json_map pset(shared_ptr<BaseGraph>, shared_ptr<Solver>, const ParetoArgs&);
+
+        /**
+         * @brief Helper function to report the use of the cache of paths of a solver.
+         * @param[in] : Pointer to an instance of Solver
+         * @return A json response holding the number of hits and misses of the cache and the number of paths it holds
+         */
+        static json_map stat(shared_ptr<Solver>);
+
+        /**
+         * @brief Helper function to find paths for a batch of queries in BaseGraph.
+         * @details Queries are grouped by source and time of arrival at source, with each group solved as a separate task on executor.
+         * The calling thread returns once the groups are queued, the response being passed on by the task finishing last.
+         * @param[in] : Pointer to an instance of BaseGraph against which paths are traversed
+         * @param[in] : Pointer to an instance of Solver used to traverse the graph
+         * @param[in] : Typed arguments carrying the queries
+         * @param[in] : Format to serialize the response to
+         * @param[in] : Executor exposing post(task) on which groups are solved
+         * @param[in] : Callback invoked with a response holding a response per query, in order, as generated by find or find_binary
+         */
+        template <typename E> static void find_batch(shared_ptr<BaseGraph>, shared_ptr<Solver>, const BatchArgs&, ResponseFormat, E&, function<void(string)>);
+};
+
+template <typename E> void Solver::find_batch(shared_ptr<BaseGraph> graph, shared_ptr<Solver> solver, const BatchArgs& args, ResponseFormat format, E& executor, function<void(string)> respond) {
+    try {
+        auto batch = make_shared<vector<FindArgs> >(args.queries);
+        auto groups = group_batch(*batch);
+        auto results = make_shared<vector<string> >(batch->size());
+        auto remaining = make_shared<atomic<size_t> >(groups.size());
+
+        // Responses per query are already serialized, hence are spliced into the response instead of being parsed into a document
+        auto gather = [batch, results, format, respond]() {
+            string body;
+
+            if (format == FORMAT_BINARY) {
+                BinaryWriter writer{body};
+                writer.put_byte(BINARY_PATHS);
+                writer.put_varint(results->size());
+
+                for (auto const& result: *results) {
+                    writer.put_raw(result);
+                }
+            }
+            else {
+                body = "{\"paths\":[";
+
+                for (size_t index = 0; index < results->size(); index++) {
+                    if (index > 0) {
+                        body += ",";
+                    }
+                    body += (*results)[index];
+                }
+                body += "],\"success\":true}";
+            }
+            respond(move(body));
+        };
+
+        if (groups.empty()) {
+            gather();
+            return;
+        }
+
+        for (auto const& group: groups) {
+            executor.post(
+                [graph, solver, batch, group, format, results, remaining, gather]() {
+                    solver->find_group(graph, *batch, group, format, *results);
+
+                    if (--(*remaining) == 0) {
+                        gather();
+                    }
+                }
+            );
+        }
+        return;
+    }
+    catch (const exception& exc) {
+        respond(error_response(format, exc.what()));
+    }
+}
+
+#endif
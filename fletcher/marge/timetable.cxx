@@ -0,0 +1,54 @@
+#include <algorithm>
+
+#include "timetable.hpp"
+
+long departure_after(const EdgeProperty& eprop, long arrival) {
+    if (eprop.percon) {
+        return arrival;
+    }
+
+    long dep = ((eprop.dep % TIME_DURINAL) + TIME_DURINAL) % TIME_DURINAL;
+    long wait = ((dep - arrival % TIME_DURINAL) % TIME_DURINAL + TIME_DURINAL) % TIME_DURINAL;
+    return arrival + wait;
+}
+
+Timetable::Timetable(const Compact& g) {
+    size_t nvertices = boost::num_vertices(g);
+    offsets.assign(nvertices + 1, 0);
+
+    for (size_t vertex = 0; vertex < nvertices; vertex++) {
+        for (auto edges = boost::out_edges(CompactVertex(vertex), g); edges.first != edges.second; edges.first++) {
+            const EdgeProperty& eprop = g[*edges.first];
+            uint32_t target = boost::target(*edges.first, g);
+            uint32_t index = boost::get(boost::edge_index, g, *edges.first);
+
+            if (eprop.percon) {
+                transfers.push_back(Transfer{target, index, eprop._tip + eprop._tap + eprop._top});
+            }
+            else {
+                long dep = ((eprop.dep % TIME_DURINAL) + TIME_DURINAL) % TIME_DURINAL;
+                connections.push_back(Connection{uint32_t(vertex), target, index, dep, eprop.dur, eprop.cost});
+            }
+        }
+        offsets[vertex + 1] = transfers.size();
+    }
+
+    stable_sort(connections.begin(), connections.end(), [](const Connection& first, const Connection& second) {
+        return first.dep < second.dep;
+    });
+}
+
+const vector<Connection>& Timetable::departures() const {
+    return connections;
+}
+
+size_t Timetable::first_departure(long time_of_day) const {
+    auto found = lower_bound(connections.begin(), connections.end(), time_of_day, [](const Connection& connection, long time) {
+        return connection.dep < time;
+    });
+    return found - connections.begin();
+}
+
+pair<const Transfer*, const Transfer*> Timetable::transfers_from(uint32_t vertex) const {
+    return make_pair(transfers.data() + offsets[vertex], transfers.data() + offsets[vertex + 1]);
+}
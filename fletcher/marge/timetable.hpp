@@ -0,0 +1,125 @@
+/** @file timetable.hpp
+ * @brief Defines the connections of a compact graph sorted by their daily departure, as scanned by the Connection Scan Algorithm
+ * @details Time-discrete edges depart once a day, hence a single day of connections sorted by time of departure describes every day. Continuous
+ * edges have no departure and are held apart as transfers, grouped by source vertex.
+ */
+#ifndef TIMETABLE_HPP_INCLUDED
+#define TIMETABLE_HPP_INCLUDED
+
+#include <cstdint>
+#include <vector>
+
+#include "compact.hpp"
+
+/**
+ * @brief A time-discrete edge departing once a day
+ */
+struct Connection {
+    /**
+     * @brief Source vertex of edge
+     */
+    uint32_t src;
+
+    /**
+     * @brief Destination vertex of edge
+     */
+    uint32_t dst;
+
+    /**
+     * @brief Index of edge in the compact image
+     */
+    uint32_t edge;
+
+    /**
+     * @brief Computed departure time at source of edge, taken modulo TIME_DURINAL
+     */
+    long dep;
+
+    /**
+     * @brief Computed duration for traversal via edge
+     */
+    long dur;
+
+    /**
+     * @brief Actual cost of traversing the edge
+     */
+    double cost;
+};
+
+/**
+ * @brief A continuous edge, traversable at any time
+ */
+struct Transfer {
+    /**
+     * @brief Destination vertex of edge
+     */
+    uint32_t dst;
+
+    /**
+     * @brief Index of edge in the compact image
+     */
+    uint32_t edge;
+
+    /**
+     * @brief Time to traverse the edge, as the sum of its processing times
+     */
+    long dur;
+};
+
+/**
+ * @brief Finds the time of departure via an edge on arrival at its source, taking its departure modulo TIME_DURINAL
+ * @param[in] : Properties of edge
+ * @param[in] : Time of arrival at edge source
+ * @return Time of the first departure via the edge at or after arrival
+ */
+long departure_after(const EdgeProperty&, long);
+
+/**
+ * @brief Connections and transfers of a version of the graph
+ * @details Built once from a CompactGraph and immutable thereafter, hence shared by all scans of that version.
+ */
+class Timetable {
+    private:
+        /**
+         * @brief Time-discrete edges sorted by departure. Ties keep the order of edges in the compact image
+         */
+        vector<Connection> connections;
+
+        /**
+         * @brief Offset of the first transfer of each vertex, followed by the number of transfers
+         */
+        vector<uint32_t> offsets;
+
+        /**
+         * @brief Continuous edges grouped by source vertex, in order of the compact image
+         */
+        vector<Transfer> transfers;
+
+    public:
+        /**
+         * @brief Builds the timetable of a compact image
+         * @param[in] : Compact image of the graph
+         */
+        Timetable(const Compact&);
+
+        /**
+         * @brief Fetch the connections sorted by departure
+         */
+        const vector<Connection>& departures() const;
+
+        /**
+         * @brief Finds the first connection departing at or after a time of day
+         * @param[in] : Time of day, in [0, TIME_DURINAL)
+         * @return Position of the connection, or the number of connections if none departs that late
+         */
+        size_t first_departure(long) const;
+
+        /**
+         * @brief Fetch the transfers out of a vertex
+         * @param[in] : Source vertex
+         * @return Pointers to the first and past the last transfer
+         */
+        pair<const Transfer*, const Transfer*> transfers_from(uint32_t) const;
+};
+
+#endif
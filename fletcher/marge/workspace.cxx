@@ -0,0 +1,39 @@
+#include "workspace.hpp"
+
+void Workspace::reset(size_t nvertices) {
+    for (uint32_t vertex: touched) {
+        distances[vertex] = Cost{P_D_INF, P_L_INF};
+        states[vertex] = VERTEX_UNREACHED;
+    }
+
+    for (uint32_t vertex: destinations) {
+        awaited[vertex] = false;
+    }
+
+    touched.clear();
+    destinations.clear();
+
+    if (distances.size() < nvertices) {
+        distances.resize(nvertices, Cost{P_D_INF, P_L_INF});
+        predecessors.resize(nvertices);
+        states.resize(nvertices, VERTEX_UNREACHED);
+        awaited.resize(nvertices, false);
+    }
+}
+
+bool Workspace::await(Vertex vertex) {
+    if (awaited[vertex]) {
+        return false;
+    }
+    awaited[vertex] = true;
+    destinations.push_back(vertex);
+    return true;
+}
+
+bool Workspace::arrive(Vertex vertex) {
+    if (!awaited[vertex]) {
+        return false;
+    }
+    awaited[vertex] = false;
+    return true;
+}
@@ -0,0 +1,135 @@
+/** @file workspace.hpp
+ * @brief Defines the per vertex state of a search, reused across the searches of a thread
+ * @details A search over the compact image tracks a distance, a predecessor and a state per vertex. Allocating and initializing these for
+ * every vertex costs as much as the search itself for queries settling few vertices. A workspace instead keeps its arrays across
+ * searches and records the vertices each search reaches, resetting only those before the next, hence starting a search takes no longer
+ * than the previous search did and arrays are only grown when the image grows. Entries are read as plain array loads.
+ */
+#ifndef WORKSPACE_HPP_INCLUDED
+#define WORKSPACE_HPP_INCLUDED
+
+#include <cstdint>
+#include <vector>
+
+#include "compact.hpp"
+
+/**
+ * @brief States of a vertex during a search
+ */
+enum VertexState : uint8_t {
+    VERTEX_UNREACHED = 0,
+    VERTEX_REACHED = 1,
+    VERTEX_SETTLED = 2
+};
+
+/**
+ * @brief Distances, predecessors and states of vertices for one search at a time, held as parallel arrays by vertex
+ * @details Entries are valid for the search started last only. A workspace is meant to be held per thread, as it is not synchronized.
+ */
+class Workspace {
+    private:
+        /**
+         * @brief Cost and time of arrival per vertex, infinite if unreached
+         */
+        vector<Cost> distances;
+
+        /**
+         * @brief Edge each vertex was arrived at via, valid for reached vertices other than source only
+         */
+        vector<CompactEdgeDescriptor> predecessors;
+
+        /**
+         * @brief State per vertex
+         */
+        vector<VertexState> states;
+
+        /**
+         * @brief Flag per vertex to indicate it is a destination not arrived at yet
+         */
+        vector<uint8_t> awaited;
+
+        /**
+         * @brief Vertices reached since the last reset
+         */
+        vector<uint32_t> touched;
+
+        /**
+         * @brief Vertices awaited since the last reset
+         */
+        vector<uint32_t> destinations;
+
+    public:
+        /**
+         * @brief Starts a search, every vertex being unreached at infinite distance and not awaited
+         * @param[in] : Number of vertices of the image searched. Arrays are grown to it if shorter, never shrunk
+         */
+        void reset(size_t);
+
+        /**
+         * @brief Fetch the cost and time of arrival at a vertex, infinite if unreached
+         */
+        const Cost& distance(Vertex) const;
+
+        /**
+         * @brief Fetch the edge a vertex was arrived at via. Valid for reached vertices other than source only
+         */
+        CompactEdgeDescriptor predecessor(Vertex) const;
+
+        /**
+         * @brief Fetch the state of a vertex
+         */
+        VertexState state(Vertex) const;
+
+        /**
+         * @brief Records the arrival at a vertex, marking it reached unless settled
+         * @param[in] : Vertex
+         * @param[in] : Cost and time of arrival
+         * @param[in] : Edge arrived at via
+         */
+        void reach(Vertex, const Cost&, CompactEdgeDescriptor);
+
+        /**
+         * @brief Marks a vertex reached as settled
+         */
+        void settle(Vertex);
+
+        /**
+         * @brief Marks a vertex as a destination to await
+         * @return True if the vertex was not awaited yet
+         */
+        bool await(Vertex);
+
+        /**
+         * @brief Marks an awaited vertex as arrived at
+         * @return True if the vertex was awaited, in which case it no longer is
+         */
+        bool arrive(Vertex);
+};
+
+// Accessors are defined inline, being called once or more per edge relaxed
+inline const Cost& Workspace::distance(Vertex vertex) const {
+    return distances[vertex];
+}
+
+inline CompactEdgeDescriptor Workspace::predecessor(Vertex vertex) const {
+    return predecessors[vertex];
+}
+
+inline VertexState Workspace::state(Vertex vertex) const {
+    return states[vertex];
+}
+
+inline void Workspace::reach(Vertex vertex, const Cost& distance, CompactEdgeDescriptor predecessor) {
+    if (states[vertex] == VERTEX_UNREACHED) {
+        states[vertex] = VERTEX_REACHED;
+        touched.push_back(vertex);
+    }
+    distances[vertex] = distance;
+    predecessors[vertex] = predecessor;
+}
+
+inline void Workspace::settle(Vertex vertex) {
+    states[vertex] = VERTEX_SETTLED;
+}
+
+#endif
@@ -1,41 +1,152 @@
 /** @file weld.hpp
  * @brief Defines a class to map string commands to solver functions
  */
-#include <experimental/any>
 #include <experimental/string_view>
 #include <functional>
-#include <future>
 #include <map>
+#include <set>
 #include <vector>
 #include <jeayeson/jeayeson.hpp>
 
+#include "arguments.hpp"
+#include "encoding.hpp"
+#include "executor.hpp"
+
 using namespace std;
-using std::experimental::any;
 using std::experimental::string_view;
 
 /**
  * @brief Class to handle command -> function mapping
  * @details Stores command -> function mapping and invokes appropriate commands against solvers and returns their output.
- * Requires a template parameter to specify the type of supported solvers
+ * Requires template parameters to specify the type of supported solvers and the graph they share. Commands mutating the graph are
+ * applied once to the shared graph while queries are executed only against the solver selected by mode. All commands are executed on a
+ * persistent pool of workers and respond asynchronously.
+ *
+ * Mutations are executed one at a time in the order they were passed on, hence mutations pipelined on a connection are applied in the
+ * order they were sent. Queries are executed as soon as a worker is free, hence a query pipelined after a mutation may not observe it.
+ *
+ * Each command is bound to its typed arguments by the calling thread, hence named arguments need only be valid for the duration of the
+ * call while the typed arguments travel with the command to the worker.
+ *
+ * Responses are passed on serialized. Queries with a binary encoding respond in the format requested, all other commands respond in
+ * json.
  */
-template <typename T> class Weld {
+template <typename T, typename G> class Weld {
 
     private:
+        /**
+         * @brief A command which mutates or persists the graph, bound to its typed arguments
+         */
+        typedef function<json_map(shared_ptr<G>)> Mutation;
+
+        /**
+         * @brief A command which queries the graph, bound to its typed arguments
+         */
+        typedef function<json_map(shared_ptr<G>, shared_ptr<T>)> Query;
+
+        /**
+         * @brief A command which queries the graph and serializes its response itself, bound to its typed arguments
+         */
+        typedef function<string(shared_ptr<G>, shared_ptr<T>)> Encoder;
+
+        /**
+         * @brief A command which carries a batch of queries, bound to its typed arguments
+         */
+        typedef function<void(shared_ptr<G>, shared_ptr<T>, ResponseFormat, Executor&, function<void(string)>)> Batch;
+
+        /**
+         * @brief Graph shared by all solvers
+         */
+        shared_ptr<G> graph;
+
         /**
          * @brief Vector to maintain a list of solvers
          */
         vector<shared_ptr<T> > solvers;
 
         /**
-         * @brief Map mapping a command to executable function against the solver
+         * @brief Map mapping a command which mutates or persists the graph to a function binding it to its arguments
+         */
+        static map<string, function<Mutation(const Arguments&)>, less<> > mutators;
+
+        /**
+         * @brief Map mapping a command which queries the graph to a function binding it to its arguments
          */
-        static map<string, function<json_map(shared_ptr<T>, const map<string, any>&)> > welder;
+        static map<string, function<Query(const Arguments&)>, less<> > queries;
+
+        /**
+         * @brief Map mapping a command which queries the graph to a function binding its binary encoding to its arguments
+         */
+        static map<string, function<Encoder(const Arguments&)>, less<> > encoders;
+
+        /**
+         * @brief Map mapping a command which carries a batch of queries to a function binding it to its arguments
+         */
+        static map<string, function<Batch(const Arguments&)>, less<> > batches;
+
+        /**
+         * @brief Pool of workers on which commands are executed
+         */
+        Executor executor;
+
+        /**
+         * @brief Binds a helper against the graph to the typed arguments it parses
+         * @param[in] helper: Helper taking the graph and its typed arguments
+         * @return Function parsing named arguments into typed arguments and binding the helper to them
+         */
+        template <typename A> static function<Mutation(const Arguments&)> bind(json_map (*helper)(shared_ptr<G>, const A&)) {
+            return [helper](const Arguments& arguments) -> Mutation {
+                A args = A::parse(arguments);
+                return [helper, args](shared_ptr<G> target) { return helper(target, args); };
+            };
+        }
+
+        /**
+         * @brief Binds a helper against a solver to the typed arguments it parses
+         * @param[in] helper: Helper taking the graph, a solver and its typed arguments
+         * @return Function parsing named arguments into typed arguments and binding the helper to them
+         */
+        template <typename A> static function<Query(const Arguments&)> bind(json_map (*helper)(shared_ptr<G>, shared_ptr<T>, const A&)) {
+            return [helper](const Arguments& arguments) -> Query {
+                A args = A::parse(arguments);
+                return [helper, args](shared_ptr<G> target, shared_ptr<T> solver) { return helper(target, solver, args); };
+            };
+        }
+
+        /**
+         * @brief Binds a helper serializing its own response against a solver to the typed arguments it parses
+         * @param[in] helper: Helper taking the graph, a solver and its typed arguments
+         * @return Function parsing named arguments into typed arguments and binding the helper to them
+         */
+        template <typename A> static function<Encoder(const Arguments&)> bind(string (*helper)(shared_ptr<G>, shared_ptr<T>, const A&)) {
+            return [helper](const Arguments& arguments) -> Encoder {
+                A args = A::parse(arguments);
+                return [helper, args](shared_ptr<G> target, shared_ptr<T> solver) { return helper(target, solver, args); };
+            };
+        }
+
+        /**
+         * @brief Binds a helper spreading a batch over the executor to the typed arguments it parses
+         * @param[in] helper: Helper taking the graph, a solver, its typed arguments, the response format, the executor and a callback for
+         * the response
+         * @return Function parsing named arguments into typed arguments and binding the helper to them
+         */
+        template <typename A> static function<Batch(const Arguments&)> bind(void (*helper)(shared_ptr<G>, shared_ptr<T>, const A&, ResponseFormat, Executor&, function<void(string)>)) {
+            return [helper](const Arguments& arguments) -> Batch {
+                A args = A::parse(arguments);
+                return [helper, args](shared_ptr<G> target, shared_ptr<T> solver, ResponseFormat format, Executor& executor, function<void(string)> respond) {
+                    helper(target, solver, args, format, executor, respond);
+                };
+            };
+        }
 
     public:
         /**
-         * @brief Default constructs a Weld instance
+         * @brief Constructs a Weld instance
+         * @param[in] : Graph shared by all solvers
+         * @param[in] : Optional number of workers to execute commands on. Defaults to the number of hardware threads
          */
-        Weld() { }
+        Weld(const shared_ptr<G>& _graph, size_t nthreads = thread::hardware_concurrency()) : graph(_graph), executor(nthreads) { }
 
         /**
          * @brief Adds solvers to be used for commands
@@ -46,39 +157,122 @@ template <typename T> class Weld {
         }
 
         /**
-         * @brief Executes a command against solvers asynchronously, fetches the results and returns the mode appropriate solution
+         * @brief Checks if a command may be passed on now, the workers not being saturated
+         * @param[in] resume: Callback invoked on a worker once the workers catch up, if not admitted now. Must not throw or block
+         * @return True if admitted. Otherwise resume is kept until invoked
+         */
+        bool admit(function<void()> resume) {
+            return executor.admit(move(resume));
+        }
+
+        /**
+         * @brief Executes a command against the graph or the mode appropriate solver and passes its solution on to a callback
+         * @details The command is executed on a worker, hence the calling thread returns without waiting on the solution
          * @param[in] mode: Solver mode
+         * @param[in] format: Format requested for the response. Honoured by queries with a binary encoding only
          * @param[in] command: Command to execute
-         * @param[in] kwargs: Named arguments for command
-         * @return A json response as generated by command
-         */
-        json_map operator() (int mode, string_view command, const map<string, any>& kwargs) {
-            vector<json_map> data;
-            vector<future<json_map> > responses;
-
-            for (const auto& solver: solvers) {
-                responses.push_back(
-                    async(
-                        [this, &command, &solver, &kwargs]() {
-                            return welder.at(command.to_string())(solver, kwargs);
+         * @param[in] arguments: Named arguments for command. Need only be valid for the duration of the call
+         * @param[in] respond: Callback invoked with the serialized response as generated by command. May be invoked on any thread
+         */
+        void operator() (int mode, ResponseFormat format, string_view command, const Arguments& arguments, function<void(string)> respond) {
+            shared_ptr<G> target = graph;
+            auto encoder = encoders.find(command);
+
+            // Failures are reported in binary only to commands which would have responded in binary
+            ResponseFormat error_format = FORMAT_JSON;
+
+            if (format == FORMAT_BINARY && (encoder != encoders.end() || batches.count(command) > 0)) {
+                error_format = FORMAT_BINARY;
+            }
+
+            try {
+                auto mutator = mutators.find(command);
+
+                if (mutator != mutators.end()) {
+                    Mutation mutation = mutator->second(arguments);
+
+                    executor.post_serial(
+                        [mutation, target, respond]() {
+                            respond(mutation(target).to_string());
                         }
-                    )
+                    );
+                    return;
+                }
+
+                auto query = queries.find(command);
+                auto batch = batches.find(command);
+
+                if (query == queries.end() && batch == batches.end()) {
+                    respond(error_response(error_format, "Unsupported command <" + command.to_string() + ">"));
+                    return;
+                }
+
+                if (mode < 0 || size_t(mode) >= solvers.size()) {
+                    respond(error_response(error_format, "Unsupported mode <" + to_string(mode) + ">"));
+                    return;
+                }
+
+                shared_ptr<T> solver = solvers[mode];
+
+                if (batch != batches.end()) {
+                    batch->second(arguments)(target, solver, format, executor, respond);
+                    return;
+                }
+
+                if (format == FORMAT_BINARY && encoder != encoders.end()) {
+                    Encoder bound = encoder->second(arguments);
+
+                    executor.post(
+                        [bound, target, solver, respond]() {
+                            respond(bound(target, solver));
+                        }
+                    );
+                    return;
+                }
+
+                Query bound = query->second(arguments);
+
+                executor.post(
+                    [bound, target, solver, respond]() {
+                        respond(bound(target, solver).to_string());
+                    }
                 );
             }
-
-            for (auto& response: responses) {
-                data.push_back(response.get());
+            catch (const exception& exc) {
+                respond(error_response(error_format, exc.what()));
             }
-
-            return data[mode];
         }
 };
 
-template <typename T> map<string, function<json_map(shared_ptr<T>, const map<string, any>&)> > Weld<T>::welder = {
-    {"ADDV", T::addv},
-    {"ADDE", T::adde},
-    {"ADDC", T::addc},
-    {"LOOK", T::look},
-    {"FIND", T::find},
-    {"MODC", T::modc}
+template <typename T, typename G> map<string, function<typename Weld<T, G>::Mutation(const Arguments&)>, less<> > Weld<T, G>::mutators = {
+    {"ADDV", Weld<T, G>::bind(G::addv)},
+    {"ADDE", Weld<T, G>::bind(G::adde)},
+    {"ADDC", Weld<T, G>::bind(G::addc)},
+    {"MODC", Weld<T, G>::bind(G::modc)},
+    {"BMOD", Weld<T, G>::bind(G::bmod)},
+    {"TXNS", Weld<T, G>::bind(G::txn)},
+    {"SAVE", Weld<T, G>::bind(G::save)},
+    {"LOAD", Weld<T, G>::bind(G::load)}
+};
+
+template <typename T, typename G> map<string, function<typename Weld<T, G>::Query(const Arguments&)>, less<> > Weld<T, G>::queries = {
+    {"LOOK", [](const Arguments& arguments) -> Query {
+        LookupArgs args = LookupArgs::parse(arguments);
+        return [args](shared_ptr<G> target, shared_ptr<T>) { return G::look(target, args); };
+    }},
+    {"FIND", Weld<T, G>::bind(T::find)},
+    {"PROF", Weld<T, G>::bind(T::prof)},
+    {"MANY", Weld<T, G>::bind(T::many)},
+    {"PSET", Weld<T, G>::bind(T::pset)},
+    {"STAT", [](const Arguments&) -> Query {
+        return [](shared_ptr<G>, shared_ptr<T> solver) { return T::stat(solver); };
+    }}
+};
+
+template <typename T, typename G> map<string, function<typename Weld<T, G>::Encoder(const Arguments&)>, less<> > Weld<T, G>::encoders = {
+    {"FIND", Weld<T, G>::bind(T::find_binary)}
+};
+
+template <typename T, typename G> map<string, function<typename Weld<T, G>::Batch(const Arguments&)>, less<> > Weld<T, G>::batches = {
+    {"BFND", Weld<T, G>::bind(T::template find_batch<Executor>)}
 };